@@ -17,6 +17,26 @@
 #include <world/Object.h>
 #include <world/World.h>
 
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "ai/Bot.h"
+#include "core/Allocations.h"
+#include "core/FixedStep.h"
+#include "core/Game.h"
+#include "core/Profile.h"
+#include "core/Versus.h"
+#include "sim/Dataset.h"
+#include "sim/Drivers.h"
+#include "sim/LiveGame.h"
+#include "sim/ThreadPool.h"
+#include "view/BoardRenderer.h"
+#include "view/TileBatch.h"
+#include "view/VersusRenderer.h"
+
 namespace Assets {
 AssetId nSpriteColorShader;
 void Initialize() {
@@ -26,216 +46,183 @@ void Initialize() {
 } // namespace Assets
 
 // Component used for flashing a single color sprite.
+// A flash is never deleted. It stays invisible until Start is called and
+// returns to being invisible once it has faded out, so the same flashes are
+// used for every cleared row.
 struct Flash {
   float mDuration;
   float mStartTime;
+  bool mRunning;
   void VInit(const World::Object &owner) {
     Comp::Sprite &spriteComp = owner.Get<Comp::Sprite>();
     spriteComp.mShaderId = Assets::nSpriteColorShader;
     Comp::AlphaColor &colorComp = owner.Get<Comp::AlphaColor>();
-    colorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
+    colorComp.mColor = {0.0f, 0.0f, 0.0f, 0.0f};
+    mDuration = 0.5f;
+    mRunning = false;
+  }
+
+  void Start() {
     mStartTime = Temporal::TotalTime();
+    mRunning = true;
   }
 
   void VUpdate(const World::Object &owner) {
-    float timeSince = Temporal::TotalTime() - mStartTime;
-    if (timeSince > mDuration) {
-      owner.Delete();
+    if (!mRunning) {
       return;
     }
     Comp::AlphaColor &colorComp = owner.Get<Comp::AlphaColor>();
+    float timeSince = Temporal::TotalTime() - mStartTime;
     float fade = 1.0f - (timeSince / mDuration);
+    if (timeSince > mDuration) {
+      fade = 0.0f;
+      mRunning = false;
+    }
     for (int i = 0; i < 4; ++i) {
       colorComp.mColor[i] = fade;
     }
   }
 };
 
-enum class Tetrimino { I, L, J, O, S, T, Z, None };
+using Core::Board;
+using Core::Tetrimino;
 
-// These define the cells that are visible.
-#define GRID_HEIGHT 20
-#define GRID_WIDTH 10
+// The workers that the bot spreads its search over.
+Sim::ThreadPool nBotPool;
 
-// In actuallity, the grid is slightly larger than the visible grid. Pieces are
-// spawned into the grid in this invisible region.
-#define FULL_GRID_HEIGHT 22
+// The time from the launch to the first frame, shown with P and written to
+// startup.json with O.
+Core::StartupTimeline nStartup;
 
-struct Cell {
-  Tetrimino mTetriminoType;
-  World::MemberId mMemberId;
+// Every tetrimino that locks is recorded here when the game is run with
+// --dataset. A game that is still running when the window closes is recorded
+// up to that point.
+Sim::DatasetWriter nDataset;
 
-  // This indicates whether a locked tetrimino occupies a cell. A row of locked
-  // cells gets eliminated.
-  bool mLocked;
-};
-
-struct Tetris {
-  // All of the tetrimino shapes are stored here.
-  int mShapes[7][4][4];
+// The game played from the keyboard. Its thread starts once the scene exists
+// and runs until the window closes.
+Sim::LiveGame nLiveGame;
 
-  // The number of invisible rows.
-  int mVisibleRowOffset;
-
-  // The full grid that the game is played on.
-  Cell mGrid[FULL_GRID_HEIGHT][GRID_WIDTH];
-
-  // The queue of upcoming tetriminos.
-  Tetrimino mTetrimoQueue[3];
+// The keys of the keyboard that are held down as game keys.
+Core::Inputs GatherInputs() {
+  Core::Inputs inputs = 0;
+  if (Input::KeyDown(Input::Key::Left)) {
+    inputs |= Core::Key::Left;
+  }
+  if (Input::KeyDown(Input::Key::Right)) {
+    inputs |= Core::Key::Right;
+  }
+  if (Input::KeyDown(Input::Key::Down)) {
+    inputs |= Core::Key::Down;
+  }
+  if (Input::KeyDown(Input::Key::T)) {
+    inputs |= Core::Key::RotateCcw;
+  }
+  if (Input::KeyDown(Input::Key::R)) {
+    inputs |= Core::Key::RotateCw;
+  }
+  if (Input::KeyDown(Input::Key::Space)) {
+    inputs |= Core::Key::HardDrop;
+  }
+  return inputs;
+}
 
-  // The members for the sprites that display the queue.
-  World::MemberId mQueueCellMemberId[3][4][4];
-  // The members for the parents of the queue sprites. This allows us to move
-  // each set of queue sprites as a group.
-  World::MemberId mQueueCellParents[3];
+// The adapter between the game and the engine. The game is stepped by
+// nLiveGame on a thread of its own. Every frame sends it the keys, takes the
+// latest frame it published and reflects the events of its steps into the
+// world.
+struct Tetris {
+  // Key changes are sent with the time they were seen and the simulation
+  // thread splits its steps at them. The engine only reports keys once per
+  // frame, so a change is stamped with the time of the previous poll, the
+  // earliest it could have happened. Times are seconds on the clock of the
+  // game.
+  Core::Inputs mPolledInputs;
+  double mLastPollTime;
+
+  // The time from a key going down to the step that moved, rotated or locked
+  // the active tetrimino because of it.
+  Core::Histogram mInputLatency;
+
+  // Whether the bot plays in place of the keyboard. B toggles it on the
+  // simulation thread and here.
+  bool mBotPlaying;
+
+  // Every tetrimino is graded against the fewest presses its placement
+  // needed. F shows the grades below the rate.
+  static constexpr int nFinesseTextSize = 96;
+  bool mFinesseVisible;
+
+  // The board and queue are drawn as one batch of tiles, which is copied from
+  // the frames the simulation thread publishes.
+  View::TileBatch mTiles;
+  View::BoardRenderer mBoardRenderer;
+
+  // The orthographic camera that the game is rendered with.
+  static constexpr float nCameraHeight = (float)Board::nVisibleHeight + 2.0f;
+  static constexpr float nCameraY = 0.5f;
+
+  // The phases of every step are timed on the simulation thread and drawing is
+  // timed here when the zones are compiled in. P shows the latencies over the
+  // board and O writes them to profile.csv and profile.json.
+  Core::Profiler mProfiler;
+  Core::Profiler mGatheredProfile;
+  bool mProfileVisible;
+
+  // The flashes over cleared rows. A clear starts the flashes that follow the
+  // one started last, which is enough for two clears of four rows to overlap.
+  static constexpr int nFlashCount = 8;
+  World::MemberId mFlashMemberIds[nFlashCount];
+  int mNextFlash;
+
+  // The text shows the latest frame. A running game must not allocate, so the
+  // text is only formatted when the value it shows has changed.
+  unsigned int mShownGamesStarted;
+  bool mShownRunning;
+  int mShownLines;
+  float mShownRate;
+  long long mShownLocks;
+  unsigned long long mShownDroppedEvents;
 
   // All the different members used for displaying text.
+  World::MemberId mProfileTextMemberId;
   World::MemberId mLinesTextMemberId;
   World::MemberId mRateTextMemberId;
+  World::MemberId mFinesseTextMemberId;
   World::MemberId mStartGameTextMemberId;
   World::MemberId mEndGameTextMemberId;
 
-  // Values for specifying where and what the active tetrimino is.
-  Tetrimino mActiveTetrimino;
-  int mShapeRotation;
-  int mActiveX;
-  int mActiveY;
-
-  // Values used for controlling vertical dropping.
-  float mDropRate;
-  float mFastDropRate;
-  float mTimeSinceLastDrop;
-
-  // Values used for controlling horizontal shifting.
-  float mShiftRate;
-  float mTimeSinceLastShift;
-
-  // The number of completed lines.
-  int mLines;
-
-  // Keep track of whether the game is running.
-  bool mRunning;
-
-  void ClearGrid() {
-    for (int i = 0; i < FULL_GRID_HEIGHT; ++i) {
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        Cell &cell = mGrid[i][j];
-        cell.mLocked = false;
-        cell.mTetriminoType = Tetrimino::None;
-      }
-    }
-  }
-
   void VInit(const World::Object &owner) {
-    // Initialize the different Tetrmino shapes.
-    // clang-format off
-    int shapes[7][4][4] = {
-      {{0, 1, 0, 0},
-       {0, 1, 0, 0},
-       {0, 1, 0, 0},
-       {0, 1, 0, 0}},
-
-      {{0, 1, 0, 0},
-       {0, 1, 0, 0},
-       {0, 1, 1, 0},
-       {0, 0, 0, 0}},
-
-      {{0, 0, 1, 0},
-       {0, 0, 1, 0},
-       {0, 1, 1, 0},
-       {0, 0, 0, 0}},
-
-      {{0, 0, 0, 0},
-       {0, 1, 1, 0},
-       {0, 1, 1, 0},
-       {0, 0, 0, 0}},
-
-      {{0, 0, 0, 0},
-       {0, 1, 1, 0},
-       {1, 1, 0, 0},
-       {0, 0, 0, 0}},
-
-      {{0, 0, 0, 0},
-       {0, 1, 0, 0},
-       {1, 1, 1, 0},
-       {0, 0, 0, 0}},
-
-      {{0, 0, 0, 0},
-       {0, 1, 1, 0},
-       {0, 0, 1, 1},
-       {0, 0, 0, 0}}};
-    // clang-format on
-    for (int i = 0; i < 7; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        for (int k = 0; k < 4; ++k) {
-          mShapes[i][j][k] = shapes[i][j][k];
-        }
-      }
-    }
-
-    // Create all of the sprites to represent the grid.
-    mVisibleRowOffset = FULL_GRID_HEIGHT - GRID_HEIGHT;
-    ClearGrid();
-    for (int i = 0; i < GRID_HEIGHT; ++i) {
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        Cell &cell = mGrid[i + mVisibleRowOffset][j];
-        cell.mMemberId = owner.mSpace->CreateMember();
-        World::Object cellObject(owner.mSpace, cell.mMemberId);
-        Comp::Transform &cellTrans = cellObject.Add<Comp::Transform>();
-        Vec3 offset = {-(float)(GRID_WIDTH / 2), (float)(GRID_HEIGHT / 2),
-                       0.0f};
-        Vec3 translation = {(float)j, -(float)i, 0.0f};
-        translation += offset;
-        cellTrans.SetTranslation(translation);
-        cellTrans.SetUniformScale(0.9f);
-
-        Comp::Sprite &cellSprite = cellObject.Add<Comp::Sprite>();
-        cellSprite.mShaderId = Assets::nSpriteColorShader;
-        cellObject.Add<Comp::AlphaColor>();
-      }
-    }
-    UpdateColors(owner);
-
-    // Initialize the tetrimino queue.
-    for (int i = 0; i < 3; ++i) {
-      mTetrimoQueue[i] = Tetrimino(rand() % (int)Tetrimino::None);
-    }
-
-    // Create the sprites that represent the tetrimino queue.
-    for (int i = 0; i < 3; ++i) {
-      mQueueCellParents[i] = owner.mSpace->CreateMember();
-      for (int j = 0; j < 4; ++j) {
-        for (int k = 0; k < 4; ++k) {
-          mQueueCellMemberId[i][j][k] =
-              owner.mSpace->CreateChildMember(mQueueCellParents[i]);
-          Comp::Sprite &sprite =
-              owner.mSpace->Add<Comp::Sprite>(mQueueCellMemberId[i][j][k]);
-          sprite.mShaderId = Assets::nSpriteColorShader;
-          owner.mSpace->Add<Comp::AlphaColor>(mQueueCellMemberId[i][j][k]);
-          Comp::Transform &transform =
-              owner.mSpace->Get<Comp::Transform>(mQueueCellMemberId[i][j][k]);
-          transform.SetTranslation({(float)k, -(float)j, 0.0f});
-          transform.SetUniformScale(0.9f);
-        }
-      }
-    }
-    UpdateQueueColors(owner);
-
-    // Position the queue parents.
-    Comp::Transform &queueParentTrans0 =
-        owner.mSpace->Add<Comp::Transform>(mQueueCellParents[0]);
-    queueParentTrans0.SetTranslation({(float)GRID_WIDTH / 2.0f + 2.0f,
-                                      (float)GRID_HEIGHT / 2.0f - 4.5f, 0.0f});
-    Comp::Transform &queueParentTrans1 =
-        owner.mSpace->Add<Comp::Transform>(mQueueCellParents[1]);
-    queueParentTrans1.SetTranslation({(float)GRID_WIDTH / 2.0f + 2.0f,
-                                      (float)GRID_HEIGHT / 2.0f - 8.5f, 0.0f});
-    queueParentTrans1.SetUniformScale(0.7f);
-    Comp::Transform &queueParentTrans2 =
-        owner.mSpace->Add<Comp::Transform>(mQueueCellParents[2]);
-    queueParentTrans2.SetTranslation({(float)GRID_WIDTH / 2.0f + 2.0f,
-                                      (float)GRID_HEIGHT / 2.0f - 11.5f, 0.0f});
-    queueParentTrans2.SetUniformScale(0.7f);
+    // The bot must choose a placement within a tick, so the search is given
+    // a budget of a millisecond per tetrimino.
+    Ai::BotConfig botConfig;
+    botConfig.SetDefaults();
+    botConfig.mBudgetMs = 1.0f;
+    botConfig.mPool = &nBotPool;
+    nLiveGame.Init(botConfig, nDataset.IsOpen() ? &nDataset : nullptr);
+    mPolledInputs = 0;
+    mLastPollTime = nLiveGame.Now();
+    mInputLatency.Clear();
+    mProfiler.Clear();
+    Core::AttachProfiler(&mProfiler);
+    mProfileVisible = false;
+    mBotPlaying = false;
+    mFinesseVisible = false;
+    mShownGamesStarted = 0;
+    mShownRunning = false;
+    mShownLines = 0;
+    mShownRate = 1.0f;
+    mShownLocks = 0;
+    mShownDroppedEvents = 0;
+    nStartup.Mark(Core::StartupPhase::Rules);
+
+    // Create the batch that represents the grid and the tetrimino queue from
+    // the first frame of the game.
+    nLiveGame.mFrames.Take();
+    mTiles = nLiveGame.mFrames.Front().mTiles;
+    mBoardRenderer.Init();
+    mBoardRenderer.Upload(&mTiles);
+    nStartup.Mark(Core::StartupPhase::Tiles);
 
     // Create the score text.
     mLinesTextMemberId = owner.mSpace->CreateMember();
@@ -246,9 +233,9 @@ struct Tetris {
     linesTextComp.mWidth = 10.0f;
     Comp::Transform &linesTrans =
         owner.mSpace->Get<Comp::Transform>(mLinesTextMemberId);
-    Vec3 translation = {(float)(GRID_WIDTH / 2) + 1.0f +
+    Vec3 translation = {(float)(Board::nWidth / 2) + 1.0f +
                             linesTextComp.mWidth / 2.0f,
-                        (float)(GRID_HEIGHT / 2) - 1.0f, 0.0f};
+                        (float)(Board::nVisibleHeight / 2) - 1.0f, 0.0f};
     linesTrans.SetTranslation(translation);
     Comp::AlphaColor &linesColorComp =
         owner.mSpace->Add<Comp::AlphaColor>(mLinesTextMemberId);
@@ -263,12 +250,32 @@ struct Tetris {
     Comp::Transform &rateTrans =
         owner.mSpace->Get<Comp::Transform>(mRateTextMemberId);
     rateTrans.SetTranslation(
-        {(float)(GRID_WIDTH / 2) + 1.0f + rateTextComp.mWidth / 2.0f,
-         (float)(GRID_HEIGHT / 2) - 3.0f, 0.0f});
+        {(float)(Board::nWidth / 2) + 1.0f + rateTextComp.mWidth / 2.0f,
+         (float)(Board::nVisibleHeight / 2) - 3.0f, 0.0f});
     Comp::AlphaColor &rateColorComp =
         owner.mSpace->Add<Comp::AlphaColor>(mRateTextMemberId);
     rateColorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
 
+    // Create the finesse text below the rate text.
+    mFinesseTextMemberId = owner.mSpace->CreateMember();
+    Comp::Text &finesseTextComp =
+        owner.mSpace->Add<Comp::Text>(mFinesseTextMemberId);
+    // The text changes within steps, so its storage is reserved up front.
+    finesseTextComp.mText.reserve(nFinesseTextSize);
+    finesseTextComp.mText = "Finesse: 0 of 0";
+    finesseTextComp.mAlign = Comp::Text::Alignment::Left;
+    finesseTextComp.mWidth = 10.0f;
+    finesseTextComp.mVisible = false;
+    Comp::Transform &finesseTrans =
+        owner.mSpace->Get<Comp::Transform>(mFinesseTextMemberId);
+    finesseTrans.SetTranslation(
+        {(float)(Board::nWidth / 2) + 1.0f + finesseTextComp.mWidth / 2.0f,
+         (float)(Board::nVisibleHeight / 2) - 5.0f, 0.0f});
+    finesseTrans.SetUniformScale(0.5f);
+    Comp::AlphaColor &finesseColorComp =
+        owner.mSpace->Add<Comp::AlphaColor>(mFinesseTextMemberId);
+    finesseColorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
+
     // Create the start game text.
     mStartGameTextMemberId = owner.mSpace->CreateMember();
     Comp::Text &startGameTextComp =
@@ -299,401 +306,451 @@ struct Tetris {
         owner.mSpace->Add<Comp::AlphaColor>(mEndGameTextMemberId);
     endGameColorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
 
-    mActiveTetrimino = Tetrimino::None;
-
-    mDropRate = 1.0f;
-    mFastDropRate = 20.0f;
-    mTimeSinceLastDrop = 0.0f;
-
-    mShiftRate = 10.0f;
-    mTimeSinceLastShift = 1.0f / mShiftRate;
-
-    mRunning = false;
+    // Create the profile overlay to the left of the grid.
+    mProfileTextMemberId = owner.mSpace->CreateMember();
+    Comp::Text &profileTextComp =
+        owner.mSpace->Add<Comp::Text>(mProfileTextMemberId);
+    profileTextComp.mAlign = Comp::Text::Alignment::Left;
+    profileTextComp.mWidth = 16.0f;
+    profileTextComp.mVisible = false;
+    Comp::Transform &profileTrans =
+        owner.mSpace->Get<Comp::Transform>(mProfileTextMemberId);
+    profileTrans.SetTranslation(
+        {-(float)(Board::nWidth / 2) - 1.0f - profileTextComp.mWidth / 2.0f,
+         (float)(Board::nVisibleHeight / 2) - 1.0f, 0.0f});
+    profileTrans.SetUniformScale(0.5f);
+    Comp::AlphaColor &profileColorComp =
+        owner.mSpace->Add<Comp::AlphaColor>(mProfileTextMemberId);
+    profileColorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Create the flashes that are shown over cleared rows.
+    for (int i = 0; i < nFlashCount; ++i) {
+      mFlashMemberIds[i] = owner.mSpace->CreateMember();
+      owner.mSpace->Add<Flash>(mFlashMemberIds[i]);
+      Comp::Transform &flashTrans =
+          owner.mSpace->Get<Comp::Transform>(mFlashMemberIds[i]);
+      flashTrans.SetScale({(float)Board::nWidth, 1.0f, 1.0f});
+    }
+    mNextFlash = 0;
 
     // Create the camera that the game will be rendered with.
     World::MemberId cameraMemberId = owner.mSpace->CreateMember();
     Comp::Camera &camera = owner.mSpace->Add<Comp::Camera>(cameraMemberId);
     camera.mProjectionType = Comp::Camera::ProjectionType::Orthographic;
-    camera.mHeight = (float)GRID_HEIGHT + 2.0f;
+    camera.mHeight = nCameraHeight;
     Comp::Transform &cameraTrans =
         owner.mSpace->Get<Comp::Transform>(cameraMemberId);
-    cameraTrans.SetTranslation({0.0f, 0.5f, 1.0f});
+    cameraTrans.SetTranslation({0.0f, nCameraY, 1.0f});
     owner.mSpace->mCameraId = cameraMemberId;
+    nStartup.Mark(Core::StartupPhase::Scene);
+    nLiveGame.Start();
   }
 
-  void ClearUnlockedCells() {
-    for (int i = 0; i < FULL_GRID_HEIGHT; ++i) {
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        if (!mGrid[i][j].mLocked) {
-          mGrid[i][j].mTetriminoType = Tetrimino::None;
-        }
-      }
-    }
+  void StartRowFlash(const World::Object &owner, int row) {
+    World::MemberId flashId = mFlashMemberIds[mNextFlash];
+    mNextFlash = (mNextFlash + 1) % nFlashCount;
+    Comp::Transform &flashTrans = owner.mSpace->Get<Comp::Transform>(flashId);
+    float height =
+        (float)Board::nVisibleHeight / 2.0f - (float)(row - Board::nBufferRows);
+    Vec3 translation = {-0.5f, height, 0.5f};
+    flashTrans.SetTranslation(translation);
+    owner.mSpace->Get<Flash>(flashId).Start();
   }
 
-  Vec4 GetTetriminoColor(Tetrimino tetrimino) {
-    switch (tetrimino) {
-    case Tetrimino::I:
-      return {0.0f, 1.0f, 1.0f, 1.0f};
-    case Tetrimino::L:
-      return {1.0f, 0.5f, 0.0f, 1.0f};
-    case Tetrimino::J:
-      return {0.0f, 0.0f, 1.0f, 1.0f};
-    case Tetrimino::O:
-      return {1.0f, 1.0f, 0.0f, 1.0f};
-    case Tetrimino::S:
-      return {0.0f, 1.0f, 0.0f, 1.0f};
-    case Tetrimino::T:
-      return {1.0f, 0.0f, 1.0f, 1.0f};
-    case Tetrimino::Z:
-      return {1.0f, 0.0f, 0.0f, 1.0f};
-    }
-    return {0.5f, 0.5f, 0.5f, 1.0f};
+  void UpdateLinesText(const World::Object &owner, int lines) {
+    if (lines == mShownLines) {
+      return;
+    }
+    mShownLines = lines;
+    char lineText[32];
+    snprintf(lineText, sizeof(lineText), "Lines: %d", mShownLines);
+    Comp::Text &linesTextComp =
+        owner.mSpace->Get<Comp::Text>(mLinesTextMemberId);
+    linesTextComp.mText = lineText;
   }
 
-  void UpdateColors(const World::Object &owner) {
-    for (int i = 0; i < GRID_HEIGHT; ++i) {
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        Cell &cell = mGrid[i + mVisibleRowOffset][j];
-        Comp::AlphaColor &colorComp =
-            owner.mSpace->Get<Comp::AlphaColor>(cell.mMemberId);
-        colorComp.mColor = GetTetriminoColor(cell.mTetriminoType);
-      }
+  void UpdateRateText(const World::Object &owner, float rate) {
+    if (rate == mShownRate) {
+      return;
     }
+    mShownRate = rate;
+    char rateText[32];
+    snprintf(rateText, sizeof(rateText), "Rate: %.1f", mShownRate);
+    Comp::Text &rateTextComp = owner.mSpace->Get<Comp::Text>(mRateTextMemberId);
+    rateTextComp.mText = rateText;
   }
 
-  void UpdateQueueColors(const World::Object &owner) {
-    for (int i = 0; i < 3; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        for (int k = 0; k < 4; ++k) {
-          Comp::AlphaColor &colorComp =
-              owner.mSpace->Get<Comp::AlphaColor>(mQueueCellMemberId[i][j][k]);
-          if (mShapes[(int)mTetrimoQueue[i]][j][k] == 1) {
-            colorComp.mColor = GetTetriminoColor(mTetrimoQueue[i]);
-          } else {
-            colorComp.mColor = GetTetriminoColor(Tetrimino::None);
-          }
-        }
-      }
+  // A fault is a tetrimino that took more presses than its placement needed.
+  // Tetriminos tucked under an overhang are not graded.
+  void UpdateFinesseText(const World::Object &owner,
+                         const Sim::LiveFrame &frame) {
+    long long locks = frame.mGraded + frame.mUngraded;
+    if (locks == mShownLocks) {
+      return;
     }
+    mShownLocks = locks;
+    char finesseText[nFinesseTextSize];
+    int length =
+        snprintf(finesseText, sizeof(finesseText), "Finesse: %lld of %lld\n",
+                 frame.mFaults, frame.mGraded);
+    if (frame.mLastLeast < 0) {
+      snprintf(finesseText + length, sizeof(finesseText) - length,
+               "Last: %d presses, ungraded", frame.mLastPresses);
+    } else {
+      snprintf(finesseText + length, sizeof(finesseText) - length,
+               "Last: %d presses, %d needed", frame.mLastPresses,
+               frame.mLastLeast);
+    }
+    Comp::Text &finesseTextComp =
+        owner.mSpace->Get<Comp::Text>(mFinesseTextMemberId);
+    finesseTextComp.mText = finesseText;
   }
 
-  void CreateRowFlash(const World::Object &owner, int row) {
-    World::MemberId flashId = owner.mSpace->CreateMember();
-    Flash &flashComp = owner.mSpace->Add<Flash>(flashId);
-    flashComp.mDuration = 0.5f;
-    Comp::Transform &flashTrans = owner.mSpace->Get<Comp::Transform>(flashId);
-    float height = (float)GRID_HEIGHT / 2.0f - (float)(row - mVisibleRowOffset);
-    Vec3 translation = {-0.5f, height, 0.5f};
-    flashTrans.SetTranslation(translation);
-    flashTrans.SetScale({(float)GRID_WIDTH, 1.0f, 1.0f});
+  void VUpdate(const World::Object &owner) {
+    unsigned long long allocations = Core::ThreadAllocationCount();
+    if (Input::KeyPressed(Input::Key::B)) {
+      mBotPlaying = !mBotPlaying;
+      nLiveGame.ToggleBot();
+    }
+    if (Input::KeyPressed(Input::Key::F)) {
+      mFinesseVisible = !mFinesseVisible;
+      Comp::Text &finesseTextComp =
+          owner.mSpace->Get<Comp::Text>(mFinesseTextMemberId);
+      finesseTextComp.mVisible = mFinesseVisible;
+    }
+    double now = nLiveGame.Now();
+    Core::Inputs polled = GatherInputs();
+    if (polled != mPolledInputs) {
+      nLiveGame.SetKeys(mLastPollTime, polled);
+    }
+    mPolledInputs = polled;
+    mLastPollTime = now;
+
+    // The frame is taken before the events, so the events of the steps that
+    // led up to a frame are never seen after it.
+    if (nLiveGame.mFrames.Take()) {
+      mTiles.CopyFrom(nLiveGame.mFrames.Front().mTiles);
+    }
+    const Sim::LiveFrame &frame = nLiveGame.mFrames.Front();
+    bool sameGame = frame.mRunning && mShownRunning &&
+                    frame.mGamesStarted == mShownGamesStarted;
+    UpdateText(owner, frame);
+    Core::Events events = TakeEvents(owner);
+    CheckAllocations(sameGame, events,
+                     Core::ThreadAllocationCount() - allocations);
+    UpdateProfile(owner);
   }
 
-  void LockActiveTetrimino(const World::Object &owner, int shape[4][4]) {
-    // Lock the cells that the active tetrimino occupies.
-    for (int i = 0; i < 4; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        Cell &cell = mGrid[mActiveY + i][mActiveX + j];
-        if (shape[i][j] == 1) {
-          // The game is over if part of the shape is above the visible grid.
-          if (mActiveY + i < mVisibleRowOffset) {
-            EndGame(owner);
-          }
-          cell.mTetriminoType = mActiveTetrimino;
-          cell.mLocked = true;
-        }
-      }
-    }
-
-    // Delete complete rows.
-    int collapseDistance = 0;
-    for (int i = FULL_GRID_HEIGHT - 1; i >= 0; --i) {
-      bool deleteRow = true;
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        if (mGrid[i][j].mLocked != true) {
-          deleteRow = false;
-          break;
-        }
-      }
-      if (deleteRow) {
-        CreateRowFlash(owner, i);
-        ++collapseDistance;
-        continue;
-      }
-      if (collapseDistance == 0) {
-        continue;
-      }
-      for (int j = 0; j < GRID_WIDTH; ++j) {
-        Cell &toCell = mGrid[i + collapseDistance][j];
-        Cell &fromCell = mGrid[i][j];
-        toCell.mLocked = fromCell.mLocked;
-        toCell.mTetriminoType = fromCell.mTetriminoType;
-        fromCell.mLocked = false;
-        fromCell.mTetriminoType = Tetrimino::None;
-      }
-    }
-    mActiveTetrimino = Tetrimino::None;
-
-    // Update the score and increase the drop rate if a threshold is passed.
-    if (collapseDistance == 0) {
-      return;
-    }
-    bool increaseRate = false;
-    for (int i = 1; i <= collapseDistance; ++i) {
-      if ((mLines + i) % 10 == 0 && mLines > 0) {
-        mDropRate += 1.0f;
-        UpdateRateText(owner);
-      }
+  // The start text is shown until the first game starts and the end text
+  // while no game runs after that.
+  void UpdateText(const World::Object &owner, const Sim::LiveFrame &frame) {
+    if (frame.mGamesStarted != mShownGamesStarted ||
+        frame.mRunning != mShownRunning) {
+      mShownGamesStarted = frame.mGamesStarted;
+      mShownRunning = frame.mRunning;
+      Comp::Text &startGameTextComp =
+          owner.mSpace->Get<Comp::Text>(mStartGameTextMemberId);
+      startGameTextComp.mVisible = mShownGamesStarted == 0;
+      Comp::Text &endGameTextComp =
+          owner.mSpace->Get<Comp::Text>(mEndGameTextMemberId);
+      endGameTextComp.mVisible = mShownGamesStarted > 0 && !mShownRunning;
+    }
+    UpdateLinesText(owner, frame.mLines);
+    UpdateRateText(owner, frame.mDropRate);
+    UpdateFinesseText(owner, frame);
+    if (frame.mDroppedEvents != mShownDroppedEvents) {
+      char error[64];
+      snprintf(error, sizeof(error), "%llu events of the game were dropped.",
+               frame.mDroppedEvents - mShownDroppedEvents);
+      LogError(error);
+      mShownDroppedEvents = frame.mDroppedEvents;
     }
-    mLines += collapseDistance;
-    UpdateLinesText(owner);
   }
 
-  void GetRotatedShape(int shape[4][4], Tetrimino tetrimino, int amount) {
-    for (int i = 0; i < 4; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        shape[i][j] = mShapes[(int)tetrimino][i][j];
+  // Start the effects of the events of the steps since the previous frame and
+  // return the game events among them.
+  Core::Events TakeEvents(const World::Object &owner) {
+    Core::Events events = 0;
+    Sim::LiveEvent event;
+    while (nLiveGame.mEvents.Pop(&event)) {
+      if (event.mLatencyNs >= 0) {
+        mInputLatency.Add((unsigned long long)event.mLatencyNs);
       }
-    }
-    for (int i = 0; i < amount; ++i) {
-      int newShape[4][4];
-      for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-          newShape[i][j] = shape[j][3 - i];
+      switch (event.mType) {
+      case Sim::LiveEventType::Started:
+        events |= Core::Event::Started;
+        break;
+      case Sim::LiveEventType::RowsCleared:
+        for (int i = 0; i < event.mClearedRowCount; ++i) {
+          StartRowFlash(owner, event.mClearedRows[i]);
         }
+        break;
+      case Sim::LiveEventType::Ended:
+        events |= Core::Event::Ended;
+        break;
+      case Sim::LiveEventType::ReplayFailed: {
+        std::string error = "Failed to open " + nLiveGame.mReplayDirectory +
+                            "/" + std::to_string(event.mSeed) + ".ttrp.";
+        LogError(error.c_str());
+        break;
       }
-      for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-          shape[i][j] = newShape[i][j];
-        }
+      default:
+        break;
       }
     }
+    return events;
   }
 
-  bool CanMoveShape(int shape[4][4], int x, int y) {
-    int newX = mActiveX + x;
-    int newY = mActiveY + y;
-    for (int i = 0; i < 4; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        if (shape[i][j] != 1) {
-          continue;
-        }
-        // Is it within the grid bounds?
-        if (newX + j >= GRID_WIDTH || newX + j < 0) {
-          return false;
-        }
-        if (newY + i >= FULL_GRID_HEIGHT) {
-          return false;
-        }
-        // Does it collide with an already locked cell?
-        Cell &cell = mGrid[newY + i][newX + j];
-        if (cell.mLocked) {
-          return false;
-        }
-      }
+  // Only frames in the middle of a game that is played from the keyboard are
+  // expected to be free of allocations. Presentation counts the allocations
+  // of its own part of the frame, from taking the frame to starting the
+  // effects of the events, and the simulation thread counts those of its
+  // ticks. The rest of the engine's frame is not checked.
+  void CheckAllocations(bool sameGame, Core::Events events,
+                        unsigned long long allocations) {
+    if (!Core::nCountAllocations) {
+      return;
     }
-    return true;
+    const Sim::LiveFrame &frame = nLiveGame.mFrames.Front();
+    bool quiet = sameGame && !mBotPlaying &&
+                 !(events & (Core::Event::Started | Core::Event::Ended));
+    LogAbortIf(quiet && allocations > 0,
+               "Presenting a frame of a running game allocated.");
+    LogAbortIf(frame.mQuietAllocations > 0,
+               "A tick of a running game allocated.");
   }
 
-  void HandleRotation(int shape[4][4]) {
-    // Update the rotation value depending on input.
-    int oldRotation = mShapeRotation;
-    int newRotation = mShapeRotation;
-    if (Input::KeyPressed(Input::Key::T)) {
-      newRotation++;
-      if (newRotation == 4) {
-        newRotation = 0;
-      }
-    }
-    if (Input::KeyPressed(Input::Key::R)) {
-      newRotation--;
-      if (newRotation == -1) {
-        newRotation = 3;
-      }
-    }
-    mShapeRotation = newRotation;
-
-    // Check that the new rotation is possible. If it isn't, see if the shape
-    // fits after being kicked to an orthogonally adjacent position and cancel
-    // the rotation if it doesn't.
-    GetRotatedShape(shape, mActiveTetrimino, mShapeRotation);
-    if (newRotation != oldRotation && !CanMoveShape(shape, 0, 0)) {
-      if (CanMoveShape(shape, 1, 0)) {
-        mActiveX++;
-      } else if (CanMoveShape(shape, 0, 1)) {
-        mActiveY++;
-      } else if (CanMoveShape(shape, -1, 0)) {
-        mActiveX--;
-      } else if (CanMoveShape(shape, 0, -1)) {
-        mActiveY--;
-      } else {
-        mShapeRotation = oldRotation;
-        GetRotatedShape(shape, mActiveTetrimino, mShapeRotation);
-      }
-    }
+  // The zones of the simulation thread along with the zones recorded here.
+  void GatherProfile() {
+    nLiveGame.mProfiles.Take();
+    mGatheredProfile = nLiveGame.mProfiles.Front();
+    const int render = (int)Core::Zone::Render;
+    mGatheredProfile.mHistograms[render] = mProfiler.mHistograms[render];
   }
 
-  void HandleHorizontalShift(int shape[4][4]) {
-    // Determine whether a shift is ready depending on the shift rate.
-    float shiftTimeGap = 1.0f / mShiftRate;
-    if (Input::KeyDown(Input::Key::Left) || Input::KeyDown(Input::Key::Right)) {
-      mTimeSinceLastShift += Temporal::DeltaTime();
-    }
-    bool shiftBereit = mTimeSinceLastShift >= shiftTimeGap;
-
-    // Perform shifts if they are possible depending on input.
-    if (Input::KeyDown(Input::Key::Left) && shiftBereit) {
-      bool canMove = CanMoveShape(shape, -1, 0);
-      if (canMove) {
-        mActiveX--;
-      }
-      mTimeSinceLastShift -= shiftTimeGap;
+  void UpdateProfile(const World::Object &owner) {
+    if (Input::KeyPressed(Input::Key::O)) {
+      DumpProfile();
     }
-    if (Input::KeyDown(Input::Key::Right) && shiftBereit) {
-      bool canMove = CanMoveShape(shape, 1, 0);
-      if (canMove) {
-        mActiveX++;
-      }
-      mTimeSinceLastShift -= shiftTimeGap;
+    Comp::Text &profileTextComp =
+        owner.mSpace->Get<Comp::Text>(mProfileTextMemberId);
+    if (Input::KeyPressed(Input::Key::P)) {
+      mProfileVisible = !mProfileVisible;
+      profileTextComp.mVisible = mProfileVisible;
     }
-
-    // Reset the time since last shift so that a shift instantly happens when
-    // the left or right arrow is pressed again.
-    if (Input::KeyReleased(Input::Key::Right) ||
-        Input::KeyReleased(Input::Key::Left)) {
-      mTimeSinceLastShift = shiftTimeGap;
+    if (!mProfileVisible) {
+      return;
     }
+    // Input latency and startup are measured whether or not the zones are
+    // compiled in.
+    char summary[2048];
+    int length = 0;
+    if (Core::nProfileEnabled) {
+      GatherProfile();
+      length = mGatheredProfile.Summarize(summary, sizeof(summary));
+    } else {
+      length = snprintf(summary, sizeof(summary), "%s\n",
+                        "Profiling is compiled out. Configure with "
+                        "TETRIS_PROFILE=ON.");
+    }
+    length += snprintf(summary + length, sizeof(summary) - length,
+                       "%-22s %8llu %8.1f %8.1f %8.1f\n", "input latency (ms)",
+                       mInputLatency.mCount,
+                       mInputLatency.Percentile(50.0) / 1e6,
+                       mInputLatency.Percentile(99.0) / 1e6,
+                       mInputLatency.mMax / 1e6);
+    if (length < (int)sizeof(summary)) {
+      nStartup.Summarize(summary + length, sizeof(summary) - length);
+    }
+    profileTextComp.mText = summary;
   }
 
-  void HandleDrop(const World::Object &owner, int shape[4][4]) {
-    float dropRate = mDropRate;
-    if (Input::KeyDown(Input::Key::Down)) {
-      dropRate = mFastDropRate;
-    }
-    float dropTimeGap = 1.0f / dropRate;
-    mTimeSinceLastDrop += Temporal::DeltaTime();
-    if (mTimeSinceLastDrop > dropTimeGap) {
-      bool canDrop = CanMoveShape(shape, 0, 1);
-      if (!canDrop) {
-        LockActiveTetrimino(owner, shape);
-      } else {
-        mActiveY++;
-      }
-      while (mTimeSinceLastDrop > dropTimeGap) {
-        mTimeSinceLastDrop -= dropTimeGap;
-      }
+  void DumpProfile() {
+    GatherProfile();
+    FILE *csvFile = fopen("profile.csv", "w");
+    if (csvFile == nullptr) {
+      LogError("Failed to open profile.csv.");
+    } else {
+      mGatheredProfile.WriteCsv(csvFile);
+      fclose(csvFile);
+    }
+    FILE *jsonFile = fopen("profile.json", "w");
+    if (jsonFile == nullptr) {
+      LogError("Failed to open profile.json.");
+    } else {
+      mGatheredProfile.WriteJson(jsonFile);
+      fclose(jsonFile);
+    }
+    FILE *startupFile = fopen("startup.json", "w");
+    if (startupFile == nullptr) {
+      LogError("Failed to open startup.json.");
+    } else {
+      nStartup.WriteJson(startupFile);
+      fclose(startupFile);
     }
   }
 
-  void EndGame(const World::Object &owner) {
-    Comp::Text &endGameTextComp =
-        owner.mSpace->Get<Comp::Text>(mEndGameTextMemberId);
-    endGameTextComp.mVisible = true;
-    mRunning = false;
+  void VRender(const World::Object &owner) {
+    PROFILE_ZONE(Core::Zone::Render);
+    // Draw the active tetrimino between its last two poses by how far the
+    // frame is past the end of the most recent tick.
+    const Sim::LiveFrame &frame = nLiveGame.mFrames.Front();
+    float alpha = (float)((nLiveGame.Now() - frame.mTickEnd) / frame.mTickTime);
+    alpha = alpha < 0.0f ? 0.0f : (alpha < 1.0f ? alpha : 1.0f);
+    View::ActiveCells activeCells;
+    View::BlendActive(frame.mPreviousPose, frame.mPose, alpha, &activeCells);
+    mBoardRenderer.Upload(&mTiles);
+    mBoardRenderer.Draw(nCameraHeight, 0.0f, nCameraY, activeCells);
+    nStartup.Mark(Core::StartupPhase::FirstFrame);
   }
+};
 
-  void SpawnTetrimino(const World::Object &owner) {
-    mShapeRotation = 0;
-    mActiveTetrimino = mTetrimoQueue[0];
-    mActiveX = GRID_WIDTH / 2 - 2;
-    mActiveY = 0;
-
-    // Handle changes to the tetrimino queue.
-    for (int i = 1; i < 3; ++i) {
-      mTetrimoQueue[i - 1] = mTetrimoQueue[i];
-    }
-    srand((unsigned int)Temporal::TotalTime());
-    mTetrimoQueue[2] = Tetrimino(rand() % (int)Tetrimino::None);
-    UpdateQueueColors(owner);
+// Set with --versus <players>. A versus match of that many players is played
+// in place of the single game when it is set.
+int nVersusPlayers = 0;
+
+// A match between many boards where the keyboard plays the first board and
+// random drivers play the others. Down starts a match when none is running.
+struct VersusMode {
+  Core::Versus mVersus;
+  Core::FixedStep mClock;
+  Sim::RandomDriver mDrivers[Core::Versus::nMaxPlayers];
+  Core::Inputs mInputs[Core::Versus::nMaxPlayers];
+  Core::Inputs mLatchedInputs;
+  bool mStartRequested;
+
+  // Every board is drawn from one plane of cells. The layout is fit to a
+  // window of about 16:9.
+  static constexpr float nAspect = 16.0f / 9.0f;
+  View::VersusBatch mBatch;
+  View::VersusRenderer mRenderer;
+  View::VersusLayout mLayout;
+  float mCameraHeight;
+
+  World::MemberId mStatusTextMemberId;
+  int mShownAlive;
 
-    // The game is over if the tetrimino spawns on any locked cells.
-    for (int i = 0; i < 4; ++i) {
-      for (int j = 0; j < 4; ++j) {
-        const Cell &cell = mGrid[mActiveY + i][mActiveX + j];
-        if (mShapes[(int)mActiveTetrimino][i][j] == 1 && cell.mLocked) {
-          EndGame(owner);
-        }
-      }
-    }
+  void VInit(const World::Object &owner) {
+    mVersus.Init(nVersusPlayers, std::random_device()());
+    mClock.Init(1.0f / (float)DEFAULT_TICK_RATE, Sim::LiveGame::nMaxCatchUp);
+    mLatchedInputs = 0;
+    mStartRequested = false;
+    mShownAlive = 0;
+    nStartup.Mark(Core::StartupPhase::Rules);
+
+    mBatch.Build(&mVersus);
+    mRenderer.Init();
+    mRenderer.Upload(&mBatch);
+    nStartup.Mark(Core::StartupPhase::Tiles);
+    mLayout.Fit(mVersus.mPlayerCount, nAspect);
+    float fitHeight = mLayout.mWidth / nAspect;
+    mCameraHeight =
+        (fitHeight > mLayout.mHeight ? fitHeight : mLayout.mHeight) + 4.0f;
+
+    // Create the status text above the boards.
+    mStatusTextMemberId = owner.mSpace->CreateMember();
+    Comp::Text &statusTextComp =
+        owner.mSpace->Add<Comp::Text>(mStatusTextMemberId);
+    statusTextComp.mAlign = Comp::Text::Alignment::Center;
+    statusTextComp.mText = "Press the down arrow to play.";
+    Comp::Transform &statusTrans =
+        owner.mSpace->Get<Comp::Transform>(mStatusTextMemberId);
+    statusTrans.SetTranslation({0.0f, mLayout.mHeight / 2.0f + 1.5f, 0.0f});
+    statusTrans.SetUniformScale(mCameraHeight / 24.0f);
+    Comp::AlphaColor &statusColorComp =
+        owner.mSpace->Add<Comp::AlphaColor>(mStatusTextMemberId);
+    statusColorComp.mColor = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Create the camera that the boards will be rendered with.
+    World::MemberId cameraMemberId = owner.mSpace->CreateMember();
+    Comp::Camera &camera = owner.mSpace->Add<Comp::Camera>(cameraMemberId);
+    camera.mProjectionType = Comp::Camera::ProjectionType::Orthographic;
+    camera.mHeight = mCameraHeight;
+    Comp::Transform &cameraTrans =
+        owner.mSpace->Get<Comp::Transform>(cameraMemberId);
+    cameraTrans.SetTranslation({0.0f, 1.0f, 1.0f});
+    owner.mSpace->mCameraId = cameraMemberId;
+    nStartup.Mark(Core::StartupPhase::Scene);
   }
 
-  void UpdateLinesText(const World::Object &owner) {
-    Comp::Text &linesTextComp =
-        owner.mSpace->Get<Comp::Text>(mLinesTextMemberId);
-    std::stringstream lineText;
-    lineText << "Lines: " << mLines;
-    linesTextComp.mText = lineText.str();
+  void StartMatch() {
+    std::random_device device;
+    unsigned long long seed = ((unsigned long long)device() << 32) | device();
+    mVersus.Init(mVersus.mPlayerCount, seed);
+    for (int p = 0; p < mVersus.mPlayerCount; ++p) {
+      mDrivers[p].Init((unsigned int)(seed >> 32) + (unsigned int)p);
+    }
+    mVersus.Start();
+    mBatch.Build(&mVersus);
   }
 
-  void UpdateRateText(const World::Object &owner) {
-    Comp::Text &rateTextComp = owner.mSpace->Get<Comp::Text>(mRateTextMemberId);
-    std::stringstream rateText;
-    rateText << "Rate: " << mDropRate;
-    rateTextComp.mText = rateText.str();
+  void UpdateStatusText(const World::Object &owner) {
+    Comp::Text &statusTextComp =
+        owner.mSpace->Get<Comp::Text>(mStatusTextMemberId);
+    char statusText[96];
+    if (!mVersus.mAlive[0]) {
+      snprintf(statusText, sizeof(statusText),
+               "You finished in place %d of %d.%s", mVersus.mPlace[0],
+               mVersus.mPlayerCount,
+               mVersus.mRunning ? "" : " Press the down arrow to play.");
+    } else if (mVersus.mRunning) {
+      snprintf(statusText, sizeof(statusText), "%d of %d players left.",
+               mVersus.mAliveCount, mVersus.mPlayerCount);
+    } else {
+      snprintf(statusText, sizeof(statusText),
+               "You won! Press the down arrow to play.");
+    }
+    statusTextComp.mText = statusText;
   }
 
-  void StartGame(const World::Object &owner) {
-    // Hide the start and end game text elements.
-    Comp::Text &startGameTextComp =
-        owner.mSpace->Get<Comp::Text>(mStartGameTextMemberId);
-    startGameTextComp.mVisible = false;
-    Comp::Text &endGameTextComp =
-        owner.mSpace->Get<Comp::Text>(mEndGameTextMemberId);
-    endGameTextComp.mVisible = false;
-
-    ClearGrid();
-    mLines = 0;
-    UpdateLinesText(owner);
-    mDropRate = 1.0f;
-    UpdateRateText(owner);
-    mRunning = true;
+  void VUpdate(const World::Object &owner) {
+    mLatchedInputs |= GatherInputs();
+    mStartRequested = mStartRequested || Input::KeyPressed(Input::Key::Down);
+    int ticks = mClock.Advance(Temporal::DeltaTime());
+    for (int i = 0; i < ticks; ++i) {
+      Tick(owner);
+    }
+    mBatch.Update(&mVersus);
   }
 
-  void VUpdate(const World::Object &owner) {
-    if (!mRunning) {
-      if (Input::KeyPressed(Input::Key::Down)) {
-        StartGame(owner);
+  void Tick(const World::Object &owner) {
+    bool startPressed = mStartRequested;
+    mInputs[0] = mLatchedInputs;
+    mLatchedInputs = GatherInputs();
+    mStartRequested = false;
+    if (!mVersus.mRunning) {
+      if (startPressed) {
+        StartMatch();
+        mShownAlive = 0;
       }
       return;
     }
 
-    ClearUnlockedCells();
-
-    if (mActiveTetrimino == Tetrimino::None) {
-      SpawnTetrimino(owner);
+    for (int p = 1; p < mVersus.mPlayerCount; ++p) {
+      mInputs[p] = mDrivers[p].NextInputs();
     }
-
-    int shape[4][4];
-    HandleRotation(shape);
-    HandleHorizontalShift(shape);
-    HandleDrop(owner, shape);
-
-    // Color in the cells of the active tetrimino type. We need to check that
-    // the active tetrimino isn't set to None because it will change to None
-    // when a piece is locked.
-    if (mActiveTetrimino != Tetrimino::None) {
-      for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-          int cellY = mActiveY + i;
-          int cellX = mActiveX + j;
-          Cell &cell = mGrid[cellY][cellX];
-          if (shape[i][j] == 1) {
-            cell.mTetriminoType = mActiveTetrimino;
-          }
-        }
-      }
+    mVersus.Step(mInputs, mClock.mTickTime);
+    if (mVersus.mAliveCount != mShownAlive || !mVersus.mRunning) {
+      mShownAlive = mVersus.mAliveCount;
+      UpdateStatusText(owner);
     }
+  }
 
-    UpdateColors(owner);
+  void VRender(const World::Object &owner) {
+    mRenderer.Upload(&mBatch);
+    mRenderer.Draw(mCameraHeight, 0.0f, 1.0f, mLayout, mVersus.mPlayerCount);
+    nStartup.Mark(Core::StartupPhase::FirstFrame);
   }
 };
 
 void CustomRegistrar() {
   Registrar::Register<Tetris>();
+  Registrar::Register<VersusMode>();
   Registrar::Register<Flash, Comp::Sprite, Comp::AlphaColor>();
 }
 
 int WinMain(void) {
+  nStartup.Start();
   Registrar::nRegisterCustomTypes = CustomRegistrar;
   Result result = VarkorInit(__argc, __argv, "Tetris", PROJECT_DIRECTORY);
   LogAbortIf(!result.Success(), result.mError.c_str());
@@ -703,9 +760,33 @@ int WinMain(void) {
   World::nPause = false;
   Assets::Initialize();
   World::SpaceIt spaceIt = World::CreateTopSpace();
+  for (int i = 1; i + 1 < __argc; ++i) {
+    if (strcmp(__argv[i], "--versus") == 0) {
+      nVersusPlayers = atoi(__argv[i + 1]);
+    }
+    if (strcmp(__argv[i], "--dataset") == 0) {
+      // A single game fills one chunk while the other is written.
+      std::string error;
+      if (!nDataset.Open(__argv[i + 1], DEFAULT_PREVIEW_LENGTH, 2, &error)) {
+        LogError(error.c_str());
+      }
+    }
+  }
+  nStartup.Mark(Core::StartupPhase::Engine);
   World::MemberId tetrisMember = spaceIt->CreateMember();
-  spaceIt->Add<Tetris>(tetrisMember);
+  if (nVersusPlayers > 0) {
+    spaceIt->Add<VersusMode>(tetrisMember);
+  } else {
+    spaceIt->Add<Tetris>(tetrisMember);
+  }
 
+  nBotPool.Init();
   VarkorRun();
+  nLiveGame.Purge();
   VarkorPurge();
+  nBotPool.Purge();
+  std::string error;
+  if (!nDataset.Close(&error)) {
+    LogError(error.c_str());
+  }
 }
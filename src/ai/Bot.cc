@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "ai/Bot.h"
+#include "ai/FeatureKernel.h"
+#include "sim/ThreadPool.h"
+
+namespace Ai {
+
+void BotConfig::SetDefaults() {
+  mBeamWidth = 8;
+  mDepth = 3;
+  mBudgetMs = 0.0f;
+  mWeights.SetDefaults();
+  mPool = nullptr;
+}
+
+// A board in the beam. The reward is the part of the score that comes from
+// the rows cleared along the way and the value adds the score of the board.
+struct BeamNode {
+  Core::Board mBoard;
+  float mReward;
+  float mValue;
+  PieceState mFirst;
+};
+
+void Expand(const BeamNode &node, Core::Tetrimino tetrimino, PieceState start,
+            bool first, const Weights &weights,
+            std::vector<BeamNode> *children) {
+  // Every worker keeps its own search and batch since they are too large for
+  // the stack and the batch keeps its allocation between expansions.
+  thread_local MoveSearch search;
+  thread_local BoardBatch batch;
+  thread_local std::vector<Features> features;
+  children->clear();
+  if (!search.Run(node.mBoard, tetrimino, start)) {
+    return;
+  }
+  PieceState placements[256];
+  int placementCount = search.Placements(placements, 256);
+  batch.Clear();
+  for (int i = 0; i < placementCount; ++i) {
+    // Skip placements that end the game by locking above the visible grid.
+    PieceState placement = placements[i];
+    const Core::Shape &shape = Core::GetShape(tetrimino, placement.mRotation);
+    if (placement.mY + shape.mMinRow < Core::Board::nBufferRows) {
+      continue;
+    }
+    BeamNode child;
+    child.mBoard = node.mBoard;
+    child.mBoard.Lock(shape, placement.mX, placement.mY, tetrimino);
+    int clearedRows[4];
+    int lines = child.mBoard.ClearFullRows(clearedRows);
+    child.mReward = node.mReward + weights.mLines * (float)lines;
+    child.mFirst = first ? placement : node.mFirst;
+    children->push_back(child);
+    batch.Add(child.mBoard, 0);
+  }
+
+  // The boards are measured together once every child exists.
+  features.resize(batch.mCount);
+  ComputeFeatures(batch, features.data());
+  for (int i = 0; i < batch.mCount; ++i) {
+    BeamNode &child = (*children)[i];
+    child.mValue = child.mReward + weights.Score(features[i]);
+  }
+}
+
+bool ChooseTarget(
+    const Core::Game &game, const BotConfig &config, PieceState *target) {
+  auto start = std::chrono::steady_clock::now();
+
+  // Gather the tetriminos the search places and where the first one starts.
+  Core::Tetrimino tetriminos[1 + Core::PieceQueue::nCapacity];
+  int tetriminoCount = 0;
+  PieceState firstState;
+  int previewStart = 0;
+  if (game.mActiveTetrimino != Core::Tetrimino::None) {
+    tetriminos[tetriminoCount++] = game.mActiveTetrimino;
+    firstState.mX = (signed char)game.mActiveX;
+    firstState.mY = (signed char)game.mActiveY;
+    firstState.mRotation = (signed char)game.mShapeRotation;
+  } else {
+    tetriminos[tetriminoCount++] = game.Preview(0);
+    firstState = SpawnState();
+    previewStart = 1;
+  }
+  for (int i = previewStart;
+       i < game.mPreviewLength && tetriminoCount < config.mDepth; ++i) {
+    tetriminos[tetriminoCount++] = game.Preview(i);
+  }
+
+  std::vector<BeamNode> beam(1);
+  beam[0].mBoard = game.mBoard;
+  beam[0].mReward = 0.0f;
+  beam[0].mValue = 0.0f;
+  std::vector<std::vector<BeamNode>> children;
+  std::vector<BeamNode> next;
+  bool placed = false;
+  float levelMs = 0.0f;
+  size_t levelNodes = 1;
+  for (int level = 0; level < tetriminoCount; ++level) {
+    // Only start a level when the time each board took during the previous
+    // level says that it will finish within the budget.
+    auto levelStart = std::chrono::steady_clock::now();
+    if (config.mBudgetMs > 0.0f && level > 0) {
+      std::chrono::duration<float, std::milli> elapsed = levelStart - start;
+      float expectedMs = levelMs / (float)levelNodes * (float)beam.size();
+      if (elapsed.count() + expectedMs > config.mBudgetMs) {
+        break;
+      }
+    }
+    levelNodes = beam.size();
+
+    Core::Tetrimino tetrimino = tetriminos[level];
+    PieceState startState = level == 0 ? firstState : SpawnState();
+    bool first = level == 0;
+    children.resize(beam.size());
+    if (config.mPool != nullptr && beam.size() > 1) {
+      for (size_t i = 0; i < beam.size(); ++i) {
+        const BeamNode *node = &beam[i];
+        std::vector<BeamNode> *nodeChildren = &children[i];
+        const Weights *weights = &config.mWeights;
+        config.mPool->Submit([=]() {
+          Expand(*node, tetrimino, startState, first, *weights, nodeChildren);
+        });
+      }
+      config.mPool->Wait();
+    } else {
+      for (size_t i = 0; i < beam.size(); ++i) {
+        Expand(beam[i], tetrimino, startState, first, config.mWeights,
+               &children[i]);
+      }
+    }
+
+    // Merging in the order of the beam keeps the result independent of the
+    // order that the workers finish in.
+    next.clear();
+    for (size_t i = 0; i < beam.size(); ++i) {
+      next.insert(next.end(), children[i].begin(), children[i].end());
+    }
+    if (next.empty()) {
+      break;
+    }
+    placed = true;
+    std::stable_sort(
+        next.begin(), next.end(), [](const BeamNode &a, const BeamNode &b) {
+          return a.mValue > b.mValue;
+        });
+    if ((int)next.size() > config.mBeamWidth) {
+      next.resize(config.mBeamWidth);
+    }
+    beam.swap(next);
+    std::chrono::duration<float, std::milli> levelTime =
+        std::chrono::steady_clock::now() - levelStart;
+    levelMs = levelTime.count();
+  }
+
+  if (!placed) {
+    return false;
+  }
+  *target = beam[0].mFirst;
+  return true;
+}
+
+void BotDriver::Init(const BotConfig &config) {
+  mConfig = config;
+  mHasTarget = false;
+  mPathLength = -1;
+  mPathIndex = 0;
+  mLastInputs = 0;
+}
+
+Core::Inputs BotDriver::NextInputs(const Core::Game &game) {
+  if (!game.mRunning ||
+      (game.mEvents & (Core::Event::Started | Core::Event::Locked))) {
+    mHasTarget = false;
+  }
+  if (!game.mRunning) {
+    mLastInputs = 0;
+    return 0;
+  }
+
+  // Find the tetrimino that the next step moves. A tetrimino that has not
+  // spawned yet spawns before the keys are handled.
+  Core::Tetrimino tetrimino;
+  PieceState current;
+  if (game.mActiveTetrimino == Core::Tetrimino::None) {
+    tetrimino = game.Preview(0);
+    current = SpawnState();
+  } else {
+    tetrimino = game.mActiveTetrimino;
+    current.mX = (signed char)game.mActiveX;
+    current.mY = (signed char)game.mActiveY;
+    current.mRotation = (signed char)game.mShapeRotation;
+  }
+
+  if (!mHasTarget) {
+    if (!ChooseTarget(game, mConfig, &mTarget)) {
+      mLastInputs = Core::Key::Down;
+      return mLastInputs;
+    }
+    mHasTarget = true;
+    mPathLength = -1;
+  }
+
+  // Find where the tetrimino is along the path. Gravity or a move that did not
+  // happen as expected can take the tetrimino off the path, so a new path is
+  // found from where it is. If the target can no longer be reached, a new
+  // target is chosen.
+  int at = -1;
+  for (int i = mPathIndex; i <= mPathLength && at < 0; ++i) {
+    if (mPathStates[i] == current) {
+      at = i;
+    }
+  }
+  if (at < 0) {
+    if (!FindPath(game, tetrimino, current)) {
+      if (!ChooseTarget(game, mConfig, &mTarget) ||
+          !FindPath(game, tetrimino, current)) {
+        mLastInputs = Core::Key::Down;
+        return mLastInputs;
+      }
+    }
+    at = 0;
+  }
+  mPathIndex = at;
+
+  Core::Inputs inputs;
+  const Core::Inputs tapKeys = Core::Key::Left | Core::Key::Right |
+                               Core::Key::RotateCcw | Core::Key::RotateCw;
+  if (mPathIndex == mPathLength) {
+    inputs = Core::Key::Down;
+  } else if (mPath[mPathIndex] == Move::Down) {
+    inputs = Core::Key::Down;
+  } else if (mLastInputs & tapKeys) {
+    // Release the key so the next tap is seen as a press.
+    inputs = 0;
+  } else {
+    switch (mPath[mPathIndex]) {
+    case Move::Left:
+      inputs = Core::Key::Left;
+      break;
+    case Move::Right:
+      inputs = Core::Key::Right;
+      break;
+    case Move::RotateCcw:
+      inputs = Core::Key::RotateCcw;
+      break;
+    default:
+      inputs = Core::Key::RotateCw;
+      break;
+    }
+  }
+  mLastInputs = inputs;
+  return inputs;
+}
+
+bool BotDriver::FindPath(
+    const Core::Game &game, Core::Tetrimino tetrimino, PieceState start) {
+  mPathLength = -1;
+  mPathIndex = 0;
+  if (!mSearch.Run(game.mBoard, tetrimino, start)) {
+    return false;
+  }
+  int length = mSearch.Path(mTarget, mPath, nMaxPathLength);
+  if (length < 0) {
+    return false;
+  }
+  mPathStates[0] = start;
+  for (int i = 0; i < length; ++i) {
+    mSearch.TryMove(mPathStates[i], mPath[i], &mPathStates[i + 1]);
+  }
+  mPathLength = length;
+  return true;
+}
+
+} // namespace Ai
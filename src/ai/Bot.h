@@ -0,0 +1,70 @@
+#ifndef ai_Bot_h
+#define ai_Bot_h
+
+#include "ai/Evaluate.h"
+#include "ai/Placement.h"
+#include "core/Game.h"
+
+namespace Sim {
+struct ThreadPool;
+}
+
+// A bot that plays the game through the same keys a player uses. It chooses
+// where every tetrimino should lock with a beam search over the placements of
+// the active tetrimino and the previewed tetriminos.
+namespace Ai {
+
+struct BotConfig {
+  // The number of boards that are kept after every level of the search.
+  int mBeamWidth;
+  // The number of tetriminos the search places, starting with the active one.
+  // The search never looks further ahead than the preview.
+  int mDepth;
+  // The time in milliseconds a single search should take. A level is only
+  // searched when the previous level suggests that it fits in the budget. Zero
+  // gives the search as long as it needs, so the choices only depend on the
+  // game.
+  float mBudgetMs;
+  Weights mWeights;
+  // When set, the boards of a level are expanded on the workers of this pool.
+  // Nothing else may be using the pool while a search runs.
+  Sim::ThreadPool *mPool;
+
+  void SetDefaults();
+};
+
+// Choose where the active tetrimino should lock. When there is no active
+// tetrimino, the choice is for the next tetrimino at its spawn position.
+// Returns false if no placement keeps the game going.
+bool ChooseTarget(
+    const Core::Game &game, const BotConfig &config, PieceState *target);
+
+// A driver that plays the placements chosen by ChooseTarget. Moves are made by
+// tapping keys, so every shift or rotation is followed by a step without keys,
+// and down is held once the tetrimino is above its target.
+struct BotDriver {
+  static constexpr int nMaxPathLength = 64;
+
+  BotConfig mConfig;
+  bool mHasTarget;
+  PieceState mTarget;
+
+  // The moves that lead to the target and the state before each of them. The
+  // last state is the target.
+  Move mPath[nMaxPathLength];
+  PieceState mPathStates[nMaxPathLength + 1];
+  int mPathLength;
+  int mPathIndex;
+
+  Core::Inputs mLastInputs;
+  MoveSearch mSearch;
+
+  void Init(const BotConfig &config);
+  Core::Inputs NextInputs(const Core::Game &game);
+  bool FindPath(
+      const Core::Game &game, Core::Tetrimino tetrimino, PieceState start);
+};
+
+} // namespace Ai
+
+#endif
@@ -0,0 +1,22 @@
+#include "ai/Evaluate.h"
+
+namespace Ai {
+
+void Weights::SetDefaults() {
+  // These weights were tuned for a 20 row board by a genetic algorithm. They
+  // favor clearing lines one or two at a time over building for tetrises.
+  mAggregateHeight = -0.510066f;
+  mLines = 0.760666f;
+  mHoles = -0.35663f;
+  mBumpiness = -0.184483f;
+  mRowTransitions = 0.0f;
+}
+
+float Weights::Score(const Features &features) const {
+  return mAggregateHeight * (float)features.mAggregateHeight +
+         mLines * (float)features.mLines + mHoles * (float)features.mHoles +
+         mBumpiness * (float)features.mBumpiness +
+         mRowTransitions * (float)features.mRowTransitions;
+}
+
+} // namespace Ai
@@ -0,0 +1,40 @@
+#ifndef ai_Evaluate_h
+#define ai_Evaluate_h
+
+#include "core/Board.h"
+
+namespace Ai {
+
+// The properties of a board that placements are judged by.
+struct Features {
+  // The sum of the column heights.
+  int mAggregateHeight;
+  // The number of rows that the placement cleared.
+  int mLines;
+  // The number of empty cells that have a locked cell somewhere above them.
+  int mHoles;
+  // The sum of the height differences between neighbouring columns.
+  int mBumpiness;
+  // The number of times that neighbouring cells in a row, including the walls
+  // on either side, go from filled to empty or back.
+  int mRowTransitions;
+};
+
+struct Weights {
+  float mAggregateHeight;
+  float mLines;
+  float mHoles;
+  float mBumpiness;
+  float mRowTransitions;
+
+  void SetDefaults();
+  float Score(const Features &features) const;
+};
+
+// Measure a board after a placement that cleared the given number of rows.
+// Batches of boards are measured with the kernels in ai/FeatureKernel.h.
+Features ComputeFeatures(const Core::Board &board, int lines);
+
+} // namespace Ai
+
+#endif
@@ -0,0 +1,306 @@
+#include "ai/FeatureKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define FEATURE_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Ai {
+
+// Every feature is a sum over the rows of a board of the set bits in a mask.
+// Going down the rows, a column is covered once a cell in it is filled.
+// - A hole is an empty cell in a covered column.
+// - The height of a column is the number of rows that it is covered in, so the
+//   aggregate height sums the covered columns of every row.
+// - Two neighbouring columns differ in height by the number of rows where
+//   exactly one of them is covered.
+// - A row transition is a pair of neighbouring bits that differ, counting the
+//   wall bits next to the grid.
+// This only needs ands, ors, xors, shifts and bit counts, which vectorize
+// across boards.
+const unsigned int nGridMask = ((1u << Core::Board::nWidth) - 1)
+                               << Core::Board::nWallBits;
+const unsigned int nColumnPairMask = ((1u << (Core::Board::nWidth - 1)) - 1)
+                                     << Core::Board::nWallBits;
+const unsigned int nTransitionMask = ((1u << (Core::Board::nWidth + 1)) - 1)
+                                     << (Core::Board::nWallBits - 1);
+static_assert(
+    Core::Board::nWidth + Core::Board::nWallBits < 16,
+    "The row transitions of the last column need the bit above the grid.");
+
+int CountBits(unsigned int bits) {
+  int count = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    ++count;
+  }
+  return count;
+}
+
+Features ComputeFeatures(const Core::Board &board, int lines) {
+  Features features = {};
+  features.mLines = lines;
+  unsigned int covered = 0;
+  for (int row = 0; row < Core::Board::nHeight; ++row) {
+    unsigned int bits = board.Row(row);
+    unsigned int cells = bits & nGridMask;
+    features.mHoles += CountBits(~cells & covered);
+    covered |= cells;
+    features.mAggregateHeight += CountBits(covered);
+    features.mBumpiness +=
+        CountBits((covered ^ (covered >> 1)) & nColumnPairMask);
+    features.mRowTransitions +=
+        CountBits((bits ^ (bits >> 1)) & nTransitionMask);
+  }
+  return features;
+}
+
+void BoardBatch::Clear() {
+  mCount = 0;
+  mRows.clear();
+  mLines.clear();
+}
+
+int BoardBatch::Add(const Core::Board &board, int lines) {
+  // Start a new group with empty boards so the unused lanes of the last group
+  // can be measured like the others.
+  int lane = mCount % nGroupSize;
+  if (lane == 0) {
+    mRows.resize(mRows.size() + nGroupRowCount, Core::Board::nEmptyRow);
+  }
+  Core::RowMask *group = &mRows[mRows.size() - nGroupRowCount];
+  for (int row = 0; row < Core::Board::nHeight; ++row) {
+    group[row * nGroupSize + lane] = board.Row(row);
+  }
+  mLines.push_back(lines);
+  return mCount++;
+}
+
+int BoardBatch::GroupCount() const {
+  return (mCount + nGroupSize - 1) / nGroupSize;
+}
+
+// The sums of a group before they are written out as features.
+struct GroupSums {
+  unsigned short mHoles[BoardBatch::nGroupSize];
+  unsigned short mHeights[BoardBatch::nGroupSize];
+  unsigned short mBumpiness[BoardBatch::nGroupSize];
+  unsigned short mTransitions[BoardBatch::nGroupSize];
+};
+
+void ScalarGroup(const Core::RowMask *rows, GroupSums *sums) {
+  for (int lane = 0; lane < BoardBatch::nGroupSize; ++lane) {
+    unsigned int covered = 0;
+    int holes = 0, heights = 0, bumpiness = 0, transitions = 0;
+    for (int row = 0; row < Core::Board::nHeight; ++row) {
+      unsigned int bits = rows[row * BoardBatch::nGroupSize + lane];
+      unsigned int cells = bits & nGridMask;
+      holes += CountBits(~cells & covered);
+      covered |= cells;
+      heights += CountBits(covered);
+      bumpiness += CountBits((covered ^ (covered >> 1)) & nColumnPairMask);
+      transitions += CountBits((bits ^ (bits >> 1)) & nTransitionMask);
+    }
+    sums->mHoles[lane] = (unsigned short)holes;
+    sums->mHeights[lane] = (unsigned short)heights;
+    sums->mBumpiness[lane] = (unsigned short)bumpiness;
+    sums->mTransitions[lane] = (unsigned short)transitions;
+  }
+}
+
+#ifdef FEATURE_KERNEL_X86
+// The vector kernels count the bits of every 16 bit lane with the usual
+// shifts and adds since there is no instruction for it before AVX-512.
+__m128i CountBits16(__m128i bits) {
+  const __m128i m1 = _mm_set1_epi16(0x5555);
+  const __m128i m2 = _mm_set1_epi16(0x3333);
+  const __m128i m4 = _mm_set1_epi16(0x0f0f);
+  bits = _mm_sub_epi16(bits, _mm_and_si128(_mm_srli_epi16(bits, 1), m1));
+  bits = _mm_add_epi16(
+      _mm_and_si128(bits, m2), _mm_and_si128(_mm_srli_epi16(bits, 2), m2));
+  bits = _mm_and_si128(_mm_add_epi16(bits, _mm_srli_epi16(bits, 4)), m4);
+  return _mm_and_si128(
+      _mm_add_epi16(bits, _mm_srli_epi16(bits, 8)), _mm_set1_epi16(0x1f));
+}
+
+void Sse2Group(const Core::RowMask *rows, GroupSums *sums) {
+  const __m128i gridMask = _mm_set1_epi16((short)nGridMask);
+  const __m128i pairMask = _mm_set1_epi16((short)nColumnPairMask);
+  const __m128i transitionMask = _mm_set1_epi16((short)nTransitionMask);
+  for (int half = 0; half < BoardBatch::nGroupSize; half += 8) {
+    __m128i covered = _mm_setzero_si128();
+    __m128i holes = _mm_setzero_si128();
+    __m128i heights = _mm_setzero_si128();
+    __m128i bumpiness = _mm_setzero_si128();
+    __m128i transitions = _mm_setzero_si128();
+    for (int row = 0; row < Core::Board::nHeight; ++row) {
+      __m128i bits = _mm_loadu_si128(
+          (const __m128i *)&rows[row * BoardBatch::nGroupSize + half]);
+      __m128i cells = _mm_and_si128(bits, gridMask);
+      holes =
+          _mm_add_epi16(holes, CountBits16(_mm_andnot_si128(cells, covered)));
+      covered = _mm_or_si128(covered, cells);
+      heights = _mm_add_epi16(heights, CountBits16(covered));
+      __m128i pairs = _mm_xor_si128(covered, _mm_srli_epi16(covered, 1));
+      bumpiness = _mm_add_epi16(
+          bumpiness, CountBits16(_mm_and_si128(pairs, pairMask)));
+      __m128i changes = _mm_xor_si128(bits, _mm_srli_epi16(bits, 1));
+      transitions = _mm_add_epi16(
+          transitions, CountBits16(_mm_and_si128(changes, transitionMask)));
+    }
+    _mm_storeu_si128((__m128i *)&sums->mHoles[half], holes);
+    _mm_storeu_si128((__m128i *)&sums->mHeights[half], heights);
+    _mm_storeu_si128((__m128i *)&sums->mBumpiness[half], bumpiness);
+    _mm_storeu_si128((__m128i *)&sums->mTransitions[half], transitions);
+  }
+}
+
+TARGET_AVX2 __m256i CountBits16(__m256i bits) {
+  const __m256i m1 = _mm256_set1_epi16(0x5555);
+  const __m256i m2 = _mm256_set1_epi16(0x3333);
+  const __m256i m4 = _mm256_set1_epi16(0x0f0f);
+  bits =
+      _mm256_sub_epi16(bits, _mm256_and_si256(_mm256_srli_epi16(bits, 1), m1));
+  bits = _mm256_add_epi16(_mm256_and_si256(bits, m2),
+                          _mm256_and_si256(_mm256_srli_epi16(bits, 2), m2));
+  bits = _mm256_and_si256(
+      _mm256_add_epi16(bits, _mm256_srli_epi16(bits, 4)), m4);
+  return _mm256_and_si256(_mm256_add_epi16(bits, _mm256_srli_epi16(bits, 8)),
+                          _mm256_set1_epi16(0x1f));
+}
+
+TARGET_AVX2 void Avx2Group(const Core::RowMask *rows, GroupSums *sums) {
+  static_assert(BoardBatch::nGroupSize == 16,
+                "A group must fill a 256 bit register of 16 bit rows.");
+  const __m256i gridMask = _mm256_set1_epi16((short)nGridMask);
+  const __m256i pairMask = _mm256_set1_epi16((short)nColumnPairMask);
+  const __m256i transitionMask = _mm256_set1_epi16((short)nTransitionMask);
+  __m256i covered = _mm256_setzero_si256();
+  __m256i holes = _mm256_setzero_si256();
+  __m256i heights = _mm256_setzero_si256();
+  __m256i bumpiness = _mm256_setzero_si256();
+  __m256i transitions = _mm256_setzero_si256();
+  for (int row = 0; row < Core::Board::nHeight; ++row) {
+    __m256i bits = _mm256_loadu_si256(
+        (const __m256i *)&rows[row * BoardBatch::nGroupSize]);
+    __m256i cells = _mm256_and_si256(bits, gridMask);
+    holes = _mm256_add_epi16(
+        holes, CountBits16(_mm256_andnot_si256(cells, covered)));
+    covered = _mm256_or_si256(covered, cells);
+    heights = _mm256_add_epi16(heights, CountBits16(covered));
+    __m256i pairs = _mm256_xor_si256(covered, _mm256_srli_epi16(covered, 1));
+    bumpiness = _mm256_add_epi16(
+        bumpiness, CountBits16(_mm256_and_si256(pairs, pairMask)));
+    __m256i changes = _mm256_xor_si256(bits, _mm256_srli_epi16(bits, 1));
+    transitions = _mm256_add_epi16(
+        transitions, CountBits16(_mm256_and_si256(changes, transitionMask)));
+  }
+  _mm256_storeu_si256((__m256i *)sums->mHoles, holes);
+  _mm256_storeu_si256((__m256i *)sums->mHeights, heights);
+  _mm256_storeu_si256((__m256i *)sums->mBumpiness, bumpiness);
+  _mm256_storeu_si256((__m256i *)sums->mTransitions, transitions);
+}
+
+bool CpuHasAvx2() {
+#ifdef _MSC_VER
+  // AVX2 also needs the operating system to save the upper halves of the
+  // registers, which is reported through XGETBV.
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+FeatureKernel BestFeatureKernel() {
+#ifdef FEATURE_KERNEL_X86
+  static const FeatureKernel best =
+      CpuHasAvx2() ? FeatureKernel::Avx2 : FeatureKernel::Sse2;
+  return best;
+#else
+  return FeatureKernel::Scalar;
+#endif
+}
+
+const char *FeatureKernelName(FeatureKernel kernel) {
+  switch (kernel) {
+  case FeatureKernel::Scalar:
+    return "scalar";
+  case FeatureKernel::Sse2:
+    return "sse2";
+  case FeatureKernel::Avx2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+bool FeatureKernelSupported(FeatureKernel kernel) {
+  switch (kernel) {
+  case FeatureKernel::Scalar:
+    return true;
+#ifdef FEATURE_KERNEL_X86
+  case FeatureKernel::Sse2:
+    return true;
+  case FeatureKernel::Avx2:
+    return BestFeatureKernel() == FeatureKernel::Avx2;
+#endif
+  default:
+    return false;
+  }
+}
+
+void ComputeFeatures(
+    const BoardBatch &batch, Features *features, FeatureKernel kernel) {
+  if (!FeatureKernelSupported(kernel)) {
+    kernel = FeatureKernel::Scalar;
+  }
+  for (int group = 0; group < batch.GroupCount(); ++group) {
+    const Core::RowMask *rows =
+        &batch.mRows[group * BoardBatch::nGroupRowCount];
+    GroupSums sums;
+    switch (kernel) {
+#ifdef FEATURE_KERNEL_X86
+    case FeatureKernel::Avx2:
+      Avx2Group(rows, &sums);
+      break;
+    case FeatureKernel::Sse2:
+      Sse2Group(rows, &sums);
+      break;
+#endif
+    default:
+      ScalarGroup(rows, &sums);
+      break;
+    }
+    int first = group * BoardBatch::nGroupSize;
+    int count = batch.mCount - first;
+    count = count < BoardBatch::nGroupSize ? count : BoardBatch::nGroupSize;
+    for (int lane = 0; lane < count; ++lane) {
+      Features &boardFeatures = features[first + lane];
+      boardFeatures.mAggregateHeight = sums.mHeights[lane];
+      boardFeatures.mLines = batch.mLines[first + lane];
+      boardFeatures.mHoles = sums.mHoles[lane];
+      boardFeatures.mBumpiness = sums.mBumpiness[lane];
+      boardFeatures.mRowTransitions = sums.mTransitions[lane];
+    }
+  }
+}
+
+} // namespace Ai
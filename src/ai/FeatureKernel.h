@@ -0,0 +1,43 @@
+#ifndef ai_FeatureKernel_h
+#define ai_FeatureKernel_h
+
+#include <vector>
+
+#include "ai/Evaluate.h"
+
+namespace Ai {
+
+// Boards packed so that a batch of them can be measured in one pass. The
+// boards are split into groups and each row of a group is stored as the rows
+// of every board in the group next to each other. A kernel loads a row of
+// the whole group at once and measures all of its boards together.
+struct BoardBatch {
+  static constexpr int nGroupSize = 16;
+  static constexpr int nGroupRowCount = Core::Board::nHeight * nGroupSize;
+
+  int mCount;
+  std::vector<Core::RowMask> mRows;
+  std::vector<int> mLines;
+
+  void Clear();
+  // Add a board after a placement that cleared the given number of rows and
+  // return its index in the batch.
+  int Add(const Core::Board &board, int lines);
+  int GroupCount() const;
+};
+
+enum class FeatureKernel { Scalar, Sse2, Avx2 };
+
+// The fastest kernel that the processor supports. This is found once.
+FeatureKernel BestFeatureKernel();
+const char *FeatureKernelName(FeatureKernel kernel);
+bool FeatureKernelSupported(FeatureKernel kernel);
+
+// Write the features of every board in the batch. All kernels give the same
+// features as ComputeFeatures.
+void ComputeFeatures(const BoardBatch &batch, Features *features,
+                     FeatureKernel kernel = BestFeatureKernel());
+
+} // namespace Ai
+
+#endif
@@ -0,0 +1,287 @@
+#include <string.h>
+
+#include "ai/Finesse.h"
+
+namespace Ai {
+
+Footprint GetFootprint(Core::Tetrimino tetrimino, PieceState state) {
+  const Core::Shape &shape = Core::GetShape(tetrimino, state.mRotation);
+  Footprint footprint = {};
+  footprint.mTop = state.mY + shape.mMinRow;
+  for (int i = shape.mMinRow; i <= shape.mMaxRow; ++i) {
+    footprint.mRows[i - shape.mMinRow] =
+        (unsigned int)shape.mRows[i] << (state.mX - MoveSearch::nMinX);
+  }
+  return footprint;
+}
+
+const FinessePlacement *FinesseResult::Find(const Footprint &footprint) const {
+  for (int i = 0; i < mCount; ++i) {
+    if (mPlacements[i].mFootprint == footprint) {
+      return &mPlacements[i];
+    }
+  }
+  return nullptr;
+}
+
+FinesseSearch::FinesseSearch() : mSearchStamp(0) {
+  for (int i = 0; i < nStateCount; ++i) {
+    mStamps[i] = 0;
+  }
+}
+
+bool FinesseSearch::Fits(int x, int y, int rotation) const {
+  if (x < MoveSearch::nMinX || x >= MoveSearch::nMinX + MoveSearch::nWidth) {
+    return false;
+  }
+  return y <= mLandings[rotation][x - MoveSearch::nMinX];
+}
+
+bool FinesseSearch::TryKey(PieceState from, FinesseKey key,
+                           PieceState *to) const {
+  *to = from;
+  switch (key) {
+  case FinesseKey::Left:
+    --to->mX;
+    return Fits(to->mX, to->mY, to->mRotation);
+  case FinesseKey::Right:
+    ++to->mX;
+    return Fits(to->mX, to->mY, to->mRotation);
+  case FinesseKey::HoldLeft:
+  case FinesseKey::HoldRight: {
+    int step = key == FinesseKey::HoldLeft ? -1 : 1;
+    while (Fits(to->mX + step, to->mY, to->mRotation)) {
+      to->mX += step;
+    }
+    return to->mX != from.mX;
+  }
+  case FinesseKey::RotateCcw:
+  case FinesseKey::RotateCw: {
+    // The kicks are tried in the same order as Core::KickRotation.
+    int turn = key == FinesseKey::RotateCcw ? 1 : 3;
+    int rotation = (from.mRotation + turn) % 4;
+    for (int i = 0; i < Core::nKickCount; ++i) {
+      int x = from.mX + Core::nKicks[i][0];
+      int y = from.mY + Core::nKicks[i][1];
+      if (Fits(x, y, rotation)) {
+        to->mX = (signed char)x;
+        to->mY = (signed char)y;
+        to->mRotation = (signed char)rotation;
+        return y >= MoveSearch::nMinY;
+      }
+    }
+    return false;
+  }
+  }
+  return false;
+}
+
+void FinesseSearch::Run(const signed char *skyline, Core::Tetrimino tetrimino,
+                        FinesseResult *result) {
+  mReachedCount = 0;
+  result->mTetrimino = tetrimino;
+  memcpy(result->mSurface, skyline, sizeof(result->mSurface));
+  result->mCount = 0;
+  if (++mSearchStamp == 0) {
+    for (int i = 0; i < nStateCount; ++i) {
+      mStamps[i] = 0;
+    }
+    mSearchStamp = 1;
+  }
+
+  int clearRow = Core::Board::nHeight;
+  for (int j = 0; j < Core::Board::nWidth; ++j) {
+    clearRow = skyline[j] < clearRow ? skyline[j] : clearRow;
+  }
+  // A tetrimino lands where the first of its columns meets the skyline.
+  for (int rotation = 0; rotation < 4; ++rotation) {
+    const Core::Shape &shape = Core::GetShape(tetrimino, rotation);
+    for (int i = 0; i < MoveSearch::nWidth; ++i) {
+      int x = i + MoveSearch::nMinX;
+      if (x + shape.mMinColumn < 0 ||
+          x + shape.mMaxColumn >= Core::Board::nWidth) {
+        mLandings[rotation][i] = nNoLanding;
+        continue;
+      }
+      int landing = Core::Board::nHeight;
+      for (int j = shape.mMinColumn; j <= shape.mMaxColumn; ++j) {
+        int row = skyline[x + j] - 1 - shape.mBottoms[j];
+        landing = row < landing ? row : landing;
+      }
+      mLandings[rotation][i] = (signed char)landing;
+    }
+  }
+
+  PieceState start = SpawnState();
+  if (!Fits(start.mX, start.mY, start.mRotation)) {
+    return;
+  }
+  auto visit = [this](PieceState state, int parent, unsigned char key) {
+    int index = MoveSearch::Index(state);
+    if (mStamps[index] == mSearchStamp) {
+      return;
+    }
+    mStamps[index] = mSearchStamp;
+    mParents[index] = (unsigned short)parent;
+    mParentKeys[index] = key;
+    mOrder[mReachedCount++] = state;
+  };
+  int startIndex = MoveSearch::Index(start);
+  visit(start, startIndex, nGravity);
+
+  // The states of a level are those reached with the same number of presses,
+  // so the order of reached states never goes down in presses. As in
+  // MoveSearch, states that are clear of the surface are only expanded
+  // downward. Nothing happens in them, so a fall skips straight past them to
+  // the first row that is not clear. No tetrimino lands above that row.
+  int firstBusyRow = clearRow - 4;
+  int levelStart = 0;
+  while (levelStart < mReachedCount) {
+    for (int i = levelStart; i < mReachedCount; ++i) {
+      PieceState from = mOrder[i];
+      PieceState below = from;
+      below.mY = (signed char)(from.mY + 1 < firstBusyRow ? firstBusyRow
+                                                           : from.mY + 1);
+      if (Fits(below.mX, below.mY, below.mRotation)) {
+        visit(below, MoveSearch::Index(from), nGravity);
+      }
+    }
+    int levelEnd = mReachedCount;
+    for (int i = levelStart; i < levelEnd; ++i) {
+      PieceState from = mOrder[i];
+      if (from.mY != start.mY && from.mY + 4 < clearRow) {
+        continue;
+      }
+      int fromIndex = MoveSearch::Index(from);
+      for (int key = 0; key <= (int)FinesseKey::RotateCw; ++key) {
+        PieceState to;
+        if (TryKey(from, (FinesseKey)key, &to)) {
+          visit(to, fromIndex, (unsigned char)key);
+        }
+      }
+    }
+    levelStart = levelEnd;
+  }
+
+  // The first state to reach a footprint reached it with the fewest presses.
+  for (int i = 0; i < mReachedCount; ++i) {
+    PieceState state = mOrder[i];
+    if (Fits(state.mX, state.mY + 1, state.mRotation)) {
+      continue;
+    }
+    Footprint footprint = GetFootprint(tetrimino, state);
+    if (result->Find(footprint) != nullptr) {
+      continue;
+    }
+    FinesseKey keys[FinessePlacement::nMaxKeys];
+    int keyCount = 0;
+    int index = MoveSearch::Index(state);
+    while (index != startIndex && keyCount <= FinessePlacement::nMaxKeys) {
+      if (mParentKeys[index] != nGravity) {
+        if (keyCount < FinessePlacement::nMaxKeys) {
+          keys[keyCount] = (FinesseKey)mParentKeys[index];
+        }
+        ++keyCount;
+      }
+      index = mParents[index];
+    }
+    if (keyCount > FinessePlacement::nMaxKeys ||
+        result->mCount == FinesseResult::nMaxPlacements) {
+      continue;
+    }
+    FinessePlacement &placement = result->mPlacements[result->mCount++];
+    placement.mState = state;
+    placement.mFootprint = footprint;
+    placement.mKeyCount = (unsigned char)keyCount;
+    for (int j = 0; j < keyCount; ++j) {
+      placement.mKeys[j] = keys[keyCount - 1 - j];
+    }
+  }
+}
+
+void FinesseCache::Init(int entryCount) {
+  mEntries.resize(entryCount > 0 ? entryCount : 1);
+  for (FinesseResult &entry : mEntries) {
+    entry.mTetrimino = Core::Tetrimino::None;
+  }
+  mHits = 0;
+  mMisses = 0;
+}
+
+const FinesseResult &FinesseCache::Find(
+    const Core::Board &board, Core::Tetrimino tetrimino,
+    FinesseSearch *search) {
+  // FNV-1a over the tetrimino and the skyline.
+  unsigned int hash = 2166136261u;
+  hash = (hash ^ (unsigned int)tetrimino) * 16777619u;
+  for (int j = 0; j < Core::Board::nWidth; ++j) {
+    hash = (hash ^ (unsigned char)board.mSkyline[j]) * 16777619u;
+  }
+  FinesseResult &entry = mEntries[hash % mEntries.size()];
+  if (entry.mTetrimino == tetrimino &&
+      memcmp(entry.mSurface, board.mSkyline, sizeof(entry.mSurface)) == 0) {
+    ++mHits;
+    return entry;
+  }
+  ++mMisses;
+  search->Run(board.mSkyline, tetrimino, &entry);
+  return entry;
+}
+
+void FinesseTrainer::Init(int cacheEntries) {
+  mCache.Init(cacheEntries);
+  mResult = nullptr;
+  mPresses = 0;
+  mGraded = 0;
+  mFaults = 0;
+  mExtraPresses = 0;
+  mUngraded = 0;
+  mLastPresses = 0;
+  mLastLeast = -1;
+}
+
+void FinesseTrainer::Before(const Core::Game &game, Core::Inputs inputs) {
+  if (!game.mRunning) {
+    mResult = nullptr;
+    return;
+  }
+  // A tetrimino that has not spawned yet spawns before the keys are handled.
+  if (game.mActiveTetrimino == Core::Tetrimino::None) {
+    mResult = &mCache.Find(game.mBoard, game.Preview(0), &mSearch);
+    mPresses = 0;
+  }
+  const Core::Inputs counted = Core::Key::Left | Core::Key::Right |
+                               Core::Key::RotateCcw | Core::Key::RotateCw;
+  unsigned int pressed = inputs & ~game.mHeld & counted;
+  for (; pressed != 0; pressed &= pressed - 1) {
+    ++mPresses;
+  }
+}
+
+void FinesseTrainer::After(const Core::Game &game) {
+  if (!(game.mEvents & Core::Event::Locked) || mResult == nullptr) {
+    return;
+  }
+  // The pose of a tetrimino is kept when it locks.
+  PieceState state;
+  state.mX = (signed char)game.mActiveX;
+  state.mY = (signed char)game.mActiveY;
+  state.mRotation = (signed char)game.mShapeRotation;
+  const FinessePlacement *placement =
+      mResult->Find(GetFootprint(mResult->mTetrimino, state));
+  mResult = nullptr;
+  mLastPresses = mPresses;
+  if (placement == nullptr) {
+    ++mUngraded;
+    mLastLeast = -1;
+    return;
+  }
+  ++mGraded;
+  mLastLeast = placement->mKeyCount;
+  if (mPresses > mLastLeast) {
+    ++mFaults;
+    mExtraPresses += mPresses - mLastLeast;
+  }
+}
+
+} // namespace Ai
@@ -0,0 +1,149 @@
+#ifndef ai_Finesse_h
+#define ai_Finesse_h
+
+#include <vector>
+
+#include "ai/Placement.h"
+
+// Finds the fewest key presses that bring a spawned tetrimino to each place it
+// can lock and grades players against them. Gravity is free, so a path only
+// counts the shifts and rotations a player has to press.
+namespace Ai {
+
+// The presses a finesse path is made of. A tapped shift moves by one column. A
+// held shift repeats until the tetrimino is blocked, as HandleHorizontalShift
+// does for a key that stays down, and costs a single press like a tap.
+// Rotations are kicked with Core::KickRotation.
+enum class FinesseKey : unsigned char {
+  Left,
+  Right,
+  HoldLeft,
+  HoldRight,
+  RotateCcw,
+  RotateCw
+};
+
+// The cells a tetrimino covers. Placements that reach the same cells through
+// different rotations or positions within the 4x4 shape are the same
+// placement to a player.
+struct Footprint {
+  int mTop;
+  unsigned int mRows[4];
+
+  bool operator==(const Footprint &other) const {
+    return mTop == other.mTop && mRows[0] == other.mRows[0] &&
+           mRows[1] == other.mRows[1] && mRows[2] == other.mRows[2] &&
+           mRows[3] == other.mRows[3];
+  }
+};
+
+Footprint GetFootprint(Core::Tetrimino tetrimino, PieceState state);
+
+struct FinessePlacement {
+  static constexpr int nMaxKeys = 8;
+
+  PieceState mState;
+  Footprint mFootprint;
+  unsigned char mKeyCount;
+  FinesseKey mKeys[nMaxKeys];
+};
+
+// Every placement of a tetrimino on a surface along with the fewest presses
+// that reach it from the spawn state. Placements that need more than nMaxKeys
+// presses are left out.
+struct FinesseResult {
+  static constexpr int nMaxPlacements = 4 * Core::Board::nWidth;
+
+  Core::Tetrimino mTetrimino;
+  signed char mSurface[Core::Board::nWidth];
+  int mCount;
+  FinessePlacement mPlacements[nMaxPlacements];
+
+  // Returns null when no placement covers the footprint.
+  const FinessePlacement *Find(const Footprint &footprint) const;
+};
+
+// A breadth first search over the same states as MoveSearch in which every
+// state is reached with the fewest presses. Moving down a row costs nothing,
+// so the states reached with n presses are expanded downward before any of
+// them is expanded with a press.
+//
+// The search runs on the surface of a board, the board with every cell below
+// the skyline filled. The surface only depends on the skyline, which keeps
+// results cacheable, and any placement on the surface is a placement on the
+// board. Placements tucked under an overhang are not searched. A tetrimino
+// that fits on the surface also fits in every row above, so whether a state
+// fits is a comparison against the row it lands in.
+struct FinesseSearch {
+  static constexpr int nStateCount = MoveSearch::nStateCount;
+  static constexpr unsigned char nGravity = 0xff;
+  static constexpr signed char nNoLanding = -128;
+
+  // The lowest row each rotation fits in at every column, or nNoLanding where
+  // the tetrimino is outside of the grid.
+  signed char mLandings[4][MoveSearch::nWidth];
+
+  unsigned int mSearchStamp;
+  unsigned int mStamps[nStateCount];
+  unsigned short mParents[nStateCount];
+  // The FinesseKey that reached a state or nGravity for a state reached by
+  // falling.
+  unsigned char mParentKeys[nStateCount];
+  PieceState mOrder[nStateCount];
+  int mReachedCount;
+
+  FinesseSearch();
+  void Run(const signed char *skyline, Core::Tetrimino tetrimino,
+           FinesseResult *result);
+  bool TryKey(PieceState from, FinesseKey key, PieceState *to) const;
+  bool Fits(int x, int y, int rotation) const;
+};
+
+// Results for the most recently searched surfaces. Every combination of
+// surface and tetrimino has a single slot it can be kept in, so the cache
+// never grows past the number of slots it was created with and a search
+// replaces whatever was in its slot. Empty slots hold Core::Tetrimino::None.
+struct FinesseCache {
+  static constexpr int nDefaultEntryCount = 256;
+
+  std::vector<FinesseResult> mEntries;
+  long long mHits;
+  long long mMisses;
+
+  void Init(int entryCount);
+  const FinesseResult &Find(const Core::Board &board, Core::Tetrimino tetrimino,
+                            FinesseSearch *search);
+};
+
+// Counts the shifts and rotations a player presses for every tetrimino and
+// compares them against the fewest the placement it locked in needed. Before
+// and After are called around every step of a game.
+struct FinesseTrainer {
+  FinesseSearch mSearch;
+  FinesseCache mCache;
+
+  // The placements of the active tetrimino and the presses made so far. The
+  // result is null while no tetrimino is being graded.
+  const FinesseResult *mResult;
+  int mPresses;
+
+  // Tetriminos that locked on the surface and those among them that took
+  // more presses than needed. Tetriminos that locked elsewhere are ungraded.
+  long long mGraded;
+  long long mFaults;
+  long long mExtraPresses;
+  long long mUngraded;
+
+  // The grade of the tetrimino that locked last. The least is -1 when the
+  // tetrimino was ungraded.
+  int mLastPresses;
+  int mLastLeast;
+
+  void Init(int cacheEntries);
+  void Before(const Core::Game &game, Core::Inputs inputs);
+  void After(const Core::Game &game);
+};
+
+} // namespace Ai
+
+#endif
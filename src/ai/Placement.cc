@@ -0,0 +1,198 @@
+#include "ai/Placement.h"
+
+namespace Ai {
+
+PieceState SpawnState() {
+  PieceState state;
+  state.mX = Core::Game::nSpawnX;
+  state.mY = Core::Game::nSpawnY;
+  state.mRotation = 0;
+  return state;
+}
+
+MoveSearch::MoveSearch() : mSearchStamp(0) {
+  for (int i = 0; i < nStateCount; ++i) {
+    mStamps[i] = 0;
+  }
+}
+
+int MoveSearch::Index(PieceState state) {
+  return (state.mRotation * nHeight + (state.mY - nMinY)) * nWidth +
+         (state.mX - nMinX);
+}
+
+PieceState MoveSearch::State(int index) {
+  PieceState state;
+  state.mX = (signed char)(index % nWidth + nMinX);
+  index /= nWidth;
+  state.mY = (signed char)(index % nHeight + nMinY);
+  state.mRotation = (signed char)(index / nHeight);
+  return state;
+}
+
+bool MoveSearch::TryMove(PieceState from, Move move, PieceState *to) const {
+  int x = from.mX;
+  int y = from.mY;
+  int rotation = from.mRotation;
+  switch (move) {
+  case Move::Left:
+    --x;
+    break;
+  case Move::Right:
+    ++x;
+    break;
+  case Move::Down:
+    ++y;
+    break;
+  case Move::RotateCcw:
+  case Move::RotateCw: {
+    rotation = (rotation + (move == Move::RotateCcw ? 1 : 3)) % 4;
+    const Core::Shape &shape = Core::GetShape(mTetrimino, rotation);
+    if (!Core::KickRotation(*mBoard, shape, &x, &y)) {
+      return false;
+    }
+    break;
+  }
+  }
+  if (x < nMinX || x >= nMinX + nWidth || y < nMinY || y >= nMinY + nHeight) {
+    return false;
+  }
+  if (move != Move::RotateCcw && move != Move::RotateCw) {
+    const Core::Shape &shape = Core::GetShape(mTetrimino, rotation);
+    if (!mBoard->Fits(shape, x, y)) {
+      return false;
+    }
+  }
+  to->mX = (signed char)x;
+  to->mY = (signed char)y;
+  to->mRotation = (signed char)rotation;
+  return true;
+}
+
+bool MoveSearch::Run(const Core::Board &board, Core::Tetrimino tetrimino,
+                     PieceState start) {
+  mBoard = &board;
+  mTetrimino = tetrimino;
+  mStart = start;
+  mReachedCount = 0;
+  if (++mSearchStamp == 0) {
+    for (int i = 0; i < nStateCount; ++i) {
+      mStamps[i] = 0;
+    }
+    mSearchStamp = 1;
+  }
+  const Core::Shape &startShape = Core::GetShape(tetrimino, start.mRotation);
+  if (!board.Fits(startShape, start.mX, start.mY)) {
+    return false;
+  }
+
+  // A tetrimino that is clear of the locked cells moves in the same way as it
+  // would in the start row. Those states only need to be expanded downward
+  // since shifting and rotating them reaches states that are also reached by
+  // doing the same in the start row and dropping afterwards.
+  mClearRow = 0;
+  while (mClearRow < Core::Board::nHeight &&
+         board.Row(mClearRow) == Core::Board::nEmptyRow) {
+    ++mClearRow;
+  }
+
+  int startIndex = Index(start);
+  mStamps[startIndex] = mSearchStamp;
+  mOrder[mReachedCount++] = (unsigned short)startIndex;
+  const Move moves[] = {
+      Move::Left, Move::Right, Move::RotateCcw, Move::RotateCw, Move::Down};
+  for (int next = 0; next < mReachedCount; ++next) {
+    int fromIndex = mOrder[next];
+    PieceState from = State(fromIndex);
+    bool clear = from.mY != start.mY && from.mY + 4 < mClearRow;
+    for (Move move : moves) {
+      if (clear && move != Move::Down) {
+        continue;
+      }
+      PieceState to;
+      if (!TryMove(from, move, &to)) {
+        continue;
+      }
+      int toIndex = Index(to);
+      if (mStamps[toIndex] == mSearchStamp) {
+        continue;
+      }
+      mStamps[toIndex] = mSearchStamp;
+      mParents[toIndex] = (unsigned short)fromIndex;
+      mParentMoves[toIndex] = move;
+      mOrder[mReachedCount++] = (unsigned short)toIndex;
+    }
+  }
+  return true;
+}
+
+bool MoveSearch::Reached(PieceState state) const {
+  if (state.mX < nMinX || state.mX >= nMinX + nWidth || state.mY < nMinY ||
+      state.mY >= nMinY + nHeight) {
+    return false;
+  }
+  return mStamps[Index(state)] == mSearchStamp;
+}
+
+int MoveSearch::Placements(PieceState *placements, int capacity) const {
+  // The cells a placement covers, used to skip placements that only differ by
+  // orientation or position within the 4x4 shape.
+  struct Footprint {
+    int mTop;
+    unsigned int mRows[4];
+  };
+  Footprint footprints[nStateCount / 4];
+  int count = 0;
+  for (int i = 0; i < mReachedCount && count < capacity; ++i) {
+    PieceState state = State(mOrder[i]);
+    const Core::Shape &shape = Core::GetShape(mTetrimino, state.mRotation);
+    if (mBoard->Fits(shape, state.mX, state.mY + 1)) {
+      continue;
+    }
+    Footprint footprint = {};
+    footprint.mTop = state.mY + shape.mMinRow;
+    for (int j = shape.mMinRow; j <= shape.mMaxRow; ++j) {
+      footprint.mRows[j - shape.mMinRow] =
+          (unsigned int)shape.mRows[j] << (state.mX - nMinX);
+    }
+    bool duplicate = false;
+    for (int j = 0; j < count && !duplicate; ++j) {
+      const Footprint &other = footprints[j];
+      duplicate = other.mTop == footprint.mTop &&
+                  other.mRows[0] == footprint.mRows[0] &&
+                  other.mRows[1] == footprint.mRows[1] &&
+                  other.mRows[2] == footprint.mRows[2] &&
+                  other.mRows[3] == footprint.mRows[3];
+    }
+    if (!duplicate) {
+      footprints[count] = footprint;
+      placements[count++] = state;
+    }
+  }
+  return count;
+}
+
+int MoveSearch::Path(PieceState target, Move *moves, int capacity) const {
+  if (!Reached(target)) {
+    return -1;
+  }
+  // Walk from the target back to the start and then reverse the moves.
+  int count = 0;
+  int index = Index(target);
+  int startIndex = Index(mStart);
+  while (index != startIndex) {
+    if (count == capacity) {
+      return -1;
+    }
+    moves[count++] = mParentMoves[index];
+    index = mParents[index];
+  }
+  for (int i = 0; i < count / 2; ++i) {
+    Move swap = moves[i];
+    moves[i] = moves[count - 1 - i];
+    moves[count - 1 - i] = swap;
+  }
+  return count;
+}
+
+} // namespace Ai
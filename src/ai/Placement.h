@@ -0,0 +1,73 @@
+#ifndef ai_Placement_h
+#define ai_Placement_h
+
+#include "core/Game.h"
+
+namespace Ai {
+
+// The moves a player can make with the active tetrimino. They follow the rules
+// in Core::Game: shifts and drops move by one cell and rotations are kicked
+// with Core::KickRotation.
+enum class Move : unsigned char { Left, Right, RotateCcw, RotateCw, Down };
+
+struct PieceState {
+  signed char mX;
+  signed char mY;
+  signed char mRotation;
+
+  bool operator==(const PieceState &other) const {
+    return mX == other.mX && mY == other.mY && mRotation == other.mRotation;
+  }
+  bool operator!=(const PieceState &other) const {
+    return !(*this == other);
+  }
+};
+
+PieceState SpawnState();
+
+// A breadth first search over every state a tetrimino can reach from a start
+// state. Once it has run, the search can list the states where the tetrimino
+// would lock and give the shortest sequence of moves to any reached state.
+struct MoveSearch {
+  static constexpr int nMinX = -3;
+  static constexpr int nWidth = Core::Board::nWidth - nMinX;
+  static constexpr int nMinY = -Core::Board::nPadRows;
+  static constexpr int nHeight = Core::Board::nHeight - nMinY;
+  static constexpr int nStateCount = 4 * nHeight * nWidth;
+
+  const Core::Board *mBoard;
+  Core::Tetrimino mTetrimino;
+  PieceState mStart;
+  // Tetriminos that are above this row, along with the row below them that a
+  // kick could move them into, are clear of every locked cell. See Run.
+  int mClearRow;
+
+  // A state was reached during the current search when its stamp matches
+  // mSearchStamp. This avoids clearing the arrays for every search.
+  unsigned int mSearchStamp;
+  unsigned int mStamps[nStateCount];
+  unsigned short mParents[nStateCount];
+  Move mParentMoves[nStateCount];
+  unsigned short mOrder[nStateCount];
+  int mReachedCount;
+
+  MoveSearch();
+  // Returns false if the start state does not fit on the board.
+  bool Run(const Core::Board &board, Core::Tetrimino tetrimino,
+           PieceState start);
+  bool Reached(PieceState state) const;
+  // Write the states where the tetrimino would lock. States that cover the
+  // exact same cells are only written once. Returns the number of states.
+  int Placements(PieceState *placements, int capacity) const;
+  // Write the moves that lead from the start state to a reached state and
+  // return how many there are, or -1 if the state was not reached.
+  int Path(PieceState target, Move *moves, int capacity) const;
+
+  static int Index(PieceState state);
+  static PieceState State(int index);
+  bool TryMove(PieceState from, Move move, PieceState *to) const;
+};
+
+} // namespace Ai
+
+#endif
@@ -0,0 +1,60 @@
+#include "core/Allocations.h"
+
+#ifdef TETRIS_COUNT_ALLOCATIONS
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+namespace Core {
+
+std::atomic<unsigned long long> nAllocationCount(0);
+thread_local unsigned long long tThreadAllocationCount = 0;
+
+unsigned long long AllocationCount() {
+  return nAllocationCount.load(std::memory_order_relaxed);
+}
+
+unsigned long long ThreadAllocationCount() {
+  return tThreadAllocationCount;
+}
+
+} // namespace Core
+
+// The default array and nothrow forms of operator new and delete call these,
+// so replacing them is enough to see the allocations of containers and
+// strings.
+void *operator new(size_t size) {
+  Core::nAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  ++Core::tThreadAllocationCount;
+  void *memory = malloc(size > 0 ? size : 1);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void *memory, size_t size) noexcept {
+  (void)size;
+  free(memory);
+}
+
+#else
+
+namespace Core {
+
+unsigned long long AllocationCount() {
+  return 0;
+}
+
+unsigned long long ThreadAllocationCount() {
+  return 0;
+}
+
+} // namespace Core
+
+#endif
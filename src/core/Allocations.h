@@ -0,0 +1,24 @@
+#ifndef core_Allocations_h
+#define core_Allocations_h
+
+// A hook for checking that code does not allocate. When
+// TETRIS_COUNT_ALLOCATIONS is defined, the global operator new is replaced with
+// one that counts every allocation before passing it on to malloc.
+namespace Core {
+
+#ifdef TETRIS_COUNT_ALLOCATIONS
+constexpr bool nCountAllocations = true;
+#else
+constexpr bool nCountAllocations = false;
+#endif
+
+// The number of allocations made through operator new since the program
+// started. This is always zero when allocations are not counted.
+unsigned long long AllocationCount();
+// The number of those allocations that the calling thread made, so that a
+// thread can check its own work while other threads allocate.
+unsigned long long ThreadAllocationCount();
+
+} // namespace Core
+
+#endif
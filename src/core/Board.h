@@ -0,0 +1,230 @@
+#ifndef core_Board_h
+#define core_Board_h
+
+#include <limits.h>
+#include <string.h>
+
+#include "core/Geometry.h"
+
+namespace Core {
+
+enum class Tetrimino : unsigned char { I, L, J, O, S, T, Z, None };
+
+// A tetrimino in a single orientation. Bit j of a row is set when column j of
+// the 4x4 shape is filled. The bounds of the filled cells and the lowest filled
+// cell in each column are precomputed along with the rows. See core/Shapes.h.
+struct Shape {
+  unsigned char mRows[4];
+
+  // The range of rows and columns within the 4x4 shape that contain filled
+  // cells. Both ends of a range are inclusive.
+  signed char mMinRow;
+  signed char mMaxRow;
+  signed char mMinColumn;
+  signed char mMaxColumn;
+
+  // The row of the lowest filled cell in each column. This is -1 for columns
+  // without filled cells.
+  signed char mBottoms[4];
+
+  bool Filled(int row, int column) const {
+    return (mRows[row] >> column) & 1;
+  }
+};
+
+// The locked cells of the grid. Each row is a single mask so that collision is
+// a handful of ands and shifts per shape and a complete row is a comparison
+// against a constant. The tetrimino types that color the locked cells are kept
+// in a separate plane that is only touched when cells are locked or rows are
+// collapsed. The skyline, the highest locked cell of every column, is kept up
+// to date alongside the rows so that finding where a shape lands does not
+// search row by row.
+template <typename G>
+struct BasicBoard {
+  static constexpr int nWidth = G::nWidth;
+  static constexpr int nVisibleHeight = G::nVisibleHeight;
+  static constexpr int nBufferRows = G::nBufferRows;
+  static constexpr int nHeight = G::nHeight;
+
+  // The columns of a row are stored in bits [nWallBits, nWallBits + nWidth).
+  // The bits on either side are always set. A shape that is shifted outside of
+  // the grid collides with them.
+  typedef typename G::RowMask RowMask;
+  static constexpr int nWallBits = G::nWallBits;
+  static constexpr RowMask nFullRow = (RowMask)~(RowMask)0;
+  static constexpr RowMask nEmptyRow =
+      (RowMask)~((((RowMask)1 << nWidth) - 1) << nWallBits);
+
+  // Rows of padding sit above and below the grid. The rows above are empty so
+  // shapes can be kicked above the grid and the rows below are full so they
+  // act as the floor.
+  static constexpr int nPadRows = 4;
+  static_assert(nHeight <= 127, "The skyline must fit in a signed char.");
+
+  RowMask mRows[nPadRows + nHeight + nPadRows];
+  Tetrimino mTypes[nHeight][nWidth];
+  // The row of the highest locked cell in each column, or nHeight for empty
+  // columns. Code that writes mRows directly calls UpdateSkyline afterwards.
+  signed char mSkyline[nWidth];
+
+  void Clear() {
+    for (int i = 0; i < nPadRows + nHeight; ++i) {
+      mRows[i] = nEmptyRow;
+    }
+    int floorStart = nPadRows + nHeight;
+    for (int i = floorStart; i < floorStart + nPadRows; ++i) {
+      mRows[i] = nFullRow;
+    }
+    memset(mTypes, (int)Tetrimino::None, sizeof(mTypes));
+    memset(mSkyline, nHeight, sizeof(mSkyline));
+  }
+
+  // Rebuild the skyline from the rows. Rows are scanned from the top down and
+  // only rows that reach a column for the first time are looked into, which
+  // stops once every column has been reached.
+  void UpdateSkyline() {
+    UpdateSkyline(mRows, mSkyline);
+  }
+
+  // UpdateSkyline for rows and a skyline that are stored elsewhere.
+  static void UpdateSkyline(const RowMask *rows, signed char *skyline) {
+    memset(skyline, nHeight, nWidth);
+    RowMask found = nEmptyRow;
+    for (int row = 0; row < nHeight && found != nFullRow; ++row) {
+      RowMask fresh = (RowMask)(rows[row + nPadRows] & ~found);
+      if (fresh == 0) {
+        continue;
+      }
+      found |= fresh;
+      for (int j = 0; j < nWidth; ++j) {
+        if ((fresh >> (j + nWallBits)) & 1) {
+          skyline[j] = (signed char)row;
+        }
+      }
+    }
+  }
+
+  RowMask Row(int row) const {
+    if (row < -nPadRows) {
+      return nEmptyRow;
+    }
+    return mRows[row + nPadRows];
+  }
+
+  bool Locked(int row, int column) const {
+    return (Row(row) >> (column + nWallBits)) & 1;
+  }
+
+  Tetrimino Type(int row, int column) const {
+    return mTypes[row][column];
+  }
+
+  // Check whether a shape with its top left corner at the given column and row
+  // overlaps neither locked cells nor the bounds of the grid.
+  bool Fits(const Shape &shape, int x, int y) const {
+    return Fits(mRows, shape, x, y);
+  }
+
+  // Fits for rows that are laid out like mRows but are stored elsewhere. Every
+  // shape has a filled cell in its first column or to the right of it, so a
+  // shape that starts past the last column is outside of the grid without
+  // looking at it.
+  static bool Fits(const RowMask *rows, const Shape &shape, int x, int y) {
+    int shift = x + nWallBits;
+    if (shift < 0 || x >= nWidth) {
+      return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+      int row = y + i;
+      RowMask bits = (RowMask)((RowMask)shape.mRows[i] << shift);
+      RowMask locked = row < -nPadRows ? nEmptyRow : rows[row + nPadRows];
+      if (bits & locked) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The number of rows a shape that fits at the given column and row can fall
+  // before it lands. While every column of the shape is above the skyline,
+  // the distance is set by the column that is closest to the stack. A shape
+  // that is tucked under an overhang searches down row by row instead.
+  int DropDistance(const Shape &shape, int x, int y) const {
+    return DropDistance(mRows, mSkyline, shape, x, y);
+  }
+
+  // DropDistance for rows and a skyline that are stored elsewhere.
+  static int DropDistance(const RowMask *rows, const signed char *skyline,
+                          const Shape &shape, int x, int y) {
+    int distance = INT_MAX;
+    for (int j = shape.mMinColumn; j <= shape.mMaxColumn; ++j) {
+      int bottom = y + shape.mBottoms[j];
+      int top = skyline[x + j];
+      if (bottom >= top) {
+        distance = 0;
+        while (Fits(rows, shape, x, y + distance + 1)) {
+          ++distance;
+        }
+        return distance;
+      }
+      distance = top - bottom - 1 < distance ? top - bottom - 1 : distance;
+    }
+    return distance;
+  }
+
+  // Lock the cells of a shape that fall within the grid.
+  void Lock(const Shape &shape, int x, int y, Tetrimino type) {
+    for (int i = 0; i < 4; ++i) {
+      int row = y + i;
+      if (shape.mRows[i] == 0 || row < 0 || row >= nHeight) {
+        continue;
+      }
+      mRows[row + nPadRows] |=
+          (RowMask)((RowMask)shape.mRows[i] << (x + nWallBits));
+      for (int j = 0; j < 4; ++j) {
+        if (shape.Filled(i, j)) {
+          mTypes[row][x + j] = type;
+          if (row < mSkyline[x + j]) {
+            mSkyline[x + j] = (signed char)row;
+          }
+        }
+      }
+    }
+  }
+
+  // Remove all complete rows and collapse the rows above them. The indices of
+  // the removed rows are written into clearedRows from the bottom up and the
+  // number of removed rows is returned.
+  int ClearFullRows(int clearedRows[4]) {
+    int clearedCount = 0;
+    int write = nHeight - 1;
+    for (int read = nHeight - 1; read >= 0; --read) {
+      RowMask row = mRows[read + nPadRows];
+      if (row == nFullRow) {
+        clearedRows[clearedCount++] = read;
+        continue;
+      }
+      if (write != read) {
+        mRows[write + nPadRows] = row;
+        memcpy(mTypes[write], mTypes[read], sizeof(mTypes[write]));
+      }
+      --write;
+    }
+    for (; write >= 0 && clearedCount > 0; --write) {
+      mRows[write + nPadRows] = nEmptyRow;
+      memset(mTypes[write], (int)Tetrimino::None, sizeof(mTypes[write]));
+    }
+    if (clearedCount > 0) {
+      UpdateSkyline();
+    }
+    return clearedCount;
+  }
+};
+
+// The board that is shown and that the bot, replays and batches play on.
+typedef BasicBoard<StandardGeometry> Board;
+typedef Board::RowMask RowMask;
+
+} // namespace Core
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef core_Dirty_h
+#define core_Dirty_h
+
+#include "core/Board.h"
+
+namespace Core {
+
+// Tracks which cells of the grid and which slots of the queue changed their
+// appearance since presentation last caught up. Presentation walks the dirty
+// bits, pushes only those cells and then clears the set.
+template <typename G>
+struct BasicDirtySet {
+  typedef typename G::ColumnMask ColumnMask;
+  static constexpr ColumnMask nAllColumns =
+      (ColumnMask)(((uint64_t)1 << G::nWidth) - 1);
+
+  // Bit j of a row is set when the cell in column j changed.
+  ColumnMask mRows[G::nHeight];
+  // Bit i is set when the tetrimino at index i of the preview changed. Slots
+  // past the first 32 are always considered dirty.
+  unsigned int mQueueSlots;
+
+  void Clear() {
+    memset(mRows, 0, sizeof(mRows));
+    mQueueSlots = 0;
+  }
+
+  void MarkAll() {
+    for (int i = 0; i < G::nHeight; ++i) {
+      mRows[i] = nAllColumns;
+    }
+    mQueueSlots = ~0u;
+  }
+
+  // Mark every cell of the rows in [first, last].
+  void MarkRows(int first, int last) {
+    for (int i = first; i <= last; ++i) {
+      mRows[i] = nAllColumns;
+    }
+  }
+
+  // Mark the cells of a row whose bits are set in columns.
+  void MarkColumns(int row, ColumnMask columns) {
+    mRows[row] |= (ColumnMask)(columns & nAllColumns);
+  }
+
+  // Mark the cells covered by a shape with its top left corner at the given
+  // column and row.
+  void MarkShape(const Shape &shape, int x, int y) {
+    for (int i = shape.mMinRow; i <= shape.mMaxRow; ++i) {
+      int row = y + i;
+      if (row < 0 || row >= G::nHeight) {
+        continue;
+      }
+      ColumnMask bits = x >= 0 ? (ColumnMask)((ColumnMask)shape.mRows[i] << x)
+                               : (ColumnMask)(shape.mRows[i] >> -x);
+      mRows[row] |= (ColumnMask)(bits & nAllColumns);
+    }
+  }
+
+  void MarkQueueSlot(int slot) {
+    if (slot < 32) {
+      mQueueSlots |= 1u << slot;
+    }
+  }
+
+  bool RowDirty(int row) const {
+    return mRows[row] != 0;
+  }
+
+  bool CellDirty(int row, int column) const {
+    return (mRows[row] >> column) & 1;
+  }
+
+  bool QueueSlotDirty(int slot) const {
+    return slot >= 32 || ((mQueueSlots >> slot) & 1);
+  }
+};
+
+typedef BasicDirtySet<StandardGeometry> DirtySet;
+
+} // namespace Core
+
+#endif
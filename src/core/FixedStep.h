@@ -0,0 +1,43 @@
+#ifndef core_FixedStep_h
+#define core_FixedStep_h
+
+namespace Core {
+
+// The rate that games are stepped at unless they ask for a different one.
+#define DEFAULT_TICK_RATE 60
+
+// Turns frames of any length into steps of a fixed length. Frame time builds
+// up in an accumulator and every whole tick of it is one step. A frame that
+// would need more than mMaxCatchUp steps only runs that many and drops the
+// rest of its time, so a long stall slows the game down for a moment rather
+// than stalling the frames that follow it with a burst of steps.
+struct FixedStep {
+  float mTickTime;
+  int mMaxCatchUp;
+  float mAccumulator;
+
+  void Init(float tickTime, int maxCatchUp) {
+    mTickTime = tickTime;
+    mMaxCatchUp = maxCatchUp;
+    mAccumulator = 0.0f;
+  }
+
+  // Add the time of a frame and return the number of steps to take.
+  int Advance(float dt) {
+    mAccumulator += dt;
+    int ticks = (int)(mAccumulator / mTickTime);
+    mAccumulator -= (float)ticks * mTickTime;
+    return ticks < mMaxCatchUp ? ticks : mMaxCatchUp;
+  }
+
+  // How far the current time is between the most recent step and the next
+  // one, in [0, 1).
+  float Alpha() const {
+    float alpha = mAccumulator / mTickTime;
+    return alpha < 1.0f ? alpha : 1.0f;
+  }
+};
+
+} // namespace Core
+
+#endif
@@ -0,0 +1,466 @@
+#include <math.h>
+
+#include "core/Game.h"
+#include "core/Profile.h"
+
+namespace Core {
+
+template <typename G>
+bool KickRotation(
+    const typename G::RowMask *rows, const Shape &shape, int *x, int *y) {
+  for (int i = 0; i < nKickCount; ++i) {
+    int kickedX = *x + nKicks[i][0];
+    int kickedY = *y + nKicks[i][1];
+    if (BasicBoard<G>::Fits(rows, shape, kickedX, kickedY)) {
+      *x += nKicks[i][0];
+      *y += nKicks[i][1];
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename G>
+bool KickRotation(
+    const BasicBoard<G> &board, const Shape &shape, int *x, int *y) {
+  return KickRotation<G>(board.mRows, shape, x, y);
+}
+
+template <typename G>
+void RotateActive(const typename G::RowMask *rows, Tetrimino tetrimino,
+                  Inputs pressed, int *rotation, int *x, int *y) {
+  int newRotation = *rotation;
+  if (pressed & Key::RotateCcw) {
+    newRotation = (newRotation + 1) % 4;
+  }
+  if (pressed & Key::RotateCw) {
+    newRotation = (newRotation + 3) % 4;
+  }
+  if (newRotation == *rotation) {
+    return;
+  }
+  if (KickRotation<G>(rows, GetShape(tetrimino, newRotation), x, y)) {
+    *rotation = newRotation;
+  }
+}
+
+template <typename G>
+void ShiftActive(const typename G::RowMask *rows, const Shape &shape,
+                 const StepKeys &keys, const RuleTiming &timing, float dt,
+                 int *x, int y, float *timeSinceLastShift) {
+  // Reset the time since last shift so that a shift instantly happens when
+  // the left or right arrow is pressed again.
+  const Inputs shifts = Key::Left | Key::Right;
+  float shiftTimeGap = 1.0f / timing.mShiftRate;
+  if (keys.mReleased & shifts) {
+    *timeSinceLastShift = shiftTimeGap;
+  }
+  if ((keys.mHeld & shifts) == 0) {
+    return;
+  }
+
+  // Perform every shift that the elapsed time allows for, so a long step
+  // shifts as far as the same time split over short steps would. The shift
+  // made when a key goes down is followed by the delay rather than a gap.
+  // A tetrimino that is blocked or has crossed the grid moves no further, so
+  // the whole gaps that are left are dropped at once.
+  float nextGap = keys.mPressed & shifts ? timing.mShiftDelay : shiftTimeGap;
+  *timeSinceLastShift += dt;
+  int shifted = 0;
+  while (*timeSinceLastShift >= shiftTimeGap) {
+    int before = *x;
+    if (keys.mHeld & Key::Left) {
+      if (BasicBoard<G>::Fits(rows, shape, *x - 1, y)) {
+        --*x;
+      }
+      *timeSinceLastShift -= nextGap;
+      nextGap = shiftTimeGap;
+    }
+    if (keys.mHeld & Key::Right) {
+      if (BasicBoard<G>::Fits(rows, shape, *x + 1, y)) {
+        ++*x;
+      }
+      *timeSinceLastShift -= nextGap;
+      nextGap = shiftTimeGap;
+    }
+    if (*x == before || ++shifted == G::nWidth) {
+      if (*timeSinceLastShift >= shiftTimeGap) {
+        *timeSinceLastShift = fmodf(*timeSinceLastShift, shiftTimeGap);
+      }
+      break;
+    }
+  }
+}
+
+template <typename G>
+bool DropActive(const typename G::RowMask *rows, const signed char *skyline,
+                const Shape &shape, const StepKeys &keys,
+                const RuleTiming &timing, float dt, int x, int *y,
+                int *lowestY, float *timeSinceLastDrop, float *timeResting) {
+  // Holding down never drops slower than gravity does.
+  float dropRate = timing.mDropRate;
+  if ((keys.mHeld & Key::Down) && timing.mFastDropRate > dropRate) {
+    dropRate = timing.mFastDropRate;
+  }
+  float dropTimeGap = 1.0f / dropRate;
+
+  // Time that built up at one rate is not carried over to the other, so
+  // pressing down drops by a single row right away rather than by every row
+  // the slow rate was waiting on.
+  if (((keys.mPressed | keys.mReleased) & Key::Down) &&
+      *timeSinceLastDrop > dropTimeGap) {
+    *timeSinceLastDrop = dropTimeGap;
+  }
+
+  // A hard drop lands and locks the tetrimino within the step.
+  if (keys.mPressed & Key::HardDrop) {
+    *y += BasicBoard<G>::DropDistance(rows, skyline, shape, x, *y);
+    *timeSinceLastDrop = 0.0f;
+    return true;
+  }
+
+  // Drop by every row that the elapsed time allows for. The distance to the
+  // stack is known up front, so gravity of many rows per step costs no more
+  // than gravity of one.
+  *timeSinceLastDrop += dt;
+  *timeResting += dt;
+  if (!(*timeSinceLastDrop > dropTimeGap)) {
+    return false;
+  }
+  int distance = BasicBoard<G>::DropDistance(rows, skyline, shape, x, *y);
+  while (distance > 0 && *timeSinceLastDrop > dropTimeGap) {
+    *timeSinceLastDrop -= dropTimeGap;
+    ++*y;
+    --distance;
+    if (*y > *lowestY) {
+      *lowestY = *y;
+      *timeResting = 0.0f;
+    }
+  }
+  // A tetrimino that just landed waits out one more gap before locking.
+  if (distance > 0 || !(*timeSinceLastDrop > dropTimeGap)) {
+    return false;
+  }
+
+  // A tetrimino without room to fall locks once the lock delay is over. The
+  // drop timer is held at a gap during the delay so that a tetrimino moved off
+  // a ledge falls one row at a time. Time left over after locking is discarded
+  // so the next tetrimino starts with less than a gap.
+  if (*timeResting < timing.mLockDelay) {
+    *timeSinceLastDrop = dropTimeGap;
+    return false;
+  }
+  *timeSinceLastDrop -= dropTimeGap;
+  if (dropTimeGap == 0.0f) {
+    *timeSinceLastDrop = 0.0f;
+  }
+  if (*timeSinceLastDrop > dropTimeGap) {
+    *timeSinceLastDrop = fmodf(*timeSinceLastDrop, dropTimeGap);
+  }
+  return true;
+}
+
+template <typename G>
+void BasicGame<G>::Init(unsigned long long seed, int previewLength) {
+  mBoard.Clear();
+  mPreviewLength = previewLength;
+  if (mPreviewLength < 1) {
+    mPreviewLength = 1;
+  } else if (mPreviewLength > PieceQueue::nCapacity) {
+    mPreviewLength = PieceQueue::nCapacity;
+  }
+
+  mStartDropRate = 1.0f;
+  mFastDropRate = 20.0f;
+  mLockDelay = 0.0f;
+  mShiftRate = 10.0f;
+  mShiftDelay = 1.0f / mShiftRate;
+
+  mMarkedTetrimino = Tetrimino::None;
+  Reseed(seed);
+  mDirty.MarkAll();
+}
+
+template <typename G>
+void BasicGame<G>::Reseed(unsigned long long seed) {
+  mQueue.Init(seed);
+  mQueue.Peek(mPreviewLength - 1);
+  for (int i = 0; i < mPreviewLength; ++i) {
+    mDirty.MarkQueueSlot(i);
+  }
+
+  mActiveTetrimino = Tetrimino::None;
+  mShapeRotation = 0;
+  mActiveX = 0;
+  mActiveY = 0;
+  if (mMarkedTetrimino != Tetrimino::None) {
+    mDirty.MarkShape(
+        GetShape(mMarkedTetrimino, mMarkedRotation), mMarkedX, mMarkedY);
+    mMarkedTetrimino = Tetrimino::None;
+  }
+
+  mDropRate = mStartDropRate;
+  mTimeSinceLastDrop = 0.0f;
+  mTimeResting = 0.0f;
+  mLowestY = 0;
+  mTimeSinceLastShift = 1.0f / mShiftRate;
+
+  mLines = 0;
+  mRunning = false;
+
+  mHeld = 0;
+  mPressed = 0;
+  mReleased = 0;
+  mEvents = 0;
+  mClearedRowCount = 0;
+}
+
+template <typename G>
+void BasicGame<G>::Step(Inputs inputs, float dt) {
+  PROFILE_ZONE(Zone::Step);
+  dt = ClampStepTime(dt);
+  mPressed = inputs & ~mHeld;
+  mReleased = mHeld & ~inputs;
+  mHeld = inputs;
+  mEvents = 0;
+  mClearedRowCount = 0;
+
+  if (!mRunning) {
+    if (KeyPressed(Key::Down)) {
+      StartGame();
+    }
+    return;
+  }
+
+  if (mActiveTetrimino == Tetrimino::None) {
+    SpawnTetrimino();
+  }
+
+  HandleRotation();
+  HandleHorizontalShift(ActiveShape(), dt);
+  HandleDrop(ActiveShape(), dt);
+  MarkActiveFootprint();
+}
+
+template <typename G>
+void BasicGame<G>::StartGame() {
+  // Clearing the board only changes the locked cells and the cells of the
+  // last active tetrimino, so the empty cells are not presented again.
+  int top = Board::nHeight;
+  for (int j = 0; j < Board::nWidth; ++j) {
+    top = mBoard.mSkyline[j] < top ? mBoard.mSkyline[j] : top;
+  }
+  for (int i = top; i < Board::nHeight; ++i) {
+    typename Board::RowMask row = mBoard.mRows[Board::nPadRows + i];
+    mDirty.MarkColumns(i, (typename DirtySet::ColumnMask)(
+                              row >> Board::nWallBits));
+  }
+  if (mMarkedTetrimino != Tetrimino::None) {
+    mDirty.MarkShape(
+        GetShape(mMarkedTetrimino, mMarkedRotation), mMarkedX, mMarkedY);
+  }
+  mBoard.Clear();
+  mActiveTetrimino = Tetrimino::None;
+  mLines = 0;
+  mDropRate = mStartDropRate;
+  mRunning = true;
+  mEvents |= Event::Started;
+  mMarkedTetrimino = Tetrimino::None;
+}
+
+template <typename G>
+Tetrimino BasicGame<G>::Preview(int index) const {
+  return mQueue.Peeked(index);
+}
+
+template <typename G>
+StepKeys BasicGame<G>::Keys() const {
+  return {mHeld, mPressed, mReleased};
+}
+
+template <typename G>
+RuleTiming BasicGame<G>::Timing() const {
+  return {mDropRate, mFastDropRate, mLockDelay, mShiftRate, mShiftDelay};
+}
+
+template <typename G>
+const Shape &BasicGame<G>::ActiveShape() const {
+  return GetShape(mActiveTetrimino, mShapeRotation);
+}
+
+template <typename G>
+int BasicGame<G>::GhostY() const {
+  return mActiveY + mBoard.DropDistance(ActiveShape(), mActiveX, mActiveY);
+}
+
+template <typename G>
+bool BasicGame<G>::CanMoveShape(const Shape &shape, int x, int y) const {
+  return mBoard.Fits(shape, mActiveX + x, mActiveY + y);
+}
+
+template <typename G>
+void BasicGame<G>::HandleRotation() {
+  PROFILE_ZONE(Zone::Rotation);
+  RotateActive<G>(mBoard.mRows, mActiveTetrimino, mPressed, &mShapeRotation,
+                  &mActiveX, &mActiveY);
+}
+
+template <typename G>
+void BasicGame<G>::HandleHorizontalShift(const Shape &shape, float dt) {
+  PROFILE_ZONE(Zone::Shift);
+  ShiftActive<G>(mBoard.mRows, shape, Keys(), Timing(), dt, &mActiveX,
+                 mActiveY, &mTimeSinceLastShift);
+}
+
+template <typename G>
+void BasicGame<G>::HandleDrop(const Shape &shape, float dt) {
+  PROFILE_ZONE(Zone::Drop);
+  if (DropActive<G>(mBoard.mRows, mBoard.mSkyline, shape, Keys(), Timing(),
+                    dt, mActiveX, &mActiveY, &mLowestY, &mTimeSinceLastDrop,
+                    &mTimeResting)) {
+    LockActiveTetrimino(shape);
+  }
+}
+
+template <typename G>
+void BasicGame<G>::LockActiveTetrimino(const Shape &shape) {
+  PROFILE_ZONE(Zone::Lock);
+  // Lock the cells that the active tetrimino occupies. The game is over if
+  // part of the shape is above the visible grid.
+  for (int i = 0; i < 4; ++i) {
+    if (shape.mRows[i] != 0 && mActiveY + i < Board::nBufferRows) {
+      EndGame();
+    }
+  }
+  mBoard.Lock(shape, mActiveX, mActiveY, mActiveTetrimino);
+  mDirty.MarkShape(shape, mActiveX, mActiveY);
+  mEvents |= Event::Locked;
+
+  // Delete complete rows.
+  mClearedRowCount = mBoard.ClearFullRows(mClearedRows);
+  int collapseDistance = mClearedRowCount;
+  if (collapseDistance > 0) {
+    // Every row above the lowest cleared row has moved.
+    mDirty.MarkRows(0, mClearedRows[0]);
+  }
+  mActiveTetrimino = Tetrimino::None;
+
+  // Update the score and increase the drop rate if a threshold is passed.
+  if (collapseDistance == 0) {
+    return;
+  }
+  mEvents |= Event::RowsCleared;
+  for (int i = 1; i <= collapseDistance; ++i) {
+    if ((mLines + i) % 10 == 0 && mLines > 0) {
+      mDropRate += 1.0f;
+      mEvents |= Event::RateIncreased;
+    }
+  }
+  mLines += collapseDistance;
+}
+
+template <typename G>
+void BasicGame<G>::SpawnTetrimino() {
+  PROFILE_ZONE(Zone::Spawn);
+  mShapeRotation = 0;
+  mActiveTetrimino = mQueue.Pop();
+  mActiveX = nSpawnX;
+  mActiveY = nSpawnY;
+  mTimeResting = 0.0f;
+  mLowestY = nSpawnY;
+
+  // Handle changes to the tetrimino queue.
+  // Every slot of the preview moves forward by one.
+  Tetrimino previous = mActiveTetrimino;
+  mQueue.Peek(mPreviewLength - 1);
+  for (int i = 0; i < mPreviewLength; ++i) {
+    Tetrimino current = Preview(i);
+    if (current != previous) {
+      mDirty.MarkQueueSlot(i);
+    }
+    previous = current;
+  }
+  mEvents |= Event::Spawned;
+
+  // The game is over if the tetrimino spawns on any locked cells.
+  if (!CanMoveShape(ActiveShape(), 0, 0)) {
+    EndGame();
+  }
+}
+
+template <typename G>
+void BasicGame<G>::EndGame() {
+  mRunning = false;
+  mEvents |= Event::Ended;
+}
+
+template <typename G>
+void BasicGame<G>::MarkActiveFootprint() {
+  if (mActiveTetrimino == mMarkedTetrimino &&
+      mShapeRotation == mMarkedRotation && mActiveX == mMarkedX &&
+      mActiveY == mMarkedY) {
+    return;
+  }
+  if (mMarkedTetrimino != Tetrimino::None) {
+    const Shape &marked = GetShape(mMarkedTetrimino, mMarkedRotation);
+    mDirty.MarkShape(marked, mMarkedX, mMarkedY);
+  }
+  if (mActiveTetrimino != Tetrimino::None) {
+    mDirty.MarkShape(ActiveShape(), mActiveX, mActiveY);
+  }
+  mMarkedTetrimino = mActiveTetrimino;
+  mMarkedRotation = mShapeRotation;
+  mMarkedX = mActiveX;
+  mMarkedY = mActiveY;
+}
+
+template <typename G>
+Tetrimino BasicGame<G>::VisibleType(int row, int column) const {
+  if (mActiveTetrimino != Tetrimino::None) {
+    int shapeRow = row - mActiveY;
+    int shapeColumn = column - mActiveX;
+    if (shapeRow >= 0 && shapeRow < 4 && shapeColumn >= 0 &&
+        shapeColumn < 4 && ActiveShape().Filled(shapeRow, shapeColumn)) {
+      return mActiveTetrimino;
+    }
+  }
+  return mBoard.Type(row, column);
+}
+
+template <typename G>
+bool BasicGame<G>::KeyDown(unsigned char key) const {
+  return (mHeld & key) != 0;
+}
+
+template <typename G>
+bool BasicGame<G>::KeyPressed(unsigned char key) const {
+  return (mPressed & key) != 0;
+}
+
+template <typename G>
+bool BasicGame<G>::KeyReleased(unsigned char key) const {
+  return (mReleased & key) != 0;
+}
+
+// The geometries that games are played on. See core/Geometry.h.
+#define INSTANTIATE_RULES(G)                                                 \
+  template struct BasicGame<G>;                                              \
+  template bool KickRotation<G>(                                             \
+      const G::RowMask *, const Shape &, int *, int *);                      \
+  template bool KickRotation(                                                \
+      const BasicBoard<G> &, const Shape &, int *, int *);                   \
+  template void RotateActive<G>(                                             \
+      const G::RowMask *, Tetrimino, Inputs, int *, int *, int *);           \
+  template void ShiftActive<G>(const G::RowMask *, const Shape &,            \
+                               const StepKeys &, const RuleTiming &, float,  \
+                               int *, int, float *);                         \
+  template bool DropActive<G>(const G::RowMask *, const signed char *,       \
+                              const Shape &, const StepKeys &,               \
+                              const RuleTiming &, float, int, int *, int *,  \
+                              float *, float *);
+INSTANTIATE_RULES(StandardGeometry)
+INSTANTIATE_RULES(WideGeometry)
+INSTANTIATE_RULES(StressGeometry)
+#undef INSTANTIATE_RULES
+
+} // namespace Core
@@ -0,0 +1,234 @@
+#ifndef core_Game_h
+#define core_Game_h
+
+#include "core/Board.h"
+#include "core/Dirty.h"
+#include "core/Random.h"
+#include "core/Shapes.h"
+
+// The rules of the game live here without any dependency on the engine. A game
+// is advanced by calling Step with the keys that are held down and the amount
+// of time that has passed. Everything that presentation needs to know about is
+// reported through the events that the most recent step produced.
+namespace Core {
+
+// The number of upcoming tetriminos that are previewed unless a game asks for
+// a different number.
+#define DEFAULT_PREVIEW_LENGTH 3
+
+// The longest time in seconds that one step covers. Longer steps only come from
+// a stalled or broken clock and are shortened to this.
+constexpr float nMaxStepTime = 1.0f;
+
+// The step time the rules use for a given one. Times that are not finite or
+// not positive cover no time, which keeps every loop of a step bounded.
+inline float ClampStepTime(float dt) {
+  if (!(dt > 0.0f)) {
+    return 0.0f;
+  }
+  return dt < nMaxStepTime ? dt : nMaxStepTime;
+}
+
+// The lock delay in seconds of games that start at 20G unless they ask for
+// another. Without one a tetrimino locks on the step it spawns.
+constexpr float nTwentyGLockDelay = 0.5f;
+
+// The keys that the game responds to. A step receives the keys that are held
+// down as a bitfield of these values.
+namespace Key {
+constexpr unsigned char Left = 1 << 0;
+constexpr unsigned char Right = 1 << 1;
+constexpr unsigned char Down = 1 << 2;
+constexpr unsigned char RotateCcw = 1 << 3;
+constexpr unsigned char RotateCw = 1 << 4;
+constexpr unsigned char HardDrop = 1 << 5;
+} // namespace Key
+typedef unsigned char Inputs;
+
+// The things that happened during a step. Presentation reacts to these.
+namespace Event {
+constexpr unsigned int Started = 1 << 0;
+constexpr unsigned int Spawned = 1 << 1;
+constexpr unsigned int Locked = 1 << 2;
+constexpr unsigned int RowsCleared = 1 << 3;
+constexpr unsigned int RateIncreased = 1 << 4;
+constexpr unsigned int Ended = 1 << 5;
+} // namespace Event
+typedef unsigned int Events;
+
+// The offsets a rotated shape is tried at: in place, then right, down, left
+// and up.
+constexpr int nKickCount = 5;
+constexpr int nKicks[nKickCount][2] = {
+    {0, 0}, {1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+
+// The keys held during a step and the keys that went down and came up since
+// the step before it.
+struct StepKeys {
+  Inputs mHeld;
+  Inputs mPressed;
+  Inputs mReleased;
+};
+
+// How fast the active tetrimino moves. The rates are per second and the delays
+// are in seconds. BasicGame describes each of them.
+struct RuleTiming {
+  float mDropRate;
+  float mFastDropRate;
+  float mLockDelay;
+  float mShiftRate;
+  float mShiftDelay;
+};
+
+// The rules that move the active tetrimino. They only read the rows of a board,
+// laid out like BasicBoard::mRows, and its skyline, and only write the pose and
+// timers they are given, so BasicGame and Core::Versus, which stores its boards
+// by field, play by the same rules. Game.cc instantiates them for every
+// geometry.
+
+// Try to place a shape that was just rotated at the given position. If it does
+// not fit, the shape is kicked to the first of nKicks that fits and the
+// position is updated. False is returned when none of the positions fit.
+template <typename G>
+bool KickRotation(
+    const typename G::RowMask *rows, const Shape &shape, int *x, int *y);
+template <typename G>
+bool KickRotation(
+    const BasicBoard<G> &board, const Shape &shape, int *x, int *y);
+
+// Rotate by the rotation keys that were pressed and kick the shape into place.
+// The rotation is kept when none of the kicks fit.
+template <typename G>
+void RotateActive(const typename G::RowMask *rows, Tetrimino tetrimino,
+                  Inputs pressed, int *rotation, int *x, int *y);
+
+// Shift by every column that the elapsed time allows for.
+template <typename G>
+void ShiftActive(const typename G::RowMask *rows, const Shape &shape,
+                 const StepKeys &keys, const RuleTiming &timing, float dt,
+                 int *x, int y, float *timeSinceLastShift);
+
+// Drop by every row that the elapsed time allows for, or onto the stack when
+// hard drop was pressed. True is returned when the tetrimino locks during the
+// step, in which case it locks at the row that y is left at. The resting time
+// restarts when the tetrimino falls below lowestY, the lowest row it reached.
+template <typename G>
+bool DropActive(const typename G::RowMask *rows, const signed char *skyline,
+                const Shape &shape, const StepKeys &keys,
+                const RuleTiming &timing, float dt, int x, int *y,
+                int *lowestY, float *timeSinceLastDrop, float *timeResting);
+
+// A game on a board of the given geometry. The members are defined in Game.cc,
+// which instantiates the game for every geometry in core/Geometry.h.
+template <typename G>
+struct BasicGame {
+  typedef BasicBoard<G> Board;
+  typedef BasicDirtySet<G> DirtySet;
+
+  // Where tetriminos appear when they are spawned.
+  static constexpr int nSpawnX = G::nWidth / 2 - 2;
+  static constexpr int nSpawnY = 0;
+
+  // The full grid that the game is played on. Only locked cells are stored in
+  // the board. The active tetrimino is described by the values below.
+  Board mBoard;
+
+  // The queue of upcoming tetriminos. The first mPreviewLength tetriminos of
+  // the queue are always generated, so they can be looked at with Preview.
+  PieceQueue mQueue;
+  int mPreviewLength;
+
+  // Values for specifying where and what the active tetrimino is.
+  Tetrimino mActiveTetrimino;
+  int mShapeRotation;
+  int mActiveX;
+  int mActiveY;
+
+  // Values used for controlling vertical dropping. The drop rates are in rows
+  // per second and may be any number of rows per step. A rate of infinity
+  // drops a tetrimino onto the stack the moment it appears or moves, which is
+  // known as 20G. Every game starts at mStartDropRate, which Init sets to 1.
+  float mDropRate;
+  float mStartDropRate;
+  float mFastDropRate;
+  float mTimeSinceLastDrop;
+  // The least time a tetrimino rests on the stack before it locks. A tetrimino
+  // otherwise locks once a drop gap passes without room to fall, which leaves
+  // no time to move it at high drop rates. The resting time is the time since
+  // the tetrimino last fell below mLowestY, the lowest row it reached, so a
+  // rotation that kicks it up and lets it fall back does not hold it forever.
+  float mLockDelay;
+  float mTimeResting;
+  int mLowestY;
+
+  // Values used for controlling horizontal shifting. A held shift key shifts
+  // once when it goes down, waits mShiftDelay and then repeats at mShiftRate
+  // shifts per second.
+  float mShiftRate;
+  float mShiftDelay;
+  float mTimeSinceLastShift;
+
+  // The number of completed lines.
+  int mLines;
+
+  // Keep track of whether the game is running.
+  bool mRunning;
+
+  // The keys held during the previous step and the keys that were pressed and
+  // released during the current step.
+  Inputs mHeld;
+  Inputs mPressed;
+  Inputs mReleased;
+
+  // What happened during the most recent step. The cleared rows are given in
+  // grid coordinates from the bottom of the grid upwards and they refer to the
+  // grid as it was before the rows were removed.
+  Events mEvents;
+  int mClearedRows[4];
+  int mClearedRowCount;
+
+  // The cells and queue slots that need to be presented again. The marked
+  // values are the active tetrimino as it was when its footprint was last
+  // added to the dirty set.
+  DirtySet mDirty;
+  Tetrimino mMarkedTetrimino;
+  int mMarkedRotation;
+  int mMarkedX;
+  int mMarkedY;
+
+  void Init(
+      unsigned long long seed, int previewLength = DEFAULT_PREVIEW_LENGTH);
+  // Leave the game as Init with the seed would, but keep the board and the
+  // settings. Only the queue and the last active tetrimino are marked dirty,
+  // so a restart that follows repaints just the cells StartGame clears.
+  void Reseed(unsigned long long seed);
+  void Step(Inputs inputs, float dt);
+  void StartGame();
+
+  Tetrimino Preview(int index) const;
+  StepKeys Keys() const;
+  RuleTiming Timing() const;
+  const Shape &ActiveShape() const;
+  // The row the active tetrimino would land on if it were dropped now.
+  int GhostY() const;
+  bool CanMoveShape(const Shape &shape, int x, int y) const;
+  void HandleRotation();
+  void HandleHorizontalShift(const Shape &shape, float dt);
+  void HandleDrop(const Shape &shape, float dt);
+  void LockActiveTetrimino(const Shape &shape);
+  void SpawnTetrimino();
+  void EndGame();
+  void MarkActiveFootprint();
+  Tetrimino VisibleType(int row, int column) const;
+
+  bool KeyDown(unsigned char key) const;
+  bool KeyPressed(unsigned char key) const;
+  bool KeyReleased(unsigned char key) const;
+};
+
+// The game that is shown and that the bot, replays and batches play.
+typedef BasicGame<StandardGeometry> Game;
+
+} // namespace Core
+
+#endif
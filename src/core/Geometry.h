@@ -0,0 +1,49 @@
+#ifndef core_Geometry_h
+#define core_Geometry_h
+
+#include <stdint.h>
+
+#include <type_traits>
+
+namespace Core {
+
+// The smallest unsigned integer with at least the given number of bits.
+template <int Bits>
+struct MaskFor {
+  static_assert(Bits <= 64, "A row of the board must fit in 64 bits.");
+  typedef typename std::conditional<
+      Bits <= 16,
+      uint16_t,
+      typename std::conditional<Bits <= 32, uint32_t, uint64_t>::type>::type
+      Type;
+};
+
+// The size of a board. The grid is nWidth columns of nVisibleHeight visible
+// rows, and nBufferRows invisible rows sit above them so that tetriminos can
+// be spawned there. Everything that depends on the size of the board is a
+// template over one of these, so every size gets loops with constant bounds
+// and a row mask that is no wider than it needs to be.
+template <int Width, int VisibleHeight, int BufferRows>
+struct Geometry {
+  static constexpr int nWidth = Width;
+  static constexpr int nVisibleHeight = VisibleHeight;
+  static constexpr int nBufferRows = BufferRows;
+  static constexpr int nHeight = VisibleHeight + BufferRows;
+
+  // A row holds the columns of the grid with three bits of wall on either
+  // side, which is as far as a 4x4 shape can hang over an edge.
+  static constexpr int nWallBits = 3;
+  typedef typename MaskFor<nWallBits + Width + nWallBits>::Type RowMask;
+  typedef typename MaskFor<Width>::Type ColumnMask;
+};
+
+// The geometries that games are compiled for. Game.cc instantiates the game
+// for each of them. The standard geometry is the one that is shown, recorded
+// and played by the bot.
+typedef Geometry<10, 20, 2> StandardGeometry;
+typedef Geometry<20, 20, 2> WideGeometry;
+typedef Geometry<50, 100, 4> StressGeometry;
+
+} // namespace Core
+
+#endif
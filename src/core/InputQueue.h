@@ -0,0 +1,126 @@
+#ifndef core_InputQueue_h
+#define core_InputQueue_h
+
+#include "core/Game.h"
+
+namespace Core {
+
+// A key going down or up. The time is in seconds on the clock of whoever
+// produced the event, which is the clock steps are given in.
+struct KeyEvent {
+  double mTime;
+  Inputs mKey;
+  bool mDown;
+};
+
+// A stretch of a step during which the same keys are held. The event time is
+// when the event that started the stretch happened, or negative for a stretch
+// that does not start with an event.
+struct TimedStep {
+  Inputs mInputs;
+  float mDt;
+  double mEventTime;
+};
+
+// Key events waiting to be applied to a game, oldest first. A step is split
+// at the events that happen within it, so every key changes at the time it
+// happened rather than at the next step. A key that is pressed and released
+// within one step still gets a stretch of its own, and the repeat of a held
+// shift starts from when the key went down. The queue is a fixed ring, so
+// producing and consuming events never allocates. Events pushed while the
+// ring is full are dropped and counted.
+struct InputQueue {
+  static constexpr int nCapacity = 256;
+
+  KeyEvent mEvents[nCapacity];
+  int mHead;
+  int mCount;
+  long long mDropped;
+  // The keys held after the last event that was taken from the queue.
+  Inputs mHeld;
+
+  void Clear() {
+    mHead = 0;
+    mCount = 0;
+    mDropped = 0;
+    mHeld = 0;
+  }
+
+  bool Push(double time, Inputs key, bool down) {
+    if (mCount == nCapacity) {
+      ++mDropped;
+      return false;
+    }
+    KeyEvent &event = mEvents[(mHead + mCount) % nCapacity];
+    event.mTime = time;
+    event.mKey = key;
+    event.mDown = down;
+    ++mCount;
+    return true;
+  }
+
+  // Push an event for every key that differs between two sets of held keys.
+  void PushChanges(double time, Inputs previous, Inputs current) {
+    Inputs changed = previous ^ current;
+    for (int bit = 0; bit < 8; ++bit) {
+      Inputs key = (Inputs)(1 << bit);
+      if (changed & key) {
+        Push(time, key, (current & key) != 0);
+      }
+    }
+  }
+
+  const KeyEvent &Front() const {
+    return mEvents[mHead];
+  }
+
+  void Pop() {
+    const KeyEvent &event = mEvents[mHead];
+    mHeld = event.mDown ? (Inputs)(mHeld | event.mKey)
+                        : (Inputs)(mHeld & ~event.mKey);
+    mHead = (mHead + 1) % nCapacity;
+    --mCount;
+  }
+
+  // Split the step from start to start + dt at the events that happen before
+  // its end and take those events. Events older than the step take effect at
+  // its start. A stretch without time is only written when it holds keys the
+  // stretch before it did not. At most capacity stretches are written and
+  // their count is returned. Events that do not fit are left for the next
+  // step.
+  int Split(double start, float dt, TimedStep *steps, int capacity) {
+    double end = start + dt;
+    double time = start;
+    double eventTime = -1.0;
+    Inputs given = mHeld;
+    int count = 0;
+    while (count < capacity - 1 && mCount > 0 && Front().mTime < end) {
+      double at = Front().mTime > time ? Front().mTime : time;
+      if (at > time || mHeld != given) {
+        steps[count].mInputs = mHeld;
+        steps[count].mDt = (float)(at - time);
+        steps[count].mEventTime = eventTime;
+        ++count;
+        given = mHeld;
+        time = at;
+      }
+      eventTime = Front().mTime;
+      Pop();
+    }
+    steps[count].mInputs = mHeld;
+    steps[count].mDt = (float)(end - time);
+    steps[count].mEventTime = eventTime;
+    return count + 1;
+  }
+
+  // Take the events that happen before the given time without stepping.
+  void Discard(double end) {
+    while (mCount > 0 && Front().mTime < end) {
+      Pop();
+    }
+  }
+};
+
+} // namespace Core
+
+#endif
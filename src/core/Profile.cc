@@ -0,0 +1,231 @@
+#include "core/Profile.h"
+
+namespace Core {
+
+thread_local Profiler *tProfiler = nullptr;
+
+const char *ZoneName(Zone zone) {
+  switch (zone) {
+  case Zone::Step:
+    return "Step";
+  case Zone::Spawn:
+    return "SpawnTetrimino";
+  case Zone::Rotation:
+    return "HandleRotation";
+  case Zone::Shift:
+    return "HandleHorizontalShift";
+  case Zone::Drop:
+    return "HandleDrop";
+  case Zone::Lock:
+    return "LockActiveTetrimino";
+  case Zone::Present:
+    return "PresentTiles";
+  case Zone::Render:
+    return "Render";
+  default:
+    return "Unknown";
+  }
+}
+
+void Histogram::Clear() {
+  for (int i = 0; i < nBucketCount; ++i) {
+    mCounts[i] = 0;
+  }
+  mCount = 0;
+  mTotal = 0;
+  mMax = 0;
+}
+
+void Histogram::Add(unsigned long long ns) {
+  ++mCounts[Bucket(ns)];
+  ++mCount;
+  mTotal += ns;
+  mMax = ns > mMax ? ns : mMax;
+}
+
+unsigned long long Histogram::Percentile(double percentile) const {
+  if (mCount == 0) {
+    return 0;
+  }
+  unsigned long long rank =
+      (unsigned long long)(percentile / 100.0 * (double)(mCount - 1)) + 1;
+  unsigned long long seen = 0;
+  for (int i = 0; i < nBucketCount; ++i) {
+    seen += mCounts[i];
+    if (seen >= rank) {
+      unsigned long long end = BucketEnd(i);
+      return end < mMax ? end : mMax;
+    }
+  }
+  return mMax;
+}
+
+int Histogram::Bucket(unsigned long long ns) {
+  if (ns < nSubBuckets) {
+    return (int)ns;
+  }
+  int exponent = 2;
+  while (exponent < 63 && (ns >> (exponent + 1)) != 0) {
+    ++exponent;
+  }
+  int sub = (int)(ns >> (exponent - 2)) & (nSubBuckets - 1);
+  int bucket = (exponent - 1) * nSubBuckets + sub;
+  return bucket < nBucketCount ? bucket : nBucketCount - 1;
+}
+
+unsigned long long Histogram::BucketEnd(int bucket) {
+  if (bucket < nSubBuckets) {
+    return (unsigned long long)bucket;
+  }
+  int exponent = bucket / nSubBuckets + 1;
+  int sub = bucket % nSubBuckets;
+  unsigned long long start = (unsigned long long)(nSubBuckets + sub)
+                             << (exponent - 2);
+  return start + (1ull << (exponent - 2)) - 1;
+}
+
+void Profiler::Clear() {
+  for (Histogram &histogram : mHistograms) {
+    histogram.Clear();
+  }
+}
+
+void Profiler::Record(Zone zone, unsigned long long ns) {
+  mHistograms[(int)zone].Add(ns);
+}
+
+void Profiler::WriteCsv(FILE *file) const {
+  fprintf(file, "zone,count,mean_ns,p50_ns,p99_ns,max_ns\n");
+  for (int i = 0; i < nZoneCount; ++i) {
+    const Histogram &histogram = mHistograms[i];
+    unsigned long long mean =
+        histogram.mCount > 0 ? histogram.mTotal / histogram.mCount : 0;
+    fprintf(file, "%s,%llu,%llu,%llu,%llu,%llu\n", ZoneName((Zone)i),
+            histogram.mCount, mean, histogram.Percentile(50.0),
+            histogram.Percentile(99.0), histogram.mMax);
+  }
+}
+
+void Profiler::WriteJson(FILE *file) const {
+  // Every zone lists its non-empty buckets as pairs of the bucket's upper
+  // bound and its count, so the distribution can be rebuilt offline.
+  fprintf(file, "{\n  \"zones\": [");
+  for (int i = 0; i < nZoneCount; ++i) {
+    const Histogram &histogram = mHistograms[i];
+    unsigned long long mean =
+        histogram.mCount > 0 ? histogram.mTotal / histogram.mCount : 0;
+    fprintf(file,
+            "%s\n    {\"name\": \"%s\", \"count\": %llu, \"mean_ns\": %llu, "
+            "\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, "
+            "\"buckets\": [",
+            i == 0 ? "" : ",", ZoneName((Zone)i), histogram.mCount, mean,
+            histogram.Percentile(50.0), histogram.Percentile(99.0),
+            histogram.mMax);
+    bool first = true;
+    for (int j = 0; j < Histogram::nBucketCount; ++j) {
+      if (histogram.mCounts[j] == 0) {
+        continue;
+      }
+      fprintf(file, "%s[%llu, %llu]", first ? "" : ", ",
+              Histogram::BucketEnd(j), histogram.mCounts[j]);
+      first = false;
+    }
+    fprintf(file, "]}");
+  }
+  fprintf(file, "\n  ]\n}\n");
+}
+
+int Profiler::Summarize(char *buffer, int size) const {
+  int length = snprintf(buffer, size, "%-22s %8s %8s %8s %8s\n", "zone (us)",
+                        "count", "p50", "p99", "max");
+  for (int i = 0; i < nZoneCount && length < size; ++i) {
+    const Histogram &histogram = mHistograms[i];
+    length += snprintf(buffer + length, size - length,
+                       "%-22s %8llu %8.1f %8.1f %8.1f\n", ZoneName((Zone)i),
+                       histogram.mCount, histogram.Percentile(50.0) / 1000.0,
+                       histogram.Percentile(99.0) / 1000.0,
+                       histogram.mMax / 1000.0);
+  }
+  return length < size ? length : size - 1;
+}
+
+void AttachProfiler(Profiler *profiler) {
+  tProfiler = profiler;
+}
+
+const char *StartupPhaseName(StartupPhase phase) {
+  switch (phase) {
+  case StartupPhase::Engine:
+    return "Engine";
+  case StartupPhase::Rules:
+    return "Rules";
+  case StartupPhase::Tiles:
+    return "Tiles";
+  case StartupPhase::Scene:
+    return "Scene";
+  case StartupPhase::FirstFrame:
+    return "FirstFrame";
+  default:
+    return "Unknown";
+  }
+}
+
+void StartupTimeline::Start() {
+  mLaunch = std::chrono::steady_clock::now();
+  mLast = mLaunch;
+  for (int i = 0; i < nStartupPhaseCount; ++i) {
+    mPhaseNs[i] = -1;
+  }
+}
+
+void StartupTimeline::Mark(StartupPhase phase) {
+  if (mPhaseNs[(int)phase] >= 0) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mLast);
+  mPhaseNs[(int)phase] = (long long)ns.count();
+  mLast = now;
+}
+
+long long StartupTimeline::TotalNs() const {
+  if (mPhaseNs[(int)StartupPhase::FirstFrame] < 0) {
+    return -1;
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      mLast - mLaunch);
+  return (long long)ns.count();
+}
+
+int StartupTimeline::Summarize(char *buffer, int size) const {
+  int length = snprintf(buffer, size, "%-22s %8s\n", "startup (ms)", "time");
+  for (int i = 0; i < nStartupPhaseCount && length < size; ++i) {
+    if (mPhaseNs[i] < 0) {
+      continue;
+    }
+    length += snprintf(buffer + length, size - length, "%-22s %8.2f\n",
+                       StartupPhaseName((StartupPhase)i), mPhaseNs[i] / 1e6);
+  }
+  if (TotalNs() >= 0 && length < size) {
+    length += snprintf(buffer + length, size - length, "%-22s %8.2f\n",
+                       "total", TotalNs() / 1e6);
+  }
+  return length < size ? length : size - 1;
+}
+
+void StartupTimeline::WriteJson(FILE *file) const {
+  fprintf(file, "{\n  \"phases\": [");
+  bool first = true;
+  for (int i = 0; i < nStartupPhaseCount; ++i) {
+    if (mPhaseNs[i] < 0) {
+      continue;
+    }
+    fprintf(file, "%s\n    {\"name\": \"%s\", \"ns\": %lld}",
+            first ? "" : ",", StartupPhaseName((StartupPhase)i),
+            mPhaseNs[i]);
+    first = false;
+  }
+  fprintf(file, "\n  ],\n  \"total_ns\": %lld\n}\n", TotalNs());
+}
+
+} // namespace Core
@@ -0,0 +1,136 @@
+#ifndef core_Profile_h
+#define core_Profile_h
+
+#include <stdio.h>
+
+#include <chrono>
+
+// Scoped timing zones around the phases of a step. A zone is written as
+//   PROFILE_ZONE(Core::Zone::Spawn);
+// at the top of a scope and records how long the scope took into the
+// histogram of its zone. Zones are compiled out unless TETRIS_PROFILE is
+// defined, and even then they only record on threads that have a profiler
+// attached, so games in a batch are not slowed down by the live game's
+// profiler.
+namespace Core {
+
+enum class Zone : unsigned char {
+  Step,
+  Spawn,
+  Rotation,
+  Shift,
+  Drop,
+  Lock,
+  Present,
+  Render,
+  Count
+};
+constexpr int nZoneCount = (int)Zone::Count;
+const char *ZoneName(Zone zone);
+
+// A latency histogram with a fixed number of buckets. Durations below 4ns get
+// a bucket each and every power of two above that is split into 4 buckets, so
+// a percentile is never off by more than a quarter of its value. Durations
+// past the last bucket, about 15 seconds, are counted in it.
+struct Histogram {
+  static constexpr int nSubBuckets = 4;
+  static constexpr int nBucketCount = 132;
+
+  unsigned long long mCounts[nBucketCount];
+  unsigned long long mCount;
+  unsigned long long mTotal;
+  unsigned long long mMax;
+
+  void Clear();
+  void Add(unsigned long long ns);
+  // The upper bound of the bucket holding the given percentile, or the exact
+  // maximum when that is smaller.
+  unsigned long long Percentile(double percentile) const;
+
+  static int Bucket(unsigned long long ns);
+  static unsigned long long BucketEnd(int bucket);
+};
+
+struct Profiler {
+  Histogram mHistograms[nZoneCount];
+
+  void Clear();
+  void Record(Zone zone, unsigned long long ns);
+  void WriteCsv(FILE *file) const;
+  void WriteJson(FILE *file) const;
+  // Write a line per zone with the count and the p50, p99 and max in
+  // microseconds. Returns the length that was written.
+  int Summarize(char *buffer, int size) const;
+};
+
+// The profiler that zones on the calling thread record into. This is null
+// unless a profiler was attached to the thread.
+extern thread_local Profiler *tProfiler;
+void AttachProfiler(Profiler *profiler);
+
+struct ProfileScope {
+  Profiler *mProfiler;
+  Zone mZone;
+  std::chrono::steady_clock::time_point mStart;
+
+  ProfileScope(Zone zone) : mProfiler(tProfiler), mZone(zone) {
+    if (mProfiler != nullptr) {
+      mStart = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ProfileScope() {
+    if (mProfiler != nullptr) {
+      auto end = std::chrono::steady_clock::now();
+      auto ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - mStart);
+      mProfiler->Record(mZone, (unsigned long long)ns.count());
+    }
+  }
+};
+
+// The phases between the launch of the process and the first frame a game can
+// be played in. Every phase is measured once, from the end of the phase
+// before it, so restarting a game does not measure startup again.
+enum class StartupPhase : unsigned char {
+  // Initializing the engine and creating the space.
+  Engine,
+  // Initializing the game rules, the bot and the finesse trainer.
+  Rules,
+  // Building the tile batch and creating and filling its buffers.
+  Tiles,
+  // Creating the members of the text, flashes and camera.
+  Scene,
+  // Everything up to the end of the first rendered frame.
+  FirstFrame,
+  Count
+};
+constexpr int nStartupPhaseCount = (int)StartupPhase::Count;
+const char *StartupPhaseName(StartupPhase phase);
+
+struct StartupTimeline {
+  std::chrono::steady_clock::time_point mLaunch;
+  std::chrono::steady_clock::time_point mLast;
+  // The duration of every phase, or -1 for phases that were not measured.
+  long long mPhaseNs[nStartupPhaseCount];
+
+  void Start();
+  // End a phase now. A phase that was already measured is left alone.
+  void Mark(StartupPhase phase);
+  // The time from the launch to the end of the first frame, or -1 before it.
+  long long TotalNs() const;
+  int Summarize(char *buffer, int size) const;
+  void WriteJson(FILE *file) const;
+};
+
+#ifdef TETRIS_PROFILE
+constexpr bool nProfileEnabled = true;
+#define PROFILE_ZONE(zone) Core::ProfileScope profileScope(zone)
+#else
+constexpr bool nProfileEnabled = false;
+#define PROFILE_ZONE(zone)
+#endif
+
+} // namespace Core
+
+#endif
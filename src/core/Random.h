@@ -0,0 +1,118 @@
+#ifndef core_Random_h
+#define core_Random_h
+
+#include "core/Board.h"
+
+namespace Core {
+
+// xoshiro128** by Blackman and Vigna. The state is expanded from a 64 bit seed
+// with splitmix64 so that similar seeds give unrelated sequences.
+struct Random {
+  unsigned int mState[4];
+
+  void Seed(unsigned long long seed) {
+    for (int i = 0; i < 2; ++i) {
+      seed += 0x9e3779b97f4a7c15ull;
+      unsigned long long z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      z ^= z >> 31;
+      mState[2 * i] = (unsigned int)z;
+      mState[2 * i + 1] = (unsigned int)(z >> 32);
+    }
+  }
+
+  unsigned int Next() {
+    unsigned int result = Rotl(mState[1] * 5, 7) * 9;
+    unsigned int t = mState[1] << 9;
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = Rotl(mState[3], 11);
+    return result;
+  }
+
+  // A value in [0, bound) without modulo bias.
+  unsigned int Below(unsigned int bound) {
+    unsigned long long m = (unsigned long long)Next() * bound;
+    unsigned int low = (unsigned int)m;
+    if (low < bound) {
+      unsigned int threshold = (0u - bound) % bound;
+      while (low < threshold) {
+        m = (unsigned long long)Next() * bound;
+        low = (unsigned int)m;
+      }
+    }
+    return (unsigned int)(m >> 32);
+  }
+
+  static unsigned int Rotl(unsigned int x, int k) {
+    return (x << k) | (x >> (32 - k));
+  }
+};
+
+// The upcoming tetriminos. Tetriminos are dealt from shuffled bags that hold
+// one of each of the seven tetriminos and are generated only as far ahead as
+// someone has looked, so the preview can be as long as the capacity allows
+// without changing the sequence.
+struct PieceQueue {
+  static constexpr int nCapacity = 64;
+
+  Random mRandom;
+  Tetrimino mBag[7];
+  int mBagNext;
+  Tetrimino mPieces[nCapacity];
+  int mHead;
+  int mCount;
+
+  void Init(unsigned long long seed) {
+    mRandom.Seed(seed);
+    mBagNext = 7;
+    mHead = 0;
+    mCount = 0;
+  }
+
+  // Get the tetrimino that will be dealt after index others. The index must be
+  // less than nCapacity.
+  Tetrimino Peek(int index) {
+    while (mCount <= index) {
+      mPieces[(mHead + mCount) % nCapacity] = DrawFromBag();
+      ++mCount;
+    }
+    return mPieces[(mHead + index) % nCapacity];
+  }
+
+  // Peek without generating. Only valid for indices that were already peeked.
+  Tetrimino Peeked(int index) const {
+    return mPieces[(mHead + index) % nCapacity];
+  }
+
+  Tetrimino Pop() {
+    Tetrimino next = Peek(0);
+    mHead = (mHead + 1) % nCapacity;
+    --mCount;
+    return next;
+  }
+
+  Tetrimino DrawFromBag() {
+    if (mBagNext == 7) {
+      for (int i = 0; i < 7; ++i) {
+        mBag[i] = (Tetrimino)i;
+      }
+      for (int i = 6; i > 0; --i) {
+        int j = (int)mRandom.Below(i + 1);
+        Tetrimino swap = mBag[i];
+        mBag[i] = mBag[j];
+        mBag[j] = swap;
+      }
+      mBagNext = 0;
+    }
+    return mBag[mBagNext++];
+  }
+};
+
+} // namespace Core
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef core_Shapes_h
+#define core_Shapes_h
+
+#include "core/Board.h"
+
+namespace Core {
+
+// All of the tetrimino shapes in their spawn orientation.
+// clang-format off
+constexpr int nShapeCells[7][4][4] = {
+  {{0, 1, 0, 0},
+   {0, 1, 0, 0},
+   {0, 1, 0, 0},
+   {0, 1, 0, 0}},
+
+  {{0, 1, 0, 0},
+   {0, 1, 0, 0},
+   {0, 1, 1, 0},
+   {0, 0, 0, 0}},
+
+  {{0, 0, 1, 0},
+   {0, 0, 1, 0},
+   {0, 1, 1, 0},
+   {0, 0, 0, 0}},
+
+  {{0, 0, 0, 0},
+   {0, 1, 1, 0},
+   {0, 1, 1, 0},
+   {0, 0, 0, 0}},
+
+  {{0, 0, 0, 0},
+   {0, 1, 1, 0},
+   {1, 1, 0, 0},
+   {0, 0, 0, 0}},
+
+  {{0, 0, 0, 0},
+   {0, 1, 0, 0},
+   {1, 1, 1, 0},
+   {0, 0, 0, 0}},
+
+  {{0, 0, 0, 0},
+   {0, 1, 1, 0},
+   {0, 0, 1, 1},
+   {0, 0, 0, 0}}};
+// clang-format on
+
+// Every tetrimino in every orientation. Orientation n is the spawn orientation
+// rotated a quarter turn counterclockwise n times.
+struct ShapeTable {
+  Shape mShapes[7][4];
+};
+
+constexpr Shape MakeShape(int tetrimino, int rotation) {
+  int cells[4][4] = {};
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      cells[i][j] = nShapeCells[tetrimino][i][j];
+    }
+  }
+  for (int r = 0; r < rotation; ++r) {
+    int newCells[4][4] = {};
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        newCells[i][j] = cells[j][3 - i];
+      }
+    }
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        cells[i][j] = newCells[i][j];
+      }
+    }
+  }
+
+  Shape shape = {};
+  shape.mMinRow = 3;
+  shape.mMaxRow = 0;
+  shape.mMinColumn = 3;
+  shape.mMaxColumn = 0;
+  for (int j = 0; j < 4; ++j) {
+    shape.mBottoms[j] = -1;
+  }
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      if (cells[i][j] == 0) {
+        continue;
+      }
+      shape.mRows[i] |= (unsigned char)(1 << j);
+      shape.mMinRow = i < shape.mMinRow ? i : shape.mMinRow;
+      shape.mMaxRow = i > shape.mMaxRow ? i : shape.mMaxRow;
+      shape.mMinColumn = j < shape.mMinColumn ? j : shape.mMinColumn;
+      shape.mMaxColumn = j > shape.mMaxColumn ? j : shape.mMaxColumn;
+      shape.mBottoms[j] = (signed char)i;
+    }
+  }
+  return shape;
+}
+
+constexpr ShapeTable MakeShapeTable() {
+  ShapeTable table = {};
+  for (int i = 0; i < 7; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      table.mShapes[i][j] = MakeShape(i, j);
+    }
+  }
+  return table;
+}
+
+constexpr ShapeTable nShapeTable = MakeShapeTable();
+
+static_assert(nShapeTable.mShapes[0][1].mRows[2] == 0xf, "I is not flat.");
+static_assert(nShapeTable.mShapes[3][2].mMinColumn == 1, "O moved.");
+static_assert(nShapeTable.mShapes[5][0].mBottoms[1] == 2, "T is upside down.");
+
+constexpr const Shape &GetShape(Tetrimino tetrimino, int rotation) {
+  return nShapeTable.mShapes[(int)tetrimino][rotation];
+}
+
+} // namespace Core
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef core_Snapshot_h
+#define core_Snapshot_h
+
+#include "core/Game.h"
+
+// Snapshots hold everything that decides how a game plays out from a step on:
+// the board, the active tetrimino, the drop and shift timers, the queue with
+// its generator and the keys held during the last step. What a step reports
+// to presentation is left out, so restoring a snapshot marks every cell as
+// dirty instead.
+namespace Core {
+
+template <typename G>
+struct BasicSnapshot {
+  BasicBoard<G> mBoard;
+  PieceQueue mQueue;
+  float mDropRate;
+  float mTimeSinceLastDrop;
+  float mTimeSinceLastShift;
+  float mTimeResting;
+  int mLines;
+  signed char mPreviewLength;
+  signed char mShapeRotation;
+  signed char mActiveX;
+  signed char mActiveY;
+  signed char mLowestY;
+  Tetrimino mActiveTetrimino;
+  Inputs mHeld;
+  bool mRunning;
+
+  void Save(const BasicGame<G> &game) {
+    mBoard = game.mBoard;
+    mQueue = game.mQueue;
+    mDropRate = game.mDropRate;
+    mTimeSinceLastDrop = game.mTimeSinceLastDrop;
+    mTimeSinceLastShift = game.mTimeSinceLastShift;
+    mTimeResting = game.mTimeResting;
+    mLowestY = (signed char)game.mLowestY;
+    mLines = game.mLines;
+    mPreviewLength = (signed char)game.mPreviewLength;
+    mShapeRotation = (signed char)game.mShapeRotation;
+    mActiveX = (signed char)game.mActiveX;
+    mActiveY = (signed char)game.mActiveY;
+    mActiveTetrimino = game.mActiveTetrimino;
+    mHeld = game.mHeld;
+    mRunning = game.mRunning;
+  }
+
+  void Restore(BasicGame<G> *game) const {
+    game->mBoard = mBoard;
+    game->mQueue = mQueue;
+    game->mDropRate = mDropRate;
+    game->mTimeSinceLastDrop = mTimeSinceLastDrop;
+    game->mTimeSinceLastShift = mTimeSinceLastShift;
+    game->mTimeResting = mTimeResting;
+    game->mLowestY = mLowestY;
+    game->mLines = mLines;
+    game->mPreviewLength = mPreviewLength;
+    game->mShapeRotation = mShapeRotation;
+    game->mActiveX = mActiveX;
+    game->mActiveY = mActiveY;
+    game->mActiveTetrimino = mActiveTetrimino;
+    game->mHeld = mHeld;
+    game->mRunning = mRunning;
+    game->mPressed = 0;
+    game->mReleased = 0;
+    game->mEvents = 0;
+    game->mClearedRowCount = 0;
+    game->mDirty.MarkAll();
+    game->mMarkedTetrimino = Tetrimino::None;
+  }
+
+  // A hash of the state that two machines playing the same game must agree
+  // on. The fields are hashed one by one so that padding is never read.
+  unsigned long long Checksum() const {
+    unsigned long long hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void *data, size_t size) {
+      const unsigned char *bytes = (const unsigned char *)data;
+      for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+      }
+    };
+    mix(mBoard.mRows, sizeof(mBoard.mRows));
+    mix(mBoard.mTypes, sizeof(mBoard.mTypes));
+    mix(mQueue.mRandom.mState, sizeof(mQueue.mRandom.mState));
+    mix(mQueue.mBag, sizeof(mQueue.mBag));
+    mix(&mQueue.mBagNext, sizeof(mQueue.mBagNext));
+    for (int i = 0; i < mQueue.mCount; ++i) {
+      Tetrimino piece = mQueue.Peeked(i);
+      mix(&piece, sizeof(piece));
+    }
+    mix(&mDropRate, sizeof(mDropRate));
+    mix(&mTimeSinceLastDrop, sizeof(mTimeSinceLastDrop));
+    mix(&mTimeSinceLastShift, sizeof(mTimeSinceLastShift));
+    mix(&mTimeResting, sizeof(mTimeResting));
+    mix(&mLowestY, sizeof(mLowestY));
+    mix(&mLines, sizeof(mLines));
+    mix(&mShapeRotation, sizeof(mShapeRotation));
+    mix(&mActiveX, sizeof(mActiveX));
+    mix(&mActiveY, sizeof(mActiveY));
+    mix(&mActiveTetrimino, sizeof(mActiveTetrimino));
+    mix(&mHeld, sizeof(mHeld));
+    mix(&mRunning, sizeof(mRunning));
+    return hash;
+  }
+};
+
+typedef BasicSnapshot<StandardGeometry> Snapshot;
+
+// The snapshots of the last nSize frames. The snapshot of a frame is the
+// state right before the frame was stepped.
+template <typename T, int Size>
+struct SnapshotRing {
+  static constexpr int nSize = Size;
+  T mSlots[Size];
+  int mFrames[Size];
+
+  void Clear() {
+    for (int i = 0; i < Size; ++i) {
+      mFrames[i] = -1;
+    }
+  }
+
+  T *Slot(int frame) {
+    mFrames[frame % Size] = frame;
+    return &mSlots[frame % Size];
+  }
+
+  // Null when the snapshot of the frame was overwritten or never taken.
+  const T *Find(int frame) const {
+    if (frame < 0 || mFrames[frame % Size] != frame) {
+      return nullptr;
+    }
+    return &mSlots[frame % Size];
+  }
+};
+
+} // namespace Core
+
+#endif
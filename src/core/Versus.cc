@@ -0,0 +1,326 @@
+#include "core/Versus.h"
+
+namespace Core {
+
+void Versus::Init(int playerCount, unsigned long long seed) {
+  mPlayerCount = playerCount;
+  if (mPlayerCount < 1) {
+    mPlayerCount = 1;
+  } else if (mPlayerCount > nMaxPlayers) {
+    mPlayerCount = nMaxPlayers;
+  }
+  mAliveCount = 0;
+  mStepAliveCount = 0;
+  mRunning = false;
+  mWinner = -1;
+  mGarbageRandom.Seed(~seed);
+
+  for (int p = 0; p < mPlayerCount; ++p) {
+    for (int i = 0; i < Board::nPadRows + Board::nHeight; ++i) {
+      mRows[p][i] = Board::nEmptyRow;
+    }
+    for (int i = Board::nPadRows + Board::nHeight; i < nRowCount; ++i) {
+      mRows[p][i] = Board::nFullRow;
+    }
+    memset(mSkyline[p], Board::nHeight, sizeof(mSkyline[p]));
+    mActive[p] = Tetrimino::None;
+    mRotation[p] = 0;
+    mX[p] = 0;
+    mY[p] = 0;
+    mDropRate[p] = 1.0f;
+    mTimeSinceLastDrop[p] = 0.0f;
+    mTimeResting[p] = 0.0f;
+    mLowestY[p] = 0;
+    mTimeSinceLastShift[p] = 1.0f / nShiftRate;
+    mHeld[p] = 0;
+    mPressed[p] = 0;
+    mReleased[p] = 0;
+    mAlive[p] = false;
+    mEvents[p] = 0;
+
+    memset(mCells[p], nEmptyCell, sizeof(mCells[p]));
+    mBoardDirty[p] = true;
+    mQueues[p].Init(seed);
+    mLines[p] = 0;
+    mPendingGarbage[p] = 0;
+    mSentGarbage[p] = 0;
+    mTarget[p] = (p + 1) % mPlayerCount;
+    mPlace[p] = 0;
+  }
+  mLockingCount = 0;
+}
+
+void Versus::Start() {
+  for (int p = 0; p < mPlayerCount; ++p) {
+    mAlive[p] = true;
+    mEvents[p] = Event::Started;
+  }
+  mAliveCount = mPlayerCount;
+  mStepAliveCount = mPlayerCount;
+  mRunning = true;
+}
+
+void Versus::Step(const Inputs *inputs, float dt) {
+  if (!mRunning) {
+    return;
+  }
+  dt = ClampStepTime(dt);
+  mStepAliveCount = mAliveCount;
+  HandleInputs(inputs);
+  SpawnTetriminos();
+  HandleRotations();
+  HandleShifts(dt);
+  HandleDrops(dt);
+  LockTetriminos();
+
+  // A match of one player goes on until that player is knocked out.
+  int lastAlive = mPlayerCount > 1 ? 1 : 0;
+  if (mAliveCount > lastAlive) {
+    return;
+  }
+  mRunning = false;
+  for (int p = 0; p < mPlayerCount; ++p) {
+    if (mAlive[p]) {
+      mWinner = p;
+      mPlace[p] = 1;
+      mEvents[p] |= Event::Ended;
+    }
+  }
+}
+
+void Versus::HandleInputs(const Inputs *inputs) {
+  for (int p = 0; p < mPlayerCount; ++p) {
+    mPressed[p] = inputs[p] & ~mHeld[p];
+    mReleased[p] = mHeld[p] & ~inputs[p];
+    mHeld[p] = inputs[p];
+    mEvents[p] = 0;
+  }
+}
+
+void Versus::SpawnTetriminos() {
+  for (int p = 0; p < mPlayerCount; ++p) {
+    if (!mAlive[p] || mActive[p] != Tetrimino::None) {
+      continue;
+    }
+    mActive[p] = mQueues[p].Pop();
+    mRotation[p] = 0;
+    mX[p] = Game::nSpawnX;
+    mY[p] = Game::nSpawnY;
+    mTimeResting[p] = 0.0f;
+    mLowestY[p] = Game::nSpawnY;
+    mEvents[p] |= Event::Spawned;
+    if (!Board::Fits(mRows[p], ActiveShape(p), mX[p], mY[p])) {
+      KnockOut(p);
+    }
+  }
+}
+
+void Versus::HandleRotations() {
+  const Inputs rotations = Key::RotateCcw | Key::RotateCw;
+  for (int p = 0; p < mPlayerCount; ++p) {
+    if (!mAlive[p] || (mPressed[p] & rotations) == 0) {
+      continue;
+    }
+    RotateActive<StandardGeometry>(
+        mRows[p], mActive[p], mPressed[p], &mRotation[p], &mX[p], &mY[p]);
+  }
+}
+
+void Versus::HandleShifts(float dt) {
+  const Inputs shifts = Key::Left | Key::Right;
+  for (int p = 0; p < mPlayerCount; ++p) {
+    if (!mAlive[p] || ((mHeld[p] | mReleased[p]) & shifts) == 0) {
+      continue;
+    }
+    ShiftActive<StandardGeometry>(mRows[p], ActiveShape(p), Keys(p),
+                                  Timing(p), dt, &mX[p], mY[p],
+                                  &mTimeSinceLastShift[p]);
+  }
+}
+
+void Versus::HandleDrops(float dt) {
+  mLockingCount = 0;
+  for (int p = 0; p < mPlayerCount; ++p) {
+    if (!mAlive[p]) {
+      continue;
+    }
+    if (DropActive<StandardGeometry>(mRows[p], mSkyline[p], ActiveShape(p),
+                                     Keys(p), Timing(p), dt, mX[p], &mY[p],
+                                     &mLowestY[p], &mTimeSinceLastDrop[p],
+                                     &mTimeResting[p])) {
+      mLocking[mLockingCount++] = p;
+    }
+  }
+}
+
+void Versus::LockTetriminos() {
+  for (int i = 0; i < mLockingCount; ++i) {
+    Lock(mLocking[i]);
+  }
+}
+
+void Versus::Lock(int player) {
+  const Shape &shape = ActiveShape(player);
+  bool lockedOut = false;
+  for (int i = 0; i < 4; ++i) {
+    int row = mY[player] + i;
+    if (shape.mRows[i] == 0) {
+      continue;
+    }
+    if (row < Board::nBufferRows) {
+      lockedOut = true;
+    }
+    if (row < 0 || row >= Board::nHeight) {
+      continue;
+    }
+    mRows[player][row + Board::nPadRows] |=
+        (RowMask)(shape.mRows[i] << (mX[player] + Board::nWallBits));
+    for (int j = 0; j < 4; ++j) {
+      if (shape.Filled(i, j)) {
+        int column = mX[player] + j;
+        mCells[player][row][column] = (unsigned char)mActive[player];
+        if (row < mSkyline[player][column]) {
+          mSkyline[player][column] = (signed char)row;
+        }
+      }
+    }
+  }
+  mActive[player] = Tetrimino::None;
+  mBoardDirty[player] = true;
+  mEvents[player] |= Event::Locked;
+
+  // Clears are sent to an opponent and garbage only rises when a tetrimino
+  // locks without clearing anything.
+  int collapseDistance = ClearFullRows(player);
+  if (collapseDistance > 0) {
+    mEvents[player] |= Event::RowsCleared;
+    for (int i = 1; i <= collapseDistance; ++i) {
+      if ((mLines[player] + i) % 10 == 0 && mLines[player] > 0) {
+        mDropRate[player] += 1.0f;
+        mEvents[player] |= Event::RateIncreased;
+      }
+    }
+    mLines[player] += collapseDistance;
+    SendGarbage(player, nGarbageForClear[collapseDistance]);
+  } else {
+    RaiseGarbage(player);
+  }
+  if (lockedOut) {
+    KnockOut(player);
+  }
+}
+
+int Versus::ClearFullRows(int player) {
+  RowMask *rows = &mRows[player][Board::nPadRows];
+  unsigned char(*cells)[Board::nWidth] = mCells[player];
+  int clearedCount = 0;
+  int write = Board::nHeight - 1;
+  for (int read = Board::nHeight - 1; read >= 0; --read) {
+    if (rows[read] == Board::nFullRow) {
+      ++clearedCount;
+      continue;
+    }
+    if (write != read) {
+      rows[write] = rows[read];
+      memcpy(cells[write], cells[read], sizeof(cells[write]));
+    }
+    --write;
+  }
+  for (; write >= 0 && clearedCount > 0; --write) {
+    rows[write] = Board::nEmptyRow;
+    memset(cells[write], nEmptyCell, sizeof(cells[write]));
+  }
+  if (clearedCount > 0) {
+    Board::UpdateSkyline(mRows[player], mSkyline[player]);
+  }
+  return clearedCount;
+}
+
+void Versus::SendGarbage(int player, int rows) {
+  // Garbage that is on its way to the player is cancelled first.
+  int pending = mPendingGarbage[player];
+  int cancelled = rows < pending ? rows : pending;
+  mPendingGarbage[player] -= cancelled;
+  rows -= cancelled;
+  if (rows == 0) {
+    return;
+  }
+
+  // Attacks go to the opponents that are still in the match in turn.
+  int target = mTarget[player];
+  for (int i = 0; i < mPlayerCount; ++i) {
+    if (target != player && mAlive[target]) {
+      break;
+    }
+    target = (target + 1) % mPlayerCount;
+  }
+  if (target == player || !mAlive[target]) {
+    return;
+  }
+  mTarget[player] = (target + 1) % mPlayerCount;
+  mSentGarbage[player] += rows;
+  mPendingGarbage[target] += rows;
+  if (mPendingGarbage[target] > Board::nHeight) {
+    mPendingGarbage[target] = Board::nHeight;
+  }
+}
+
+void Versus::RaiseGarbage(int player) {
+  int count = mPendingGarbage[player];
+  if (count == 0) {
+    return;
+  }
+  mPendingGarbage[player] = 0;
+  RowMask *rows = &mRows[player][Board::nPadRows];
+  unsigned char(*cells)[Board::nWidth] = mCells[player];
+
+  // The player is knocked out when locked cells are pushed off the top.
+  bool pushedOut = false;
+  for (int i = 0; i < count; ++i) {
+    pushedOut = pushedOut || rows[i] != Board::nEmptyRow;
+  }
+  int kept = Board::nHeight - count;
+  memmove(rows, rows + count, sizeof(RowMask) * kept);
+  memmove(cells, cells + count, sizeof(cells[0]) * kept);
+
+  // The rows of a single attack share the column of their hole.
+  int hole = (int)mGarbageRandom.Below(Board::nWidth);
+  RowMask garbageRow =
+      (RowMask)(Board::nFullRow & ~(1u << (hole + Board::nWallBits)));
+  for (int i = kept; i < Board::nHeight; ++i) {
+    rows[i] = garbageRow;
+    memset(cells[i], nGarbageCell, sizeof(cells[i]));
+    cells[i][hole] = nEmptyCell;
+  }
+  Board::UpdateSkyline(mRows[player], mSkyline[player]);
+  mBoardDirty[player] = true;
+  if (pushedOut) {
+    KnockOut(player);
+  }
+}
+
+void Versus::KnockOut(int player) {
+  if (!mAlive[player]) {
+    return;
+  }
+  mAlive[player] = false;
+  mActive[player] = Tetrimino::None;
+  mPlace[player] = mStepAliveCount;
+  --mAliveCount;
+  mEvents[player] |= Event::Ended;
+}
+
+const Shape &Versus::ActiveShape(int player) const {
+  return GetShape(mActive[player], mRotation[player]);
+}
+
+StepKeys Versus::Keys(int player) const {
+  return {mHeld[player], mPressed[player], mReleased[player]};
+}
+
+RuleTiming Versus::Timing(int player) const {
+  return {mDropRate[player], nFastDropRate, nLockDelay, nShiftRate,
+          nShiftDelay};
+}
+
+} // namespace Core
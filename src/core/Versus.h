@@ -0,0 +1,109 @@
+#ifndef core_Versus_h
+#define core_Versus_h
+
+#include "core/Game.h"
+
+// A match between many players on boards of the standard geometry. Every
+// active tetrimino is moved by the rule steps of core/Game.h that Core::Game
+// is played by, and the rows a player clears are sent to an opponent as
+// garbage rows that push the opponent's stack up.
+//
+// The players are stored by field rather than by player. A step makes one pass
+// over all players per phase, and the passes that run every step only walk the
+// dense arrays of row masks, poses and timers. The cell types, queues and
+// garbage counts are kept apart since they are only touched when a tetrimino
+// locks.
+namespace Core {
+
+// The garbage rows that are sent for clearing zero to four rows at once.
+constexpr int nGarbageForClear[5] = {0, 0, 1, 2, 4};
+
+struct Versus {
+  static constexpr int nMaxPlayers = 128;
+  static constexpr int nRowCount =
+      Board::nPadRows + Board::nHeight + Board::nPadRows;
+  // The timing of Core::Game when it is initialized. Only the drop rate
+  // differs between players.
+  static constexpr float nFastDropRate = 20.0f;
+  static constexpr float nLockDelay = 0.0f;
+  static constexpr float nShiftRate = 10.0f;
+  static constexpr float nShiftDelay = 1.0f / nShiftRate;
+
+  // The cells of a tetrimino hold its Tetrimino value. Garbage cells are given
+  // the value after the empty value.
+  static constexpr unsigned char nEmptyCell = (unsigned char)Tetrimino::None;
+  static constexpr unsigned char nGarbageCell = nEmptyCell + 1;
+
+  int mPlayerCount;
+  int mAliveCount;
+  // The players that were still in the match when the current step started.
+  int mStepAliveCount;
+  bool mRunning;
+  // The last player standing once the match is over. This is -1 when the last
+  // players were knocked out during the same step.
+  int mWinner;
+  // Chooses the column of the hole in every garbage row.
+  Random mGarbageRandom;
+
+  // The state that every step touches.
+  RowMask mRows[nMaxPlayers][nRowCount];
+  signed char mSkyline[nMaxPlayers][Board::nWidth];
+  Tetrimino mActive[nMaxPlayers];
+  int mRotation[nMaxPlayers];
+  int mX[nMaxPlayers];
+  int mY[nMaxPlayers];
+  float mDropRate[nMaxPlayers];
+  float mTimeSinceLastDrop[nMaxPlayers];
+  float mTimeResting[nMaxPlayers];
+  int mLowestY[nMaxPlayers];
+  float mTimeSinceLastShift[nMaxPlayers];
+  Inputs mHeld[nMaxPlayers];
+  Inputs mPressed[nMaxPlayers];
+  Inputs mReleased[nMaxPlayers];
+  bool mAlive[nMaxPlayers];
+  Events mEvents[nMaxPlayers];
+
+  // The state that is only touched when a tetrimino locks. A board is marked
+  // dirty whenever its cells change and presentation clears the mark.
+  unsigned char mCells[nMaxPlayers][Board::nHeight][Board::nWidth];
+  bool mBoardDirty[nMaxPlayers];
+  PieceQueue mQueues[nMaxPlayers];
+  int mLines[nMaxPlayers];
+  int mPendingGarbage[nMaxPlayers];
+  int mSentGarbage[nMaxPlayers];
+  int mTarget[nMaxPlayers];
+  // The place a player finished in, where the winner is first. This is zero
+  // while a player is still in the match. Players knocked out during the same
+  // step share the lowest of the places they cover, so a match whose last
+  // players go out together has no first place.
+  int mPlace[nMaxPlayers];
+
+  // The players whose tetrimino locks during the current step.
+  int mLocking[nMaxPlayers];
+  int mLockingCount;
+
+  // Every player is dealt the same sequence of tetriminos from the seed.
+  void Init(int playerCount, unsigned long long seed);
+  void Start();
+  // The inputs hold the keys of every player.
+  void Step(const Inputs *inputs, float dt);
+
+  void HandleInputs(const Inputs *inputs);
+  void SpawnTetriminos();
+  void HandleRotations();
+  void HandleShifts(float dt);
+  void HandleDrops(float dt);
+  void LockTetriminos();
+  void Lock(int player);
+  int ClearFullRows(int player);
+  void SendGarbage(int player, int rows);
+  void RaiseGarbage(int player);
+  void KnockOut(int player);
+  const Shape &ActiveShape(int player) const;
+  StepKeys Keys(int player) const;
+  RuleTiming Timing(int player) const;
+};
+
+} // namespace Core
+
+#endif
@@ -0,0 +1,162 @@
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+#include "ai/Bot.h"
+#include "core/FixedStep.h"
+#include "sim/Batch.h"
+#include "sim/ThreadPool.h"
+
+namespace Sim {
+
+void BatchConfig::SetDefaults() {
+  mGameCount = 1000;
+  mSeed = 1;
+  mThreadCount = 0;
+  mMaxTicks = 60 * 60 * 60;
+  mTickTime = 1.0f / (float)DEFAULT_TICK_RATE;
+  mDriver = DriverType::Random;
+  mScript = nullptr;
+  mDataset = nullptr;
+}
+
+bool ValidTickRate(double rate) {
+  return rate >= 1.0 / Core::nMaxStepTime && rate < INFINITY;
+}
+
+unsigned int GameSeed(unsigned int batchSeed, int gameIndex) {
+  // splitmix64 spreads neighbouring indices over the whole seed space.
+  unsigned long long z = ((unsigned long long)batchSeed << 32) + gameIndex;
+  z += 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return (unsigned int)(z ^ (z >> 31));
+}
+
+template <typename T>
+void PlayGame(T *driver, const BatchConfig &config, int index,
+              GameResult *result) {
+  Core::Game game;
+  game.Init(result->mSeed);
+  game.StartGame();
+  DatasetRecorder recorder;
+  recorder.Init(config.mDataset);
+  recorder.Begin((unsigned int)index);
+  result->mTicks = 0;
+  result->mPieces = 0;
+  while (game.mRunning && result->mTicks < config.mMaxTicks) {
+    Core::Inputs inputs = driver->NextInputs(game);
+    recorder.Before(game);
+    game.Step(inputs, config.mTickTime);
+    recorder.After(game);
+    if (game.mEvents & Core::Event::Locked) {
+      ++result->mPieces;
+    }
+    ++result->mTicks;
+  }
+  recorder.Flush();
+  result->mLines = game.mLines;
+  result->mToppedOut = !game.mRunning;
+}
+
+void PlayGame(const BatchConfig &config, int index, GameResult *result) {
+  // Games already run in parallel, so every search stays on the thread of its
+  // game and has no time budget. This keeps bot games reproducible.
+  Ai::BotConfig botConfig;
+  botConfig.SetDefaults();
+  WithDriver(config.mDriver, result->mSeed, config.mScript, botConfig,
+             [&](auto *driver) { PlayGame(driver, config, index, result); });
+}
+
+BatchResult RunBatch(const BatchConfig &config) {
+  BatchResult result;
+  result.mGames.resize(config.mGameCount);
+  for (int i = 0; i < config.mGameCount; ++i) {
+    result.mGames[i].mSeed = GameSeed(config.mSeed, i);
+  }
+
+  ThreadPool pool;
+  pool.Init(config.mThreadCount);
+  result.mThreadCount = pool.ThreadCount();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < config.mGameCount; ++i) {
+    GameResult *gameResult = &result.mGames[i];
+    pool.Submit(
+        [&config, i, gameResult]() { PlayGame(config, i, gameResult); });
+  }
+  pool.Wait();
+  auto end = std::chrono::steady_clock::now();
+  pool.Purge();
+  result.mSeconds = std::chrono::duration<double>(end - start).count();
+  return result;
+}
+
+// Get the value at a percentile of an already sorted list of values.
+template <typename T>
+T Percentile(const std::vector<T> &sorted, double percentile) {
+  if (sorted.empty()) {
+    return T();
+  }
+  size_t index = (size_t)(percentile / 100.0 * (double)(sorted.size() - 1));
+  return sorted[index];
+}
+
+void PrintReport(const BatchResult &result, FILE *file) {
+  long long ticks = 0;
+  long long pieces = 0;
+  long long lines = 0;
+  int toppedOut = 0;
+  std::vector<int> pieceCounts;
+  std::vector<int> lineCounts;
+  for (const GameResult &game : result.mGames) {
+    ticks += game.mTicks;
+    pieces += game.mPieces;
+    lines += game.mLines;
+    toppedOut += game.mToppedOut ? 1 : 0;
+    pieceCounts.push_back(game.mPieces);
+    lineCounts.push_back(game.mLines);
+  }
+  std::sort(pieceCounts.begin(), pieceCounts.end());
+  std::sort(lineCounts.begin(), lineCounts.end());
+
+  int gameCount = (int)result.mGames.size();
+  double seconds = result.mSeconds > 0.0 ? result.mSeconds : 1e-9;
+  fprintf(file, "games: %d on %d threads in %.3fs\n", gameCount,
+          result.mThreadCount, result.mSeconds);
+  fprintf(file, "throughput: %.1f games/s, %.1f pieces/s, %.1f ticks/s\n",
+          gameCount / seconds, pieces / seconds, ticks / seconds);
+  fprintf(file, "totals: %lld ticks, %lld pieces, %lld lines\n", ticks,
+          pieces, lines);
+  fprintf(file, "survival: %d topped out, %d reached the tick limit\n",
+          toppedOut, gameCount - toppedOut);
+  const double percentiles[] = {10.0, 50.0, 90.0, 99.0, 100.0};
+  fprintf(file, "pieces:");
+  for (double percentile : percentiles) {
+    fprintf(file, " p%g=%d", percentile, Percentile(pieceCounts, percentile));
+  }
+  fprintf(file, "\nlines:");
+  for (double percentile : percentiles) {
+    fprintf(file, " p%g=%d", percentile, Percentile(lineCounts, percentile));
+  }
+  fprintf(file, "\n");
+
+  // Bucket the line counts by powers of two.
+  fprintf(file, "line distribution:\n");
+  int bucketStart = 0;
+  int bucketEnd = 1;
+  size_t index = 0;
+  while (index < lineCounts.size()) {
+    int count = 0;
+    while (index < lineCounts.size() && lineCounts[index] < bucketEnd) {
+      ++count;
+      ++index;
+    }
+    if (count > 0) {
+      fprintf(file, "  [%d, %d): %d\n", bucketStart, bucketEnd, count);
+    }
+    bucketStart = bucketEnd;
+    bucketEnd *= 2;
+  }
+}
+
+} // namespace Sim
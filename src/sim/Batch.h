@@ -0,0 +1,57 @@
+#ifndef sim_Batch_h
+#define sim_Batch_h
+
+#include <stdio.h>
+#include <vector>
+
+#include "sim/Dataset.h"
+#include "sim/Drivers.h"
+
+// Plays many independent games across all cores. Every game owns its state
+// and its seed, so a batch gives the same results no matter how many threads
+// play it.
+namespace Sim {
+
+struct BatchConfig {
+  int mGameCount;
+  // Game i is played with GameSeed(mSeed, i).
+  unsigned int mSeed;
+  // Zero uses every core.
+  int mThreadCount;
+  // Games that are still running after this many ticks are stopped.
+  long long mMaxTicks;
+  float mTickTime;
+  DriverType mDriver;
+  // The script that every game plays when mDriver is DriverType::Script.
+  const InputScript *mScript;
+  // Every tetrimino that locks is recorded with the index of its game when a
+  // dataset is given.
+  DatasetWriter *mDataset;
+
+  void SetDefaults();
+};
+
+struct GameResult {
+  unsigned int mSeed;
+  long long mTicks;
+  int mPieces;
+  int mLines;
+  bool mToppedOut;
+};
+
+struct BatchResult {
+  std::vector<GameResult> mGames;
+  int mThreadCount;
+  double mSeconds;
+};
+
+unsigned int GameSeed(unsigned int batchSeed, int gameIndex);
+// Whether ticks at a rate in hertz can be played. Ticks longer than
+// Core::nMaxStepTime would be shortened, so slower rates are refused.
+bool ValidTickRate(double rate);
+BatchResult RunBatch(const BatchConfig &config);
+void PrintReport(const BatchResult &result, FILE *file);
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef sim_Bytes_h
+#define sim_Bytes_h
+
+#include <string.h>
+
+// Little endian encoding for the files the simulation writes.
+namespace Sim {
+
+inline void EncodeU16(unsigned char *bytes, unsigned short value) {
+  for (int i = 0; i < 2; ++i) {
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+inline void EncodeU32(unsigned char *bytes, unsigned int value) {
+  for (int i = 0; i < 4; ++i) {
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+inline void EncodeU64(unsigned char *bytes, unsigned long long value) {
+  for (int i = 0; i < 8; ++i) {
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+inline void EncodeF32(unsigned char *bytes, float value) {
+  unsigned int bits;
+  memcpy(&bits, &value, sizeof(bits));
+  EncodeU32(bytes, bits);
+}
+
+inline unsigned short DecodeU16(const unsigned char *bytes) {
+  return (unsigned short)(bytes[0] | (bytes[1] << 8));
+}
+
+inline unsigned int DecodeU32(const unsigned char *bytes) {
+  unsigned int value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= (unsigned int)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+inline unsigned long long DecodeU64(const unsigned char *bytes) {
+  unsigned long long value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= (unsigned long long)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+inline float DecodeF32(const unsigned char *bytes) {
+  unsigned int bits = DecodeU32(bytes);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,416 @@
+#include <string.h>
+
+#include "sim/Bytes.h"
+#include "sim/Dataset.h"
+
+namespace Sim {
+
+const char nDatasetMagic[4] = {'T', 'T', 'D', 'S'};
+
+size_t DatasetHeader::ColumnSize(int column, size_t recordCount) const {
+  size_t width = 1;
+  switch (column) {
+  case DatasetColumn::Game:
+  case DatasetColumn::Piece:
+    width = 4;
+    break;
+  case DatasetColumn::Board:
+    width = 2 * Core::Board::nHeight;
+    break;
+  case DatasetColumn::Queue:
+    width = mQueueLength;
+    break;
+  }
+  return (width * recordCount + 7) & ~(size_t)7;
+}
+
+size_t DatasetHeader::ChunkSize(size_t recordCount) const {
+  size_t size = 8;
+  for (int column = 0; column < DatasetColumn::Count; ++column) {
+    size += ColumnSize(column, recordCount);
+  }
+  return size;
+}
+
+void EncodeHeader(unsigned char bytes[DatasetHeader::nSize],
+                  const DatasetHeader &header) {
+  memcpy(bytes, nDatasetMagic, sizeof(nDatasetMagic));
+  EncodeU16(bytes + 4, DatasetHeader::nVersion);
+  EncodeU16(bytes + 6, (unsigned short)DatasetColumn::Count);
+  EncodeU32(bytes + 8, Core::Board::nWidth);
+  EncodeU32(bytes + 12, Core::Board::nHeight);
+  EncodeU32(bytes + 16, header.mQueueLength);
+  EncodeU32(bytes + 20, header.mChunkRecords);
+  EncodeU64(bytes + 24, header.mRecordCount);
+}
+
+DatasetWriter::DatasetWriter() : mFile(nullptr) {}
+
+DatasetWriter::~DatasetWriter() {
+  std::string error;
+  Close(&error);
+}
+
+bool DatasetWriter::Open(const char *filename, int queueLength,
+                         int chunkCount, std::string *error) {
+  Close(error);
+  if (queueLength < 0 || queueLength > DatasetHeader::nMaxQueueLength) {
+    *error = "The queue length of a dataset must be at most " +
+             std::to_string(DatasetHeader::nMaxQueueLength) + ".";
+    return false;
+  }
+  mFile = fopen(filename, "wb");
+  if (mFile == nullptr) {
+    *error = std::string("Failed to open ") + filename + " for writing.";
+    return false;
+  }
+  mHeader.mQueueLength = (unsigned int)queueLength;
+  mHeader.mChunkRecords = DatasetChunk::nCapacity;
+  mHeader.mRecordCount = 0;
+  unsigned char headerBytes[DatasetHeader::nSize];
+  EncodeHeader(headerBytes, mHeader);
+  mFailed = fwrite(headerBytes, 1, sizeof(headerBytes), mFile) !=
+            sizeof(headerBytes);
+
+  if (chunkCount <= 0) {
+    chunkCount = 2 * (int)std::thread::hardware_concurrency();
+    chunkCount = chunkCount > 0 ? chunkCount : 2;
+  }
+  for (int i = 0; i < chunkCount; ++i) {
+    mChunks.emplace_back(new DatasetChunk);
+    mFree.push_back(mChunks.back().get());
+  }
+  mFilled.resize(chunkCount);
+  mFilledHead = 0;
+  mFilledCount = 0;
+  mClosing = false;
+  mBuilding.reset(new DatasetChunk);
+  mBuilding->mCount = 0;
+  mBytes.resize(mHeader.ChunkSize(DatasetChunk::nCapacity));
+  mThread = std::thread(&DatasetWriter::Write, this);
+  return true;
+}
+
+DatasetChunk *DatasetWriter::Acquire() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mChunkFreed.wait(lock, [this]() { return !mFree.empty(); });
+  DatasetChunk *chunk = mFree.back();
+  mFree.pop_back();
+  chunk->mCount = 0;
+  return chunk;
+}
+
+void DatasetWriter::Submit(DatasetChunk *chunk) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (chunk->mCount == 0) {
+      mFree.push_back(chunk);
+      mChunkFreed.notify_one();
+      return;
+    }
+    mFilled[(mFilledHead + mFilledCount) % mFilled.size()] = chunk;
+    ++mFilledCount;
+  }
+  mWakeWriter.notify_one();
+}
+
+bool DatasetWriter::Close(std::string *error) {
+  if (mFile == nullptr) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosing = true;
+  }
+  mWakeWriter.notify_one();
+  mThread.join();
+  mChunks.clear();
+  mFree.clear();
+  mFilled.clear();
+  mBuilding.reset();
+
+  // Now that every record has been written, the count can be filled in.
+  unsigned char headerBytes[DatasetHeader::nSize];
+  EncodeHeader(headerBytes, mHeader);
+  fseek(mFile, 0, SEEK_SET);
+  if (fwrite(headerBytes, 1, sizeof(headerBytes), mFile) !=
+      sizeof(headerBytes)) {
+    mFailed = true;
+  }
+  if (fclose(mFile) != 0) {
+    mFailed = true;
+  }
+  mFile = nullptr;
+  if (mFailed) {
+    *error = "Failed to write the dataset.";
+    return false;
+  }
+  return true;
+}
+
+bool DatasetWriter::IsOpen() const {
+  return mFile != nullptr;
+}
+
+void DatasetWriter::Write() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    mWakeWriter.wait(lock,
+                     [this]() { return mFilledCount > 0 || mClosing; });
+    if (mFilledCount == 0) {
+      break;
+    }
+    DatasetChunk *chunk = mFilled[mFilledHead];
+    mFilledHead = (mFilledHead + 1) % mFilled.size();
+    --mFilledCount;
+    lock.unlock();
+    Build(*chunk);
+    lock.lock();
+    mFree.push_back(chunk);
+    mChunkFreed.notify_one();
+  }
+  lock.unlock();
+  if (mBuilding->mCount > 0) {
+    WriteBuilding();
+  }
+}
+
+void DatasetWriter::Build(const DatasetChunk &chunk) {
+  int read = 0;
+  while (read < chunk.mCount) {
+    int space = DatasetChunk::nCapacity - mBuilding->mCount;
+    int count = chunk.mCount - read < space ? chunk.mCount - read : space;
+    memcpy(mBuilding->mRecords + mBuilding->mCount, chunk.mRecords + read,
+           count * sizeof(DatasetRecord));
+    mBuilding->mCount += count;
+    read += count;
+    if (mBuilding->mCount == DatasetChunk::nCapacity) {
+      WriteBuilding();
+    }
+  }
+}
+
+void DatasetWriter::WriteBuilding() {
+  const DatasetRecord *records = mBuilding->mRecords;
+  int count = mBuilding->mCount;
+  size_t size = mHeader.ChunkSize(count);
+  memset(mBytes.data(), 0, size);
+  EncodeU32(mBytes.data(), (unsigned int)count);
+
+  unsigned char *column = mBytes.data() + 8;
+  for (int i = 0; i < count; ++i) {
+    EncodeU32(column + 4 * i, records[i].mGame);
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Game, count);
+  for (int i = 0; i < count; ++i) {
+    EncodeU32(column + 4 * i, records[i].mPiece);
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Piece, count);
+  for (int i = 0; i < count; ++i) {
+    for (int row = 0; row < Core::Board::nHeight; ++row) {
+      EncodeU16(column + 2 * (i * Core::Board::nHeight + row),
+                records[i].mBoard[row]);
+    }
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Board, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = (unsigned char)records[i].mTetrimino;
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Tetrimino, count);
+  int queueLength = (int)mHeader.mQueueLength;
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < queueLength; ++j) {
+      column[i * queueLength + j] = (unsigned char)records[i].mQueue[j];
+    }
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Queue, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = (unsigned char)records[i].mX;
+  }
+  column += mHeader.ColumnSize(DatasetColumn::X, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = (unsigned char)records[i].mY;
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Y, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = records[i].mRotation;
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Rotation, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = records[i].mCleared;
+  }
+  column += mHeader.ColumnSize(DatasetColumn::Cleared, count);
+  for (int i = 0; i < count; ++i) {
+    column[i] = records[i].mEnded ? 1 : 0;
+  }
+
+  if (fwrite(mBytes.data(), 1, size, mFile) != size) {
+    mFailed = true;
+  }
+  mHeader.mRecordCount += count;
+  mBuilding->mCount = 0;
+}
+
+void DatasetRecorder::Init(DatasetWriter *writer) {
+  mWriter = writer;
+  mChunk = nullptr;
+  mGame = 0;
+  mPieces = 0;
+  mCapturing = false;
+}
+
+void DatasetRecorder::Begin(unsigned int game) {
+  mGame = game;
+  mPieces = 0;
+  mCapturing = false;
+}
+
+void DatasetRecorder::Before(const Core::Game &game) {
+  if (mWriter == nullptr || !game.mRunning ||
+      game.mActiveTetrimino != Core::Tetrimino::None) {
+    return;
+  }
+  // The board stays as it is until the tetrimino that spawns next locks.
+  const unsigned int columns = (1u << Core::Board::nWidth) - 1;
+  for (int row = 0; row < Core::Board::nHeight; ++row) {
+    unsigned int bits = game.mBoard.mRows[Core::Board::nPadRows + row];
+    mRecord.mBoard[row] =
+        (unsigned short)((bits >> Core::Board::nWallBits) & columns);
+  }
+  mRecord.mTetrimino = game.Preview(0);
+  mCapturing = true;
+}
+
+void DatasetRecorder::After(const Core::Game &game) {
+  if (!mCapturing) {
+    return;
+  }
+  Core::Events events = game.mEvents;
+  if (events & Core::Event::Spawned) {
+    int length = (int)mWriter->mHeader.mQueueLength;
+    length = length < game.mPreviewLength ? length : game.mPreviewLength;
+    for (int i = 0; i < DatasetHeader::nMaxQueueLength; ++i) {
+      mRecord.mQueue[i] = i < length ? game.Preview(i) : Core::Tetrimino::None;
+    }
+  }
+  if (!(events & Core::Event::Locked)) {
+    // A tetrimino that spawned on locked cells ended the game without a lock.
+    mCapturing = (events & Core::Event::Ended) == 0;
+    return;
+  }
+  // The pose of a tetrimino is kept when it locks.
+  mRecord.mGame = mGame;
+  mRecord.mPiece = mPieces++;
+  mRecord.mX = (signed char)game.mActiveX;
+  mRecord.mY = (signed char)game.mActiveY;
+  mRecord.mRotation = (unsigned char)game.mShapeRotation;
+  mRecord.mCleared = (unsigned char)game.mClearedRowCount;
+  mRecord.mEnded = (events & Core::Event::Ended) != 0;
+  mCapturing = false;
+
+  if (mChunk == nullptr) {
+    mChunk = mWriter->Acquire();
+  }
+  mChunk->mRecords[mChunk->mCount++] = mRecord;
+  if (mChunk->mCount == DatasetChunk::nCapacity) {
+    Flush();
+  }
+}
+
+void DatasetRecorder::Flush() {
+  if (mChunk != nullptr) {
+    mWriter->Submit(mChunk);
+    mChunk = nullptr;
+  }
+}
+
+bool DatasetReader::Open(const unsigned char *data, size_t size,
+                         std::string *error) {
+  if (size < DatasetHeader::nSize ||
+      memcmp(data, nDatasetMagic, sizeof(nDatasetMagic)) != 0) {
+    *error = "Not a dataset.";
+    return false;
+  }
+  if (DecodeU16(data + 4) != DatasetHeader::nVersion ||
+      DecodeU16(data + 6) != DatasetColumn::Count) {
+    *error = "Unsupported dataset version.";
+    return false;
+  }
+  if (DecodeU32(data + 8) != Core::Board::nWidth ||
+      DecodeU32(data + 12) != Core::Board::nHeight) {
+    *error = "The dataset was recorded on a board of another size.";
+    return false;
+  }
+  mData = data;
+  mSize = size;
+  mHeader.mQueueLength = DecodeU32(data + 16);
+  mHeader.mChunkRecords = DecodeU32(data + 20);
+  mHeader.mRecordCount = DecodeU64(data + 24);
+  if (mHeader.mQueueLength > DatasetHeader::nMaxQueueLength) {
+    *error = "The dataset is malformed.";
+    return false;
+  }
+
+  // A chunk that was cut short ends a dataset that was never closed.
+  mChunkOffsets.clear();
+  mChunkCounts.clear();
+  mRecordCount = 0;
+  size_t offset = DatasetHeader::nSize;
+  while (offset + 8 <= size) {
+    unsigned int count = DecodeU32(data + offset);
+    if (count == 0 || count > mHeader.mChunkRecords) {
+      *error = "The dataset is malformed.";
+      return false;
+    }
+    size_t chunkSize = mHeader.ChunkSize(count);
+    if (chunkSize > size - offset) {
+      break;
+    }
+    mChunkOffsets.push_back(offset);
+    mChunkCounts.push_back(count);
+    mRecordCount += count;
+    offset += chunkSize;
+  }
+  if (mHeader.mRecordCount != 0 &&
+      (offset != size || mHeader.mRecordCount != mRecordCount)) {
+    *error = "The dataset's record count does not match its chunks.";
+    return false;
+  }
+  return true;
+}
+
+const unsigned char *DatasetReader::Column(size_t chunk, int column) const {
+  size_t offset = mChunkOffsets[chunk] + 8;
+  for (int i = 0; i < column; ++i) {
+    offset += mHeader.ColumnSize(i, mChunkCounts[chunk]);
+  }
+  return mData + offset;
+}
+
+void DatasetReader::Get(size_t chunk, unsigned int index,
+                        DatasetRecord *record) const {
+  const int height = Core::Board::nHeight;
+  const int queueLength = (int)mHeader.mQueueLength;
+  record->mGame = DecodeU32(Column(chunk, DatasetColumn::Game) + 4 * index);
+  record->mPiece = DecodeU32(Column(chunk, DatasetColumn::Piece) + 4 * index);
+  const unsigned char *board =
+      Column(chunk, DatasetColumn::Board) + 2 * height * index;
+  for (int row = 0; row < height; ++row) {
+    record->mBoard[row] = DecodeU16(board + 2 * row);
+  }
+  record->mTetrimino =
+      (Core::Tetrimino)Column(chunk, DatasetColumn::Tetrimino)[index];
+  const unsigned char *queue =
+      Column(chunk, DatasetColumn::Queue) + queueLength * index;
+  for (int i = 0; i < DatasetHeader::nMaxQueueLength; ++i) {
+    record->mQueue[i] =
+        i < queueLength ? (Core::Tetrimino)queue[i] : Core::Tetrimino::None;
+  }
+  record->mX = (signed char)Column(chunk, DatasetColumn::X)[index];
+  record->mY = (signed char)Column(chunk, DatasetColumn::Y)[index];
+  record->mRotation = Column(chunk, DatasetColumn::Rotation)[index];
+  record->mCleared = Column(chunk, DatasetColumn::Cleared)[index];
+  record->mEnded = Column(chunk, DatasetColumn::Ended)[index] != 0;
+}
+
+} // namespace Sim
@@ -0,0 +1,188 @@
+#ifndef sim_Dataset_h
+#define sim_Dataset_h
+
+#include <stdio.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/Game.h"
+
+// A dataset holds a record for every tetrimino that locked: the board it
+// spawned over, the tetrimino and the queue behind it, where it locked and
+// what the lock did. Records are captured around the steps of live games,
+// replays and batches and are written out on a thread of their own.
+//
+// A dataset file starts with a 32 byte header. All values are little endian.
+//   0  char[4] "TTDS"
+//   4  u16     version
+//   6  u16     column count
+//   8  u32     board width
+//   12 u32     board height
+//   16 u32     queue length
+//   20 u32     records per chunk
+//   24 u64     record count
+// The header is followed by chunks of up to records per chunk records. A chunk
+// is a u32 record count and four bytes of padding followed by every column of
+// the chunk in turn. A column holds the values of one field for every record
+// of the chunk and is padded with zeros to a multiple of 8 bytes, so every
+// column of a mapped file is aligned and can be read in place. The columns are
+//   game      u32              The id the game was recorded with.
+//   piece     u32              The tetriminos that locked earlier in the game.
+//   board     u16[height]      The rows from the top. Bit j is column j.
+//   tetrimino u8
+//   queue     u8[queue length] The tetriminos that follow, nearest first.
+//   x         i8
+//   y         i8
+//   rotation  u8
+//   cleared   u8               The rows the lock cleared.
+//   ended     u8               1 when the lock ended the game.
+// Tetriminos are Core::Tetrimino values and queue slots beyond the preview of
+// a game hold Core::Tetrimino::None. The record count is written when a
+// dataset is closed, so a file with a record count of zero was cut short and
+// is read until its chunks end.
+namespace Sim {
+
+namespace DatasetColumn {
+constexpr int Game = 0;
+constexpr int Piece = 1;
+constexpr int Board = 2;
+constexpr int Tetrimino = 3;
+constexpr int Queue = 4;
+constexpr int X = 5;
+constexpr int Y = 6;
+constexpr int Rotation = 7;
+constexpr int Cleared = 8;
+constexpr int Ended = 9;
+constexpr int Count = 10;
+} // namespace DatasetColumn
+
+struct DatasetHeader {
+  static constexpr unsigned short nVersion = 1;
+  static constexpr size_t nSize = 32;
+  static constexpr int nMaxQueueLength = 16;
+  static_assert(Core::Board::nWidth <= 16, "A row must fit in a u16.");
+
+  unsigned int mQueueLength;
+  unsigned int mChunkRecords;
+  unsigned long long mRecordCount;
+
+  // The bytes a column takes up in a chunk of a number of records.
+  size_t ColumnSize(int column, size_t recordCount) const;
+  size_t ChunkSize(size_t recordCount) const;
+};
+
+struct DatasetRecord {
+  unsigned int mGame;
+  unsigned int mPiece;
+  unsigned short mBoard[Core::Board::nHeight];
+  Core::Tetrimino mTetrimino;
+  Core::Tetrimino mQueue[DatasetHeader::nMaxQueueLength];
+  signed char mX;
+  signed char mY;
+  unsigned char mRotation;
+  unsigned char mCleared;
+  bool mEnded;
+};
+
+struct DatasetChunk {
+  static constexpr int nCapacity = 4096;
+
+  int mCount;
+  DatasetRecord mRecords[nCapacity];
+};
+
+// Streams records to a dataset file. Recorders fill chunks taken from a pool
+// that is allocated when the file is opened and hand them back once they are
+// full, so the threads that play games only ever copy records. The writer
+// thread moves the records of the chunks it is handed into the chunk it is
+// building and writes that chunk out column by column once it is full. Short
+// games hand back chunks with few records, but every chunk of the file apart
+// from the last is full.
+struct DatasetWriter {
+  FILE *mFile;
+  DatasetHeader mHeader;
+  bool mFailed;
+
+  // Chunks that are free to be filled and the ring of filled chunks that are
+  // waiting for the writer thread. Neither grows past the size of the pool.
+  std::vector<std::unique_ptr<DatasetChunk>> mChunks;
+  std::vector<DatasetChunk *> mFree;
+  std::vector<DatasetChunk *> mFilled;
+  size_t mFilledHead;
+  size_t mFilledCount;
+  bool mClosing;
+  std::mutex mMutex;
+  std::condition_variable mWakeWriter;
+  std::condition_variable mChunkFreed;
+  std::thread mThread;
+
+  // Only used by the writer thread.
+  std::unique_ptr<DatasetChunk> mBuilding;
+  std::vector<unsigned char> mBytes;
+
+  DatasetWriter();
+  ~DatasetWriter();
+  // The pool holds chunkCount chunks, or two for every core when it is zero.
+  bool Open(const char *filename, int queueLength, int chunkCount,
+            std::string *error);
+  // Take a free chunk from the pool. This blocks while every chunk is being
+  // filled or written.
+  DatasetChunk *Acquire();
+  // Hand a chunk back to be written. It returns to the pool once it has been.
+  void Submit(DatasetChunk *chunk);
+  // Every recorder must be flushed before the writer is closed.
+  bool Close(std::string *error);
+  bool IsOpen() const;
+
+  void Write();
+  void Build(const DatasetChunk &chunk);
+  void WriteBuilding();
+};
+
+// Captures the records of one game. Before and After are called around every
+// step of the game. The board is captured before the step that spawns a
+// tetrimino because a hard drop spawns and locks within the same step.
+struct DatasetRecorder {
+  DatasetWriter *mWriter;
+  DatasetChunk *mChunk;
+  unsigned int mGame;
+  unsigned int mPieces;
+
+  // The record of the active tetrimino, which is complete once it locks.
+  DatasetRecord mRecord;
+  bool mCapturing;
+
+  // Recording is skipped when the writer is null.
+  void Init(DatasetWriter *writer);
+  // Records from here on belong to a new game with the given id.
+  void Begin(unsigned int game);
+  void Before(const Core::Game &game);
+  void After(const Core::Game &game);
+  // Hand the records captured so far to the writer.
+  void Flush();
+};
+
+// Reads a dataset that is already in memory, usually a mapped file. Columns
+// are read in place.
+struct DatasetReader {
+  const unsigned char *mData;
+  size_t mSize;
+  DatasetHeader mHeader;
+  // Where every chunk starts and how many records it holds.
+  std::vector<size_t> mChunkOffsets;
+  std::vector<unsigned int> mChunkCounts;
+  unsigned long long mRecordCount;
+
+  bool Open(const unsigned char *data, size_t size, std::string *error);
+  // The values of a column for every record of a chunk.
+  const unsigned char *Column(size_t chunk, int column) const;
+  void Get(size_t chunk, unsigned int index, DatasetRecord *record) const;
+};
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,141 @@
+#include <string.h>
+#include <fstream>
+#include <sstream>
+
+#include "sim/Drivers.h"
+
+namespace Sim {
+
+const char *DriverName(DriverType driver) {
+  switch (driver) {
+  case DriverType::Random:
+    return "random";
+  case DriverType::Script:
+    return "script";
+  case DriverType::Bot:
+    return "bot";
+  }
+  return "unknown";
+}
+
+bool ParseDriver(const char *name, DriverType *driver) {
+  const DriverType types[] = {
+      DriverType::Random, DriverType::Script, DriverType::Bot};
+  for (DriverType type : types) {
+    if (strcmp(name, DriverName(type)) == 0) {
+      *driver = type;
+      return true;
+    }
+  }
+  return false;
+}
+
+void RandomDriver::Init(unsigned int seed) {
+  mState = seed ? seed : 1;
+  mHeld = 0;
+  mHoldTicks = 0;
+}
+
+Core::Inputs RandomDriver::NextInputs(const Core::Game &game) {
+  (void)game;
+  return NextInputs();
+}
+
+Core::Inputs RandomDriver::NextInputs() {
+  if (mHoldTicks > 0) {
+    --mHoldTicks;
+    return mHeld;
+  }
+  // xorshift32 is plenty for choosing keys.
+  mState ^= mState << 13;
+  mState ^= mState >> 17;
+  mState ^= mState << 5;
+  mHeld = (Core::Inputs)(mState & 0x1f);
+  mHoldTicks = (int)((mState >> 8) % 30);
+  return mHeld;
+}
+
+bool InputScript::Load(const char *filename, std::string *error) {
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    *error = std::string("Failed to open ") + filename + ".";
+    return false;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  return Parse(text.str().c_str(), error);
+}
+
+bool InputScript::Parse(const char *text, std::string *error) {
+  mTicks.clear();
+  std::istringstream stream(text);
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(stream, line)) {
+    ++lineNumber;
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    std::istringstream entry(line);
+    long long ticks;
+    std::string keys;
+    if (!(entry >> ticks)) {
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+      *error = "Line " + std::to_string(lineNumber) + ": expected a count.";
+      return false;
+    }
+    if (!(entry >> keys) || ticks < 0) {
+      *error = "Line " + std::to_string(lineNumber) + ": expected keys.";
+      return false;
+    }
+    Core::Inputs inputs = 0;
+    for (char key : keys) {
+      switch (key) {
+      case '<':
+        inputs |= Core::Key::Left;
+        break;
+      case '>':
+        inputs |= Core::Key::Right;
+        break;
+      case 'v':
+        inputs |= Core::Key::Down;
+        break;
+      case 'T':
+        inputs |= Core::Key::RotateCcw;
+        break;
+      case 'R':
+        inputs |= Core::Key::RotateCw;
+        break;
+      case 'V':
+        inputs |= Core::Key::HardDrop;
+        break;
+      case '-':
+        break;
+      default:
+        *error = "Line " + std::to_string(lineNumber) + ": unknown key '" +
+                 key + "'.";
+        return false;
+      }
+    }
+    mTicks.insert(mTicks.end(), (size_t)ticks, inputs);
+  }
+  return true;
+}
+
+void ScriptDriver::Init(const InputScript *script) {
+  mScript = script;
+  mTick = 0;
+}
+
+Core::Inputs ScriptDriver::NextInputs(const Core::Game &game) {
+  (void)game;
+  if (mTick >= mScript->mTicks.size()) {
+    return 0;
+  }
+  return mScript->mTicks[mTick++];
+}
+
+} // namespace Sim
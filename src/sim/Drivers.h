@@ -0,0 +1,97 @@
+#ifndef sim_Drivers_h
+#define sim_Drivers_h
+
+#include <string>
+#include <vector>
+
+#include "ai/Bot.h"
+#include "core/Game.h"
+
+// Drivers decide which keys are held during each step of a game. Every driver
+// provides the same function,
+//   Core::Inputs NextInputs(const Core::Game &game);
+// and the code that plays games is templated on the driver type.
+namespace Sim {
+
+enum class DriverType { Random, Script, Bot };
+
+// The name of a driver type on the command line and in reports.
+const char *DriverName(DriverType driver);
+// False is returned when the name is not random, script or bot.
+bool ParseDriver(const char *name, DriverType *driver);
+
+// Holds random sets of keys for random durations. The sequence only depends on
+// the seed the driver is given.
+struct RandomDriver {
+  unsigned int mState;
+  Core::Inputs mHeld;
+  int mHoldTicks;
+
+  void Init(unsigned int seed);
+  Core::Inputs NextInputs(const Core::Game &game);
+  // The keys do not depend on the game, so this drives games of any geometry.
+  Core::Inputs NextInputs();
+};
+
+// The keys held during each tick of a recorded or written game.
+//
+// A script is a text file with one entry per line. An entry is the number of
+// ticks followed by the keys held during those ticks. Keys are written with
+// '<' for left, '>' for right, 'v' for down, 'V' for a hard drop, 'T' for
+// counterclockwise rotation and 'R' for clockwise rotation. A '-' means that
+// no keys are held. Anything following a '#' is ignored. For example,
+//   30 -
+//   4 <
+//   1 T
+//   20 v
+struct InputScript {
+  std::vector<Core::Inputs> mTicks;
+
+  bool Load(const char *filename, std::string *error);
+  bool Parse(const char *text, std::string *error);
+};
+
+// Plays an input script from start to finish. No keys are held once the script
+// runs out.
+struct ScriptDriver {
+  const InputScript *mScript;
+  size_t mTick;
+
+  void Init(const InputScript *script);
+  Core::Inputs NextInputs(const Core::Game &game);
+};
+
+// Set up a driver of the given type for one game and call play with a pointer
+// to it. Play is usually a generic lambda, so the loop that plays the game is
+// compiled for every driver type. The random driver is seeded from the seed of
+// the game, the script driver plays the script and the bot searches with the
+// bot config.
+template <typename F>
+void WithDriver(DriverType type, unsigned int gameSeed,
+                const InputScript *script, const Ai::BotConfig &botConfig,
+                F play) {
+  switch (type) {
+  case DriverType::Random: {
+    RandomDriver driver;
+    driver.Init(gameSeed ^ 0x5bd1e995u);
+    play(&driver);
+    break;
+  }
+  case DriverType::Script: {
+    ScriptDriver driver;
+    driver.Init(script);
+    play(&driver);
+    break;
+  }
+  case DriverType::Bot: {
+    Ai::BotDriver driver;
+    driver.Init(botConfig);
+    play(&driver);
+    break;
+  }
+  }
+}
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,195 @@
+#include <math.h>
+
+#include "ai/Bot.h"
+#include "ai/Finesse.h"
+#include "core/FixedStep.h"
+#include "sim/Headless.h"
+
+namespace Sim {
+
+void HeadlessConfig::SetDefaults() {
+  mSeed = 1;
+  mFrames = 60 * 60 * 60;
+  mTickRate = DEFAULT_TICK_RATE;
+  mDropRate = 1.0f;
+  mLockDelay = -1.0f;
+  mDriver = DriverType::Bot;
+  mScript = nullptr;
+  mRestart = false;
+  mFinesse = false;
+  mLaunch = std::chrono::steady_clock::now();
+}
+
+float LockDelay(const HeadlessConfig &config) {
+  if (config.mLockDelay >= 0.0f) {
+    return config.mLockDelay;
+  }
+  return isinf(config.mDropRate) ? Core::nTwentyGLockDelay : 0.0f;
+}
+
+// Start game i of the run with the drop rate and lock delay of the config.
+void StartGame(const HeadlessConfig &config, int index, Core::Game *game) {
+  game->Init(GameSeed(config.mSeed, index));
+  game->mStartDropRate = config.mDropRate;
+  game->mLockDelay = LockDelay(config);
+  game->StartGame();
+}
+
+template <typename T>
+void PlayHeadless(T *driver, const HeadlessConfig &config,
+                  HeadlessResult *result) {
+  Core::Game game;
+  StartGame(config, 0, &game);
+  result->mGames = 1;
+  result->mDropRates.push_back({0, 0, game.mDropRate});
+  Ai::FinesseTrainer trainer;
+  if (config.mFinesse) {
+    trainer.Init(Ai::FinesseCache::nDefaultEntryCount);
+  }
+  float tickTime = (float)(1.0 / config.mTickRate);
+  bool firstGame = true;
+  long long frame = 0;
+  while (frame < config.mFrames) {
+    Core::Inputs inputs = driver->NextInputs(game);
+    if (config.mFinesse) {
+      trainer.Before(game, inputs);
+    }
+    game.Step(inputs, tickTime);
+    if (config.mFinesse) {
+      trainer.After(game);
+    }
+    if (frame == 0) {
+      std::chrono::duration<double> startup =
+          std::chrono::steady_clock::now() - config.mLaunch;
+      result->mStartupSeconds = startup.count();
+    }
+    if (game.mEvents & Core::Event::Locked) {
+      ++result->mPieces;
+    }
+    if (firstGame && game.mDropRate != result->mDropRates.back().mDropRate) {
+      result->mDropRates.push_back({frame, game.mLines, game.mDropRate});
+    }
+    ++frame;
+    if (game.mRunning) {
+      continue;
+    }
+    // The drop rate only rises during a game, so a game ends at its highest.
+    ++result->mTopOuts;
+    result->mLines += game.mLines;
+    if (game.mDropRate > result->mMaxDropRate) {
+      result->mMaxDropRate = game.mDropRate;
+    }
+    if (firstGame) {
+      result->mTopOutFrame = frame - 1;
+      firstGame = false;
+    }
+    if (!config.mRestart) {
+      break;
+    }
+    StartGame(config, result->mGames, &game);
+    ++result->mGames;
+  }
+  if (game.mRunning) {
+    result->mLines += game.mLines;
+    if (game.mDropRate > result->mMaxDropRate) {
+      result->mMaxDropRate = game.mDropRate;
+    }
+  }
+  result->mFrames = frame;
+  if (config.mFinesse) {
+    result->mFinesseGraded = trainer.mGraded;
+    result->mFinesseFaults = trainer.mFaults;
+    result->mFinesseExtraPresses = trainer.mExtraPresses;
+    result->mFinesseUngraded = trainer.mUngraded;
+    result->mFinesseCacheHits = trainer.mCache.mHits;
+    result->mFinesseCacheMisses = trainer.mCache.mMisses;
+  }
+}
+
+HeadlessResult RunHeadless(const HeadlessConfig &config) {
+  HeadlessResult result;
+  result.mFrames = 0;
+  result.mGames = 0;
+  result.mPieces = 0;
+  result.mLines = 0;
+  result.mTopOutFrame = -1;
+  result.mTopOuts = 0;
+  result.mMaxDropRate = 0.0f;
+  result.mFinesseGraded = 0;
+  result.mFinesseFaults = 0;
+  result.mFinesseExtraPresses = 0;
+  result.mFinesseUngraded = 0;
+  result.mFinesseCacheHits = 0;
+  result.mFinesseCacheMisses = 0;
+  result.mStartupSeconds = 0.0;
+
+  auto start = std::chrono::steady_clock::now();
+  Ai::BotConfig botConfig;
+  botConfig.SetDefaults();
+  WithDriver(config.mDriver, GameSeed(config.mSeed, 0), config.mScript,
+             botConfig,
+             [&](auto *driver) { PlayHeadless(driver, config, &result); });
+  auto end = std::chrono::steady_clock::now();
+  result.mSeconds = std::chrono::duration<double>(end - start).count();
+  return result;
+}
+
+// JSON has no infinity, so a 20G drop rate is written as a string.
+void WriteDropRate(float dropRate, FILE *file) {
+  if (isinf(dropRate)) {
+    fprintf(file, "\"20G\"");
+  } else {
+    fprintf(file, "%.9g", dropRate);
+  }
+}
+
+void WriteJson(const HeadlessConfig &config, const HeadlessResult &result,
+               FILE *file) {
+  double seconds = result.mSeconds > 0.0 ? result.mSeconds : 1e-9;
+  fprintf(file, "{\n");
+  fprintf(file, "  \"seed\": %u,\n", config.mSeed);
+  fprintf(file, "  \"driver\": \"%s\",\n", DriverName(config.mDriver));
+  fprintf(file, "  \"tick_rate\": %.15g,\n", config.mTickRate);
+  fprintf(file, "  \"restart\": %s,\n", config.mRestart ? "true" : "false");
+  fprintf(file, "  \"start_drop_rate\": ");
+  WriteDropRate(config.mDropRate, file);
+  fprintf(file, ",\n");
+  fprintf(file, "  \"lock_delay\": %.9g,\n", LockDelay(config));
+  fprintf(file, "  \"frames\": %lld,\n", result.mFrames);
+  fprintf(file, "  \"games\": %d,\n", result.mGames);
+  fprintf(file, "  \"pieces\": %lld,\n", result.mPieces);
+  fprintf(file, "  \"lines\": %lld,\n", result.mLines);
+  if (result.mTopOutFrame < 0) {
+    fprintf(file, "  \"top_out_frame\": null,\n");
+  } else {
+    fprintf(file, "  \"top_out_frame\": %lld,\n", result.mTopOutFrame);
+  }
+  fprintf(file, "  \"top_outs\": %d,\n", result.mTopOuts);
+  fprintf(file, "  \"max_drop_rate\": ");
+  WriteDropRate(result.mMaxDropRate, file);
+  fprintf(file, ",\n");
+  fprintf(file, "  \"drop_rate\": [");
+  for (size_t i = 0; i < result.mDropRates.size(); ++i) {
+    const DropRateChange &change = result.mDropRates[i];
+    fprintf(file, "%s\n    {\"frame\": %lld, \"lines\": %d, \"drop_rate\": ",
+            i == 0 ? "" : ",", change.mFrame, change.mLines);
+    WriteDropRate(change.mDropRate, file);
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n  ],\n");
+  if (config.mFinesse) {
+    fprintf(file,
+            "  \"finesse\": {\"graded\": %lld, \"faults\": %lld, "
+            "\"extra_presses\": %lld, \"ungraded\": %lld, "
+            "\"cache_hits\": %lld, \"cache_misses\": %lld},\n",
+            result.mFinesseGraded, result.mFinesseFaults,
+            result.mFinesseExtraPresses, result.mFinesseUngraded,
+            result.mFinesseCacheHits, result.mFinesseCacheMisses);
+  }
+  fprintf(file, "  \"startup_ms\": %.3f,\n", result.mStartupSeconds * 1e3);
+  fprintf(file, "  \"seconds\": %.3f,\n", result.mSeconds);
+  fprintf(file, "  \"frames_per_second\": %.1f\n", result.mFrames / seconds);
+  fprintf(file, "}\n");
+}
+
+} // namespace Sim
@@ -0,0 +1,77 @@
+#ifndef sim_Headless_h
+#define sim_Headless_h
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#include "sim/Batch.h"
+
+// Plays the game rules for a fixed number of frames on one thread without the
+// engine, for soak tests on machines that have no display.
+namespace Sim {
+
+struct HeadlessConfig {
+  // Game i of the run is played with GameSeed(mSeed, i).
+  unsigned int mSeed;
+  long long mFrames;
+  // Frames are stepped by the reciprocal, and the rate is kept as given for
+  // the report.
+  double mTickRate;
+  // The drop rate every game starts at. A rate of infinity plays at 20G.
+  float mDropRate;
+  // The lock delay in seconds. A negative delay picks none below 20G, which
+  // keeps the classic locking, and Core::nTwentyGLockDelay at 20G.
+  float mLockDelay;
+  DriverType mDriver;
+  // The script played when mDriver is DriverType::Script.
+  const InputScript *mScript;
+  // Start a new game when one tops out rather than ending the run. The driver
+  // carries on into the new game.
+  bool mRestart;
+  // Grade the presses of every tetrimino with an Ai::FinesseTrainer.
+  bool mFinesse;
+  // Startup is measured from this time to the end of the first frame.
+  std::chrono::steady_clock::time_point mLaunch;
+
+  void SetDefaults();
+};
+
+// The drop rate of the first game as of a frame.
+struct DropRateChange {
+  long long mFrame;
+  int mLines;
+  float mDropRate;
+};
+
+struct HeadlessResult {
+  long long mFrames;
+  int mGames;
+  long long mPieces;
+  long long mLines;
+  // The frame the first game topped out on, or -1 if it never did.
+  long long mTopOutFrame;
+  int mTopOuts;
+  // The drop rate of the first game each time it changed, starting with the
+  // rate it started with.
+  std::vector<DropRateChange> mDropRates;
+  // The highest drop rate any game reached.
+  float mMaxDropRate;
+  // The totals of the finesse trainer when mFinesse was set.
+  long long mFinesseGraded;
+  long long mFinesseFaults;
+  long long mFinesseExtraPresses;
+  long long mFinesseUngraded;
+  long long mFinesseCacheHits;
+  long long mFinesseCacheMisses;
+  double mStartupSeconds;
+  double mSeconds;
+};
+
+HeadlessResult RunHeadless(const HeadlessConfig &config);
+void WriteJson(const HeadlessConfig &config, const HeadlessResult &result,
+               FILE *file);
+
+} // namespace Sim
+
+#endif
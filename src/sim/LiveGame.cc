@@ -0,0 +1,297 @@
+#include <string.h>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "core/Allocations.h"
+#include "core/FixedStep.h"
+#include "sim/LiveGame.h"
+
+namespace Sim {
+
+void LiveGame::Init(const Ai::BotConfig &botConfig, DatasetWriter *dataset) {
+  mEpoch = std::chrono::steady_clock::now();
+  mStopping.store(false, std::memory_order_relaxed);
+  mCommands.Clear();
+  mEvents.Clear();
+  mFrames.Clear();
+  mProfiles.Clear();
+  for (Core::Profiler &profiler : mProfiles.mSlots) {
+    profiler.Clear();
+  }
+
+  mGame.Init(std::random_device()());
+  mTickTime = 1.0f / (float)DEFAULT_TICK_RATE;
+  mInputQueue.Clear();
+  mPolledInputs = 0;
+  mBot.Init(botConfig);
+  mBotPlaying = false;
+  mFinesse.Init(Ai::FinesseCache::nDefaultEntryCount);
+  mReplayDirectory = "replays";
+  mDatasetRecorder.Init(dataset);
+  mGamesStarted = 0;
+  mQuietAllocations = 0;
+  mProfiler.Clear();
+
+  mTiles.Build(mGame);
+  mGame.mDirty.Clear();
+  mPreviousPose.Capture(mGame);
+  Publish(Now());
+}
+
+void LiveGame::Start() {
+  mThread = std::thread(&LiveGame::Run, this);
+}
+
+void LiveGame::Purge() {
+  mStopping.store(true, std::memory_order_release);
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+  // A game that is still running keeps the steps and the tetriminos it was
+  // recorded with so far.
+  mReplayWriter.Close();
+  mDatasetRecorder.Flush();
+}
+
+double LiveGame::Now() const {
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - mEpoch;
+  return elapsed.count();
+}
+
+void LiveGame::SetKeys(double time, Core::Inputs inputs) {
+  LiveCommand command;
+  command.mType = LiveCommandType::Keys;
+  command.mInputs = inputs;
+  command.mTime = time;
+  mCommands.Push(command);
+}
+
+void LiveGame::ToggleBot() {
+  LiveCommand command;
+  command.mType = LiveCommandType::ToggleBot;
+  command.mInputs = 0;
+  command.mTime = 0.0;
+  mCommands.Push(command);
+}
+
+void LiveGame::Run() {
+  Core::AttachProfiler(&mProfiler);
+  // Ticks are stepped once the time they cover has passed, so the keys that
+  // changed within a tick have usually arrived when it is stepped. The end of
+  // every tick is a fixed distance from the one before no matter when the
+  // thread wakes up.
+  double tickEnd = Now() + mTickTime;
+  while (!mStopping.load(std::memory_order_acquire)) {
+    double now = Now();
+    if (now < tickEnd) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(tickEnd - now));
+      continue;
+    }
+    if (now - tickEnd > nMaxCatchUp * mTickTime) {
+      tickEnd = now - nMaxCatchUp * mTickTime;
+    }
+    RunTick(tickEnd);
+    tickEnd += mTickTime;
+  }
+  Core::AttachProfiler(nullptr);
+}
+
+// Starting and ending a game opens and closes a replay and the bot searches
+// on the thread pool, so only ticks in the middle of a game played from the
+// keyboard are counted. Publishing is counted along with the step.
+void LiveGame::RunTick(double tickEnd) {
+  unsigned long long allocations = Core::ThreadAllocationCount();
+  bool quiet = mGame.mRunning && !mBotPlaying;
+  unsigned int gamesStarted = mGamesStarted;
+  TakeCommands();
+  Tick(tickEnd - mTickTime);
+  Publish(tickEnd);
+  if (quiet && mGame.mRunning && !mBotPlaying &&
+      mGamesStarted == gamesStarted) {
+    mQuietAllocations += Core::ThreadAllocationCount() - allocations;
+  }
+}
+
+void LiveGame::TakeCommands() {
+  LiveCommand command;
+  while (mCommands.Pop(&command)) {
+    switch (command.mType) {
+    case LiveCommandType::Keys:
+      mInputQueue.PushChanges(command.mTime, mPolledInputs, command.mInputs);
+      mPolledInputs = command.mInputs;
+      break;
+    case LiveCommandType::ToggleBot:
+      mBotPlaying = !mBotPlaying;
+      break;
+    }
+  }
+}
+
+void LiveGame::Tick(double start) {
+  mPreviousPose.Capture(mGame);
+  if (mBotPlaying) {
+    // The bot starts a new game as soon as the previous one ends.
+    mInputQueue.Discard(start + mTickTime);
+    Core::Inputs inputs = mBot.NextInputs(mGame);
+    bool startPressed = !mGame.mRunning;
+    if (startPressed) {
+      inputs = Core::Key::Down;
+    }
+    StepGame(inputs, mTickTime, startPressed, -1.0);
+    return;
+  }
+  Core::TimedStep stretches[nMaxStretches];
+  int count = mInputQueue.Split(start, mTickTime, stretches, nMaxStretches);
+  for (int i = 0; i < count; ++i) {
+    const Core::TimedStep &stretch = stretches[i];
+    Core::Inputs pressed = stretch.mInputs & ~mGame.mHeld;
+    StepGame(stretch.mInputs, stretch.mDt, (pressed & Core::Key::Down) != 0,
+             pressed != 0 ? stretch.mEventTime : -1.0);
+  }
+}
+
+void LiveGame::StepGame(Core::Inputs inputs, float dt, bool startPressed,
+                        double eventTime) {
+  if (!mGame.mRunning && startPressed) {
+    StartRecording();
+  }
+  View::ActivePose before;
+  before.Capture(mGame);
+  mFinesse.Before(mGame, inputs);
+  mDatasetRecorder.Before(mGame);
+  mGame.Step(inputs, dt);
+  mFinesse.After(mGame);
+  mDatasetRecorder.After(mGame);
+  if (mReplayWriter.IsOpen()) {
+    mReplayWriter.Record(inputs, dt);
+  }
+  Core::Events events = mGame.mEvents;
+
+  // A tetrimino that just spawned is not blended with the previous one.
+  if (events & Core::Event::Spawned) {
+    mPreviousPose.Capture(mGame);
+  }
+  View::ActivePose after;
+  after.Capture(mGame);
+  bool changed = before.mTetrimino != after.mTetrimino ||
+                 before.mRotation != after.mRotation ||
+                 before.mX != after.mX || before.mY != after.mY;
+  long long latencyNs = -1;
+  if (changed && eventTime >= 0.0) {
+    latencyNs = (long long)((Now() - eventTime) * 1e9);
+  }
+
+  // The latency goes with the event that shows the change of pose. Falling
+  // would send a move on most ticks, so only moves a key caused are sent.
+  if (events & Core::Event::Started) {
+    mEvents.Push(NewEvent(LiveEventType::Started));
+  }
+  if (events & Core::Event::Spawned) {
+    LiveEvent event = NewEvent(LiveEventType::Spawned);
+    if (!(events & Core::Event::Locked)) {
+      event.mLatencyNs = latencyNs;
+    }
+    mEvents.Push(event);
+  } else if (changed && latencyNs >= 0 && !(events & Core::Event::Locked)) {
+    LiveEvent event = NewEvent(LiveEventType::Moved);
+    event.mLatencyNs = latencyNs;
+    mEvents.Push(event);
+  }
+  if (events & Core::Event::Locked) {
+    LiveEvent event = NewEvent(LiveEventType::Locked);
+    event.mLatencyNs = latencyNs;
+    mEvents.Push(event);
+  }
+  if (events & Core::Event::RowsCleared) {
+    LiveEvent event = NewEvent(LiveEventType::RowsCleared);
+    event.mClearedRowCount = (unsigned char)mGame.mClearedRowCount;
+    for (int i = 0; i < mGame.mClearedRowCount; ++i) {
+      event.mClearedRows[i] = (signed char)mGame.mClearedRows[i];
+    }
+    mEvents.Push(event);
+  }
+  if (events & Core::Event::RateIncreased) {
+    mEvents.Push(NewEvent(LiveEventType::RateIncreased));
+  }
+  if (events & Core::Event::Ended) {
+    mReplayWriter.Close();
+    mDatasetRecorder.Flush();
+    mEvents.Push(NewEvent(LiveEventType::Ended));
+  }
+}
+
+// Give the game a fresh seed right before it starts so that the replay only
+// needs the seed and the steps of this game. The board is left for StartGame
+// to clear, which repaints only the cells that were filled.
+void LiveGame::StartRecording() {
+  std::random_device device;
+  unsigned long long seed = ((unsigned long long)device() << 32) | device();
+  mGame.Reseed(seed);
+
+  // Steps are split at key changes, so their lengths are recorded.
+  ReplayHeader header;
+  header.mFlags = ReplayFlag::VariableTickTime;
+  header.mSeed = seed;
+  header.mPreviewLength = mGame.mPreviewLength;
+  header.mTickTime = mTickTime;
+  std::error_code errorCode;
+  std::filesystem::create_directories(mReplayDirectory, errorCode);
+  std::string filename =
+      mReplayDirectory + "/" + std::to_string(seed) + ".ttrp";
+  std::string error;
+  if (!mReplayWriter.Open(filename.c_str(), header, &error)) {
+    LiveEvent event = NewEvent(LiveEventType::ReplayFailed);
+    event.mSeed = seed;
+    mEvents.Push(event);
+  }
+  mDatasetRecorder.Begin(mGamesStarted++);
+}
+
+LiveEvent LiveGame::NewEvent(LiveEventType type) const {
+  LiveEvent event;
+  memset(&event, 0, sizeof(event));
+  event.mType = type;
+  event.mTetrimino = mGame.mActiveTetrimino;
+  event.mX = (signed char)mGame.mActiveX;
+  event.mY = (signed char)mGame.mActiveY;
+  event.mRotation = (signed char)mGame.mShapeRotation;
+  event.mLatencyNs = -1;
+  return event;
+}
+
+void LiveGame::Publish(double tickEnd) {
+  {
+    PROFILE_ZONE(Core::Zone::Present);
+    mTiles.Update(mGame, mGame.mDirty);
+    mGame.mDirty.Clear();
+  }
+  LiveFrame &frame = mFrames.Back();
+  frame.mTiles = mTiles;
+  frame.mPreviousPose = mPreviousPose;
+  frame.mPose.Capture(mGame);
+  frame.mTickEnd = tickEnd;
+  frame.mTickTime = mTickTime;
+  frame.mRunning = mGame.mRunning;
+  frame.mGamesStarted = mGamesStarted;
+  frame.mLines = mGame.mLines;
+  frame.mDropRate = mGame.mDropRate;
+  frame.mGraded = mFinesse.mGraded;
+  frame.mFaults = mFinesse.mFaults;
+  frame.mUngraded = mFinesse.mUngraded;
+  frame.mLastPresses = mFinesse.mLastPresses;
+  frame.mLastLeast = mFinesse.mLastLeast;
+  frame.mDroppedEvents = mEvents.mDropped;
+  frame.mQuietAllocations = mQuietAllocations;
+  mFrames.Publish();
+  // Presentation diffs the batches it takes, so the changed range is not
+  // carried from one frame to the next.
+  mTiles.ClearChanged();
+  if (Core::nProfileEnabled) {
+    mProfiles.Back() = mProfiler;
+    mProfiles.Publish();
+  }
+}
+
+} // namespace Sim
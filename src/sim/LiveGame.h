@@ -0,0 +1,169 @@
+#ifndef sim_LiveGame_h
+#define sim_LiveGame_h
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "ai/Bot.h"
+#include "ai/Finesse.h"
+#include "core/InputQueue.h"
+#include "core/Profile.h"
+#include "sim/Dataset.h"
+#include "sim/Replay.h"
+#include "sim/Spsc.h"
+#include "view/TileBatch.h"
+
+// The game that is played from the keyboard, stepped on a thread of its own.
+// Presentation sends key changes to the simulation thread and hears back
+// through the latest frame and a stream of events, so a slow frame never
+// delays a step and a slow step never delays a frame. Everything presentation
+// shows is in the frame. Events only start effects and may be dropped when
+// presentation falls behind. Nothing here touches the engine.
+namespace Sim {
+
+enum class LiveEventType : unsigned char {
+  Started,
+  Spawned,
+  // A key shifted or rotated the active tetrimino without locking it. Moves
+  // that no key caused are only seen in the frame.
+  Moved,
+  Locked,
+  RowsCleared,
+  RateIncreased,
+  Ended,
+  // The replay of a game that just started could not be opened.
+  ReplayFailed
+};
+
+// Something that happened during a step. Only the fields that belong to the
+// type are set.
+struct LiveEvent {
+  LiveEventType mType;
+  // The pose of the active tetrimino after a spawn, move or lock.
+  Core::Tetrimino mTetrimino;
+  signed char mX;
+  signed char mY;
+  signed char mRotation;
+  // The rows a clear removed, as in Core::Game::mClearedRows.
+  unsigned char mClearedRowCount;
+  signed char mClearedRows[4];
+  // The time in nanoseconds from the key that caused a move to the step that
+  // made it, or -1 for moves that were not caused by a key.
+  long long mLatencyNs;
+  // The seed of the game whose replay could not be opened.
+  unsigned long long mSeed;
+};
+
+// What presentation draws. A frame is published after every tick.
+struct LiveFrame {
+  View::TileBatch mTiles;
+  // The active tetrimino before and after the most recent step.
+  View::ActivePose mPreviousPose;
+  View::ActivePose mPose;
+  // When the most recent tick ends, in seconds on the clock of the game.
+  // Presentation blends the active tetrimino by how far it is past this.
+  double mTickEnd;
+  float mTickTime;
+  bool mRunning;
+  unsigned int mGamesStarted;
+  int mLines;
+  float mDropRate;
+  // The finesse of every tetrimino so far and of the one that locked last,
+  // as in Ai::FinesseTrainer.
+  long long mGraded;
+  long long mFaults;
+  long long mUngraded;
+  int mLastPresses;
+  int mLastLeast;
+  // The events that did not fit in the ring since Init.
+  unsigned long long mDroppedEvents;
+  // The allocations the simulation thread made during ticks in the middle of
+  // a game played from the keyboard, which should make none. This is always
+  // zero unless allocations are counted.
+  unsigned long long mQuietAllocations;
+};
+
+enum class LiveCommandType : unsigned char { Keys, ToggleBot };
+
+// A request from presentation. Keys give the keys that are held from the
+// time on the clock of the game on.
+struct LiveCommand {
+  LiveCommandType mType;
+  Core::Inputs mInputs;
+  double mTime;
+};
+
+struct LiveGame {
+  // A simulation thread that falls this many ticks behind drops the rest of
+  // the time, like Core::FixedStep.
+  static constexpr int nMaxCatchUp = 8;
+  static constexpr int nMaxStretches = 16;
+  static constexpr int nCommandCapacity = 256;
+  static constexpr int nEventCapacity = 1024;
+
+  // The channels between presentation and the simulation thread.
+  SpscRing<LiveCommand, nCommandCapacity> mCommands;
+  SpscRing<LiveEvent, nEventCapacity> mEvents;
+  TripleBuffer<LiveFrame> mFrames;
+  // The zones of the simulation thread. These are only published when the
+  // zones are compiled in.
+  TripleBuffer<Core::Profiler> mProfiles;
+
+  std::chrono::steady_clock::time_point mEpoch;
+  std::atomic<bool> mStopping;
+  std::thread mThread;
+
+  // Everything below is only used by the simulation thread once it started.
+  Core::Game mGame;
+  float mTickTime;
+  Core::InputQueue mInputQueue;
+  Core::Inputs mPolledInputs;
+  Ai::BotDriver mBot;
+  bool mBotPlaying;
+  Ai::FinesseTrainer mFinesse;
+  // Every game is recorded to a replay in this directory, which is "replays"
+  // unless it is changed after Init.
+  std::string mReplayDirectory;
+  ReplayWriter mReplayWriter;
+  DatasetRecorder mDatasetRecorder;
+  unsigned int mGamesStarted;
+  unsigned long long mQuietAllocations;
+  View::TileBatch mTiles;
+  View::ActivePose mPreviousPose;
+  Core::Profiler mProfiler;
+
+  // Set up the game and publish its first frame. The dataset may be null.
+  void Init(const Ai::BotConfig &botConfig, DatasetWriter *dataset);
+  void Start();
+  // Stop the thread and finish the replay and the dataset records of a game
+  // that is still running. The dataset writer may only be closed after this.
+  void Purge();
+  // Seconds since Init on the clock that steps and key changes are given in.
+  double Now() const;
+
+  // Only called by presentation.
+  void SetKeys(double time, Core::Inputs inputs);
+  void ToggleBot();
+
+  // Only called by the simulation thread.
+  void Run();
+  // Take the commands, step the tick that ends at the given time and publish
+  // its frame.
+  void RunTick(double tickEnd);
+  void TakeCommands();
+  void Tick(double start);
+  // The event time is when the key that was pressed for the step went down,
+  // or negative when no key was pressed.
+  void StepGame(Core::Inputs inputs, float dt, bool startPressed,
+                double eventTime);
+  void StartRecording();
+  // An event of a type that holds the pose after the step.
+  LiveEvent NewEvent(LiveEventType type) const;
+  void Publish(double tickEnd);
+};
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,250 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "sim/MappedFile.h"
+
+namespace Sim {
+
+MappedFile::MappedFile() : mData(nullptr), mSize(0) {
+#ifdef _WIN32
+  mFile = INVALID_HANDLE_VALUE;
+  mMapping = nullptr;
+#else
+  mFile = -1;
+#endif
+}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+SharedMapping::SharedMapping() : mData(nullptr), mSize(0) {
+#ifdef _WIN32
+  mFile = INVALID_HANDLE_VALUE;
+  mMapping = nullptr;
+#else
+  mFile = -1;
+#endif
+}
+
+SharedMapping::~SharedMapping() {
+  Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const char *filename, std::string *error) {
+  Close();
+  mFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    *error = std::string("Failed to open ") + filename + ".";
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(mFile, &size);
+  mSize = (size_t)size.QuadPart;
+  if (mSize == 0) {
+    return true;
+  }
+  mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mMapping != nullptr) {
+    mData = (const unsigned char *)MapViewOfFile(
+        mMapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (mData == nullptr) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mMapping = nullptr;
+  mFile = INVALID_HANDLE_VALUE;
+}
+
+bool SharedMapping::Create(const char *filename, size_t size,
+                           std::string *error) {
+  Close();
+  mFile = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    *error = std::string("Failed to create ") + filename + ".";
+    return false;
+  }
+  // Mapping past the end of the file extends it with zeros.
+  unsigned long long size64 = size;
+  mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READWRITE,
+                                (DWORD)(size64 >> 32), (DWORD)size64, nullptr);
+  if (mMapping != nullptr) {
+    mData = (unsigned char *)MapViewOfFile(
+        mMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  }
+  if (mData == nullptr) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  mSize = size;
+  return true;
+}
+
+bool SharedMapping::Open(const char *filename, std::string *error) {
+  Close();
+  mFile = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    *error = std::string("Failed to open ") + filename + ".";
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(mFile, &size);
+  mMapping =
+      CreateFileMappingA(mFile, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (mMapping != nullptr) {
+    mData = (unsigned char *)MapViewOfFile(
+        mMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  }
+  if (mData == nullptr) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  mSize = (size_t)size.QuadPart;
+  return true;
+}
+
+void SharedMapping::Close() {
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mMapping = nullptr;
+  mFile = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::Open(const char *filename, std::string *error) {
+  Close();
+  mFile = open(filename, O_RDONLY);
+  if (mFile < 0) {
+    *error = std::string("Failed to open ") + filename + ".";
+    return false;
+  }
+  struct stat status;
+  fstat(mFile, &status);
+  mSize = (size_t)status.st_size;
+  if (mSize == 0) {
+    return true;
+  }
+  void *data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+  if (data == MAP_FAILED) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  mData = (const unsigned char *)data;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData != nullptr) {
+    munmap((void *)mData, mSize);
+  }
+  if (mFile >= 0) {
+    close(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mFile = -1;
+}
+
+bool SharedMapping::Create(const char *filename, size_t size,
+                           std::string *error) {
+  Close();
+  mFile = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (mFile < 0) {
+    *error = std::string("Failed to create ") + filename + ".";
+    return false;
+  }
+  // Growing the file fills it with zeros.
+  if (ftruncate(mFile, (off_t)size) != 0) {
+    *error = std::string("Failed to size ") + filename + ".";
+    Close();
+    return false;
+  }
+  void *data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+  if (data == MAP_FAILED) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  mData = (unsigned char *)data;
+  mSize = size;
+  return true;
+}
+
+bool SharedMapping::Open(const char *filename, std::string *error) {
+  Close();
+  mFile = open(filename, O_RDWR);
+  if (mFile < 0) {
+    *error = std::string("Failed to open ") + filename + ".";
+    return false;
+  }
+  struct stat status;
+  fstat(mFile, &status);
+  size_t size = (size_t)status.st_size;
+  void *data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+  if (size == 0 || data == MAP_FAILED) {
+    *error = std::string("Failed to map ") + filename + ".";
+    Close();
+    return false;
+  }
+  mData = (unsigned char *)data;
+  mSize = size;
+  return true;
+}
+
+void SharedMapping::Close() {
+  if (mData != nullptr) {
+    munmap(mData, mSize);
+  }
+  if (mFile >= 0) {
+    close(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mFile = -1;
+}
+#endif
+
+} // namespace Sim
@@ -0,0 +1,50 @@
+#ifndef sim_MappedFile_h
+#define sim_MappedFile_h
+
+#include <stddef.h>
+#include <string>
+
+namespace Sim {
+
+// A read only view of a whole file that is mapped into memory.
+struct MappedFile {
+  const unsigned char *mData;
+  size_t mSize;
+#ifdef _WIN32
+  void *mFile;
+  void *mMapping;
+#else
+  int mFile;
+#endif
+
+  MappedFile();
+  ~MappedFile();
+  bool Open(const char *filename, std::string *error);
+  void Close();
+};
+
+// A writable view of a whole file that is shared with every process that maps
+// the same file. Writes through the view are seen by the other processes
+// without going through the file system.
+struct SharedMapping {
+  unsigned char *mData;
+  size_t mSize;
+#ifdef _WIN32
+  void *mFile;
+  void *mMapping;
+#else
+  int mFile;
+#endif
+
+  SharedMapping();
+  ~SharedMapping();
+  // Create a file of the given size that is filled with zeros and map it. A
+  // file that already has the name is replaced.
+  bool Create(const char *filename, size_t size, std::string *error);
+  bool Open(const char *filename, std::string *error);
+  void Close();
+};
+
+} // namespace Sim
+
+#endif
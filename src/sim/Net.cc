@@ -0,0 +1,154 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+
+#include "sim/Net.h"
+
+namespace Sim {
+
+#ifdef _WIN32
+constexpr unsigned long long nNoSocket = (unsigned long long)INVALID_SOCKET;
+#else
+constexpr int nNoSocket = -1;
+#endif
+
+UdpSocket::UdpSocket() : mSocket(nNoSocket), mPeerAddress(0), mPeerPort(0) {}
+
+UdpSocket::~UdpSocket() {
+  Close();
+}
+
+bool UdpSocket::Open(unsigned short port, const char *peerHost,
+                     unsigned short peerPort, std::string *error) {
+  Close();
+#ifdef _WIN32
+  static bool started = false;
+  if (!started) {
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+      *error = "Failed to start winsock.";
+      return false;
+    }
+    started = true;
+  }
+#endif
+  in_addr peer;
+  if (inet_pton(AF_INET, peerHost, &peer) != 1) {
+    *error = std::string("Invalid peer address ") + peerHost + ".";
+    return false;
+  }
+  mPeerAddress = peer.s_addr;
+  mPeerPort = htons(peerPort);
+
+  mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (mSocket == nNoSocket) {
+    *error = "Failed to create a socket.";
+    return false;
+  }
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  local.sin_port = htons(port);
+  if (bind(mSocket, (const sockaddr *)&local, sizeof(local)) != 0) {
+    *error = "Failed to bind port " + std::to_string(port) + ".";
+    Close();
+    return false;
+  }
+#ifdef _WIN32
+  u_long nonBlocking = 1;
+  bool failed = ioctlsocket(mSocket, FIONBIO, &nonBlocking) != 0;
+#else
+  bool failed =
+      fcntl(mSocket, F_SETFL, fcntl(mSocket, F_GETFL, 0) | O_NONBLOCK) != 0;
+#endif
+  if (failed) {
+    *error = "Failed to make the socket non-blocking.";
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void UdpSocket::Close() {
+  if (mSocket == nNoSocket) {
+    return;
+  }
+#ifdef _WIN32
+  closesocket(mSocket);
+#else
+  close(mSocket);
+#endif
+  mSocket = nNoSocket;
+}
+
+bool UdpSocket::Send(const unsigned char *data, size_t size) {
+  sockaddr_in peer;
+  memset(&peer, 0, sizeof(peer));
+  peer.sin_family = AF_INET;
+  peer.sin_addr.s_addr = mPeerAddress;
+  peer.sin_port = mPeerPort;
+  return sendto(mSocket, (const char *)data, (int)size, 0,
+                (const sockaddr *)&peer, sizeof(peer)) == (int)size;
+}
+
+size_t UdpSocket::Receive(unsigned char *buffer, size_t capacity) {
+  // Errors, including that nothing is waiting, read as an empty socket.
+  int size = (int)recvfrom(mSocket, (char *)buffer, (int)capacity, 0, nullptr,
+                           nullptr);
+  return size > 0 ? (size_t)size : 0;
+}
+
+void LinkSimulator::Init(
+    double latency, double jitter, float loss, unsigned long long seed) {
+  mLatency = latency;
+  mJitter = jitter;
+  mLoss = loss;
+  mRandom.Seed(seed);
+  mInFlight.clear();
+}
+
+void LinkSimulator::Send(const unsigned char *data, size_t size, double now) {
+  double chance = mRandom.Next() * (1.0 / 4294967296.0);
+  double offset = mRandom.Next() * (2.0 / 4294967296.0) - 1.0;
+  if (chance < mLoss || size > nMaxDatagramSize) {
+    return;
+  }
+  Datagram datagram;
+  datagram.mArrivalTime = now + mLatency + offset * mJitter;
+  datagram.mSize = size;
+  memcpy(datagram.mData, data, size);
+  mInFlight.push_back(datagram);
+}
+
+size_t LinkSimulator::Receive(unsigned char *buffer, double now) {
+  // Jitter reorders datagrams, so the earliest arrival is searched for.
+  int earliest = -1;
+  for (int i = 0; i < (int)mInFlight.size(); ++i) {
+    if (mInFlight[i].mArrivalTime <= now &&
+        (earliest < 0 ||
+         mInFlight[i].mArrivalTime < mInFlight[earliest].mArrivalTime)) {
+      earliest = i;
+    }
+  }
+  if (earliest < 0) {
+    return 0;
+  }
+  const Datagram &datagram = mInFlight[earliest];
+  size_t size = datagram.mSize;
+  memcpy(buffer, datagram.mData, size);
+  mInFlight[earliest] = mInFlight.back();
+  mInFlight.pop_back();
+  return size;
+}
+
+} // namespace Sim
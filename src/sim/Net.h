@@ -0,0 +1,63 @@
+#ifndef sim_Net_h
+#define sim_Net_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "core/Random.h"
+
+namespace Sim {
+
+// The largest datagram that is sent or received.
+constexpr size_t nMaxDatagramSize = 512;
+
+// A non-blocking IPv4 UDP socket that sends to a single peer.
+struct UdpSocket {
+#ifdef _WIN32
+  unsigned long long mSocket;
+#else
+  int mSocket;
+#endif
+  unsigned int mPeerAddress;
+  unsigned short mPeerPort;
+
+  UdpSocket();
+  ~UdpSocket();
+  // Bind to the port on every interface and send to the peer from then on.
+  bool Open(unsigned short port, const char *peerHost,
+            unsigned short peerPort, std::string *error);
+  void Close();
+  bool Send(const unsigned char *data, size_t size);
+  // Returns the size of the datagram that was read, or 0 when none is waiting.
+  size_t Receive(unsigned char *buffer, size_t capacity);
+};
+
+// Delays, reorders and drops datagrams the way a network would. Time is given
+// by the caller, so a link can run in virtual time faster than real time, and
+// the link is deterministic for a seed.
+struct LinkSimulator {
+  struct Datagram {
+    double mArrivalTime;
+    size_t mSize;
+    unsigned char mData[nMaxDatagramSize];
+  };
+
+  // One way latency and the most it varies by, in seconds.
+  double mLatency;
+  double mJitter;
+  // The chance that a datagram is lost.
+  float mLoss;
+  Core::Random mRandom;
+  std::vector<Datagram> mInFlight;
+
+  void Init(double latency, double jitter, float loss, unsigned long long seed);
+  void Send(const unsigned char *data, size_t size, double now);
+  // Take a datagram that has arrived by now. Returns its size, or 0 when none
+  // has arrived.
+  size_t Receive(unsigned char *buffer, double now);
+};
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,116 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char **environ;
+#endif
+
+#include "sim/Process.h"
+
+namespace Sim {
+
+#ifdef _WIN32
+ChildProcess::ChildProcess() : mProcess(nullptr), mExitCode(0) {}
+
+bool ChildProcess::Start(const std::vector<std::string> &args,
+                         std::string *error) {
+  // Every argument is quoted, so arguments may hold spaces but not quotes.
+  std::string commandLine;
+  for (const std::string &arg : args) {
+    commandLine += (commandLine.empty() ? "\"" : " \"") + arg + "\"";
+  }
+  STARTUPINFOA startup = {};
+  startup.cb = sizeof(startup);
+  PROCESS_INFORMATION info = {};
+  if (!CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, FALSE, 0,
+                      nullptr, nullptr, &startup, &info)) {
+    *error = "Failed to start " + args[0] + ".";
+    return false;
+  }
+  CloseHandle(info.hThread);
+  mProcess = info.hProcess;
+  return true;
+}
+
+bool ChildProcess::Running() {
+  if (mProcess == nullptr) {
+    return false;
+  }
+  if (WaitForSingleObject(mProcess, 0) == WAIT_TIMEOUT) {
+    return true;
+  }
+  Wait();
+  return false;
+}
+
+int ChildProcess::Wait() {
+  if (mProcess == nullptr) {
+    return mExitCode;
+  }
+  WaitForSingleObject(mProcess, INFINITE);
+  DWORD exitCode = 0;
+  GetExitCodeProcess(mProcess, &exitCode);
+  CloseHandle(mProcess);
+  mProcess = nullptr;
+  mExitCode = (int)exitCode;
+  return mExitCode;
+}
+#else
+ChildProcess::ChildProcess() : mPid(-1), mExitCode(0) {}
+
+bool ChildProcess::Start(const std::vector<std::string> &args,
+                         std::string *error) {
+  std::vector<char *> argv;
+  for (const std::string &arg : args) {
+    argv.push_back((char *)arg.c_str());
+  }
+  argv.push_back(nullptr);
+  pid_t pid;
+  if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) !=
+      0) {
+    *error = "Failed to start " + args[0] + ".";
+    return false;
+  }
+  mPid = (int)pid;
+  return true;
+}
+
+// A process that was killed by a signal exits with 128 plus the signal, as it
+// does in a shell.
+int ExitCode(int status) {
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : 1;
+}
+
+bool ChildProcess::Running() {
+  if (mPid < 0) {
+    return false;
+  }
+  int status = 0;
+  pid_t result = waitpid((pid_t)mPid, &status, WNOHANG);
+  if (result == 0) {
+    return true;
+  }
+  mExitCode = result > 0 ? ExitCode(status) : 1;
+  mPid = -1;
+  return false;
+}
+
+int ChildProcess::Wait() {
+  if (mPid < 0) {
+    return mExitCode;
+  }
+  int status = 0;
+  pid_t result = waitpid((pid_t)mPid, &status, 0);
+  mExitCode = result > 0 ? ExitCode(status) : 1;
+  mPid = -1;
+  return mExitCode;
+}
+#endif
+
+} // namespace Sim
@@ -0,0 +1,30 @@
+#ifndef sim_Process_h
+#define sim_Process_h
+
+#include <string>
+#include <vector>
+
+namespace Sim {
+
+// A process started from a program and its arguments. The program is looked
+// up on the path when it is not a path itself.
+struct ChildProcess {
+#ifdef _WIN32
+  void *mProcess;
+#else
+  int mPid;
+#endif
+  int mExitCode;
+
+  ChildProcess();
+  // The first argument is the program.
+  bool Start(const std::vector<std::string> &args, std::string *error);
+  // False once the process has exited.
+  bool Running();
+  // Block until the process exits and get its exit code.
+  int Wait();
+};
+
+} // namespace Sim
+
+#endif
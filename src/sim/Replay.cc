@@ -0,0 +1,246 @@
+#include <string.h>
+
+#include "sim/Bytes.h"
+#include "sim/Dataset.h"
+#include "sim/MappedFile.h"
+#include "sim/Replay.h"
+
+namespace Sim {
+
+const char nReplayMagic[4] = {'T', 'T', 'R', 'P'};
+
+void EncodeHeader(unsigned char bytes[ReplayHeader::nSize],
+                  const ReplayHeader &header) {
+  memcpy(bytes, nReplayMagic, sizeof(nReplayMagic));
+  EncodeU16(bytes + 4, ReplayHeader::nVersion);
+  EncodeU16(bytes + 6, header.mFlags);
+  EncodeU64(bytes + 8, header.mSeed);
+  EncodeU32(bytes + 16, header.mPreviewLength);
+  EncodeF32(bytes + 20, header.mTickTime);
+  EncodeU64(bytes + 24, header.mTickCount);
+}
+
+ReplayWriter::ReplayWriter() : mFile(nullptr) {}
+
+bool ReplayWriter::Open(const char *filename, const ReplayHeader &header,
+                        std::string *error) {
+  Close();
+  mFile = fopen(filename, "wb");
+  if (mFile == nullptr) {
+    *error = std::string("Failed to open ") + filename + " for writing.";
+    return false;
+  }
+  mHeader = header;
+  mHeader.mTickCount = 0;
+  unsigned char headerBytes[ReplayHeader::nSize];
+  EncodeHeader(headerBytes, mHeader);
+  mBufferSize = 0;
+  WriteBytes(headerBytes, sizeof(headerBytes));
+  mRunLength = 0;
+  return true;
+}
+
+void ReplayWriter::Record(Core::Inputs inputs, float dt) {
+  bool variable = mHeader.mFlags & ReplayFlag::VariableTickTime;
+  bool sameRun = inputs == mRunInputs && (!variable || dt == mRunTime);
+  if (mRunLength > 0 && !sameRun) {
+    WriteRun();
+  }
+  if (mRunLength == 0) {
+    mRunInputs = inputs;
+    mRunTime = dt;
+  }
+  ++mRunLength;
+  ++mHeader.mTickCount;
+}
+
+void ReplayWriter::Close() {
+  if (mFile == nullptr) {
+    return;
+  }
+  WriteRun();
+  Flush();
+
+  // Now that the recording is complete, the tick count can be filled in.
+  unsigned char headerBytes[ReplayHeader::nSize];
+  EncodeHeader(headerBytes, mHeader);
+  fseek(mFile, 0, SEEK_SET);
+  fwrite(headerBytes, 1, sizeof(headerBytes), mFile);
+  fclose(mFile);
+  mFile = nullptr;
+}
+
+bool ReplayWriter::IsOpen() const {
+  return mFile != nullptr;
+}
+
+void ReplayWriter::WriteRun() {
+  if (mRunLength == 0) {
+    return;
+  }
+  unsigned char bytes[16];
+  size_t size = 0;
+  unsigned long long length = mRunLength;
+  do {
+    unsigned char byte = length & 0x7f;
+    length >>= 7;
+    bytes[size++] = length != 0 ? byte | 0x80 : byte;
+  } while (length != 0);
+  bytes[size++] = mRunInputs;
+  if (mHeader.mFlags & ReplayFlag::VariableTickTime) {
+    EncodeF32(bytes + size, mRunTime);
+    size += 4;
+  }
+  WriteBytes(bytes, size);
+  mRunLength = 0;
+}
+
+void ReplayWriter::WriteBytes(const void *bytes, size_t size) {
+  if (mBufferSize + size > sizeof(mBuffer)) {
+    Flush();
+  }
+  memcpy(mBuffer + mBufferSize, bytes, size);
+  mBufferSize += size;
+}
+
+void ReplayWriter::Flush() {
+  fwrite(mBuffer, 1, mBufferSize, mFile);
+  mBufferSize = 0;
+}
+
+// NaN fails both comparisons.
+bool ValidStepTime(float dt) {
+  return dt >= 0.0f && dt <= Core::nMaxStepTime;
+}
+
+bool ReplayReader::Open(const unsigned char *data, size_t size,
+                        std::string *error) {
+  if (size < ReplayHeader::nSize ||
+      memcmp(data, nReplayMagic, sizeof(nReplayMagic)) != 0) {
+    *error = "Not a replay.";
+    return false;
+  }
+  if (DecodeU16(data + 4) != ReplayHeader::nVersion) {
+    *error = "Unsupported replay version.";
+    return false;
+  }
+  mData = data;
+  mSize = size;
+  mOffset = ReplayHeader::nSize;
+  mHeader.mFlags = DecodeU16(data + 6);
+  mHeader.mSeed = DecodeU64(data + 8);
+  mHeader.mPreviewLength = DecodeU32(data + 16);
+  mHeader.mTickTime = DecodeF32(data + 20);
+  mHeader.mTickCount = DecodeU64(data + 24);
+  if (!ValidStepTime(mHeader.mTickTime) || mHeader.mTickTime == 0.0f) {
+    *error = "The replay's tick time is invalid.";
+    return false;
+  }
+  return true;
+}
+
+bool ReplayReader::NextRun(
+    Core::Inputs *inputs, float *dt, unsigned long long *length) {
+  size_t offset = mOffset;
+  unsigned long long value = 0;
+  int shift = 0;
+  while (true) {
+    if (offset >= mSize || shift > 63) {
+      return false;
+    }
+    unsigned char byte = mData[offset++];
+    value |= (unsigned long long)(byte & 0x7f) << shift;
+    shift += 7;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  if (offset >= mSize) {
+    return false;
+  }
+  *inputs = mData[offset++];
+  *dt = mHeader.mTickTime;
+  if (mHeader.mFlags & ReplayFlag::VariableTickTime) {
+    if (offset + 4 > mSize) {
+      return false;
+    }
+    *dt = DecodeF32(mData + offset);
+    offset += 4;
+  }
+  *length = value;
+  mOffset = offset;
+  return true;
+}
+
+bool PlayReplay(const unsigned char *data, size_t size, ReplayResult *result,
+                std::string *error, DatasetRecorder *recorder) {
+  ReplayReader reader;
+  if (!reader.Open(data, size, error)) {
+    return false;
+  }
+  // Runs are checked against the steps that are left before any of their
+  // steps are played.
+  unsigned long long budget = reader.mHeader.mTickCount;
+  if (budget == 0) {
+    budget = ReplayHeader::nMaxTickCount;
+  } else if (budget > ReplayHeader::nMaxTickCount) {
+    *error = "The replay's tick count is too large.";
+    return false;
+  }
+  Core::Game game;
+  game.Init(reader.mHeader.mSeed, (int)reader.mHeader.mPreviewLength);
+  result->mTicks = 0;
+  result->mPieces = 0;
+  result->mToppedOut = false;
+  Core::Inputs inputs;
+  float dt;
+  unsigned long long length;
+  while (reader.NextRun(&inputs, &dt, &length)) {
+    if (length > budget - result->mTicks) {
+      *error = "A run of the replay is longer than the steps left.";
+      return false;
+    }
+    if (!ValidStepTime(dt)) {
+      *error = "A run of the replay has an invalid step time.";
+      return false;
+    }
+    for (unsigned long long i = 0; i < length; ++i) {
+      if (recorder != nullptr) {
+        recorder->Before(game);
+      }
+      game.Step(inputs, dt);
+      if (recorder != nullptr) {
+        recorder->After(game);
+      }
+      if (game.mEvents & Core::Event::Locked) {
+        ++result->mPieces;
+      }
+      if (game.mEvents & Core::Event::Ended) {
+        result->mToppedOut = true;
+      }
+    }
+    result->mTicks += length;
+  }
+  result->mLines = game.mLines;
+  if (reader.mOffset != reader.mSize) {
+    *error = "The replay is malformed.";
+    return false;
+  }
+  if (reader.mHeader.mTickCount != 0 &&
+      reader.mHeader.mTickCount != result->mTicks) {
+    *error = "The replay's tick count does not match its runs.";
+    return false;
+  }
+  return true;
+}
+
+bool PlayReplayFile(const char *filename, ReplayResult *result,
+                    std::string *error, DatasetRecorder *recorder) {
+  MappedFile file;
+  if (!file.Open(filename, error)) {
+    return false;
+  }
+  return PlayReplay(file.mData, file.mSize, result, error, recorder);
+}
+
+} // namespace Sim
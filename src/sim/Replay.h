@@ -0,0 +1,108 @@
+#ifndef sim_Replay_h
+#define sim_Replay_h
+
+#include <stdio.h>
+#include <string>
+
+#include "core/Game.h"
+
+// A replay is everything needed to simulate a game again: the seed and preview
+// length the game was initialized with and the keys held during every step.
+//
+// A replay file starts with a 32 byte header. All values are little endian.
+//   0  char[4] "TTRP"
+//   4  u16     version
+//   6  u16     flags
+//   8  u64     seed
+//   16 u32     preview length
+//   20 f32     tick time
+//   24 u64     tick count
+// The header is followed by runs of steps that held the same keys. A run is a
+// LEB128 step count followed by a byte with the held keys. Replays of games
+// that were stepped with varying amounts of time set the VariableTickTime flag
+// and every run also stores its step time as an f32. The tick count is written
+// when a recording is finished, so a file with a tick count of zero was cut
+// short and is played until its runs end. No replay is played for more than
+// nMaxTickCount steps, so a corrupt run length cannot keep a player stepping
+// for hours. Step times must be finite and no longer than Core::nMaxStepTime.
+// The tick time must also be positive, while a run may take no time, as the
+// stretch of a key change that happened at the start of a tick does.
+namespace Sim {
+
+struct DatasetRecorder;
+
+namespace ReplayFlag {
+constexpr unsigned short VariableTickTime = 1 << 0;
+} // namespace ReplayFlag
+
+struct ReplayHeader {
+  // Version 2 replays were recorded with steps that drop and shift as many
+  // times as their time allows for.
+  static constexpr unsigned short nVersion = 2;
+  static constexpr size_t nSize = 32;
+  // About 52 days of steps at 60 per second.
+  static constexpr unsigned long long nMaxTickCount = 1ull << 28;
+
+  unsigned short mFlags;
+  unsigned long long mSeed;
+  unsigned int mPreviewLength;
+  float mTickTime;
+  unsigned long long mTickCount;
+};
+
+// Streams a replay to a file while a game is being played. Steps are buffered
+// and runs are only written once they end, so recording a step is usually a
+// comparison and an increment. The file stays open until Close is called.
+struct ReplayWriter {
+  FILE *mFile;
+  ReplayHeader mHeader;
+  unsigned char mBuffer[4096];
+  size_t mBufferSize;
+
+  // The run that is currently being recorded.
+  Core::Inputs mRunInputs;
+  float mRunTime;
+  unsigned long long mRunLength;
+
+  ReplayWriter();
+  bool Open(const char *filename, const ReplayHeader &header,
+            std::string *error);
+  void Record(Core::Inputs inputs, float dt);
+  void Close();
+  bool IsOpen() const;
+
+  void WriteRun();
+  void WriteBytes(const void *bytes, size_t size);
+  void Flush();
+};
+
+// Walks the runs of a replay that is already in memory.
+struct ReplayReader {
+  const unsigned char *mData;
+  size_t mSize;
+  size_t mOffset;
+  ReplayHeader mHeader;
+
+  bool Open(const unsigned char *data, size_t size, std::string *error);
+  // Get the next run. False is returned once the runs end or the data is
+  // malformed. mOffset is left at mSize only when all of the runs were read.
+  bool NextRun(Core::Inputs *inputs, float *dt, unsigned long long *length);
+};
+
+struct ReplayResult {
+  unsigned long long mTicks;
+  int mPieces;
+  int mLines;
+  bool mToppedOut;
+};
+
+// Simulate a replay from start to finish as fast as possible. Every tetrimino
+// that locks is recorded when a recorder is given.
+bool PlayReplay(const unsigned char *data, size_t size, ReplayResult *result,
+                std::string *error, DatasetRecorder *recorder = nullptr);
+bool PlayReplayFile(const char *filename, ReplayResult *result,
+                    std::string *error, DatasetRecorder *recorder = nullptr);
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <limits.h>
+
+#include "core/FixedStep.h"
+#include "sim/Rollback.h"
+
+namespace Sim {
+
+// A packet starts with a header of
+//   'T' 'R' <version> <input count>
+//   <acknowledged frame, 32 bit little endian>
+//   <frame of the first input, 32 bit little endian>
+// followed by one byte of keys per input.
+constexpr unsigned char nPacketVersion = 1;
+constexpr size_t nPacketHeaderSize = 12;
+static_assert(RollbackSession::nMaxPacketSize ==
+                  nPacketHeaderSize + RollbackSession::nMaxPacketInputs,
+              "The packet size must fit the header and the inputs.");
+
+void WriteFrame(unsigned char *bytes, int frame) {
+  unsigned int value = (unsigned int)frame;
+  for (int i = 0; i < 4; ++i) {
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+int ReadFrame(const unsigned char *bytes) {
+  unsigned int value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= (unsigned int)bytes[i] << (8 * i);
+  }
+  return (int)value;
+}
+
+void RollbackConfig::SetDefaults() {
+  mLocalPlayer = 0;
+  mInputDelay = 2;
+  mMaxRollback = 8;
+  mSeed = 1;
+  mTickTime = 1.0f / (float)DEFAULT_TICK_RATE;
+}
+
+void RollbackSession::Init(const RollbackConfig &config) {
+  // Unacknowledged local keys and the snapshots of a rollback must both stay
+  // within the window. Each side runs at most mMaxRollback frames ahead of
+  // what it received, so the local keys span at most twice that plus the
+  // input delay.
+  mConfig = config;
+  mConfig.mLocalPlayer = config.mLocalPlayer == 0 ? 0 : 1;
+  mConfig.mInputDelay = std::min(std::max(config.mInputDelay, 0), 8);
+  mConfig.mMaxRollback =
+      std::min(std::max(config.mMaxRollback, 1), nMaxPacketInputs / 2);
+  for (Core::Game &game : mGames) {
+    game.Init(mConfig.mSeed);
+    game.StartGame();
+  }
+  mSnapshots.Clear();
+  mFrame = 0;
+  for (int i = 0; i < nWindow; ++i) {
+    mLocalInputs[i] = 0;
+    mRemoteInputs[i] = 0;
+    mRemoteFrames[i] = -1;
+    mUsedRemoteInputs[i] = 0;
+  }
+  mRemoteReceived = 0;
+  mLocalAcknowledged = 0;
+  mFirstMismatch = INT_MAX;
+  mStats = RollbackStats();
+}
+
+bool RollbackSession::Advance(Core::Inputs localInputs) {
+  if (mFrame - mRemoteReceived >= mConfig.mMaxRollback) {
+    ++mStats.mStalls;
+    return false;
+  }
+  mLocalInputs[(mFrame + mConfig.mInputDelay) % nWindow] = localInputs;
+  Synchronize();
+  StepFrame(mFrame);
+  ++mFrame;
+  ++mStats.mFrames;
+  return true;
+}
+
+void RollbackSession::Synchronize() {
+  if (mFirstMismatch < mFrame) {
+    const FrameSnapshot *snapshot = mSnapshots.Find(mFirstMismatch);
+    for (int i = 0; i < 2; ++i) {
+      snapshot->mGames[i].Restore(&mGames[i]);
+    }
+    int depth = mFrame - mFirstMismatch;
+    for (int frame = mFirstMismatch; frame < mFrame; ++frame) {
+      StepFrame(frame);
+    }
+    ++mStats.mRollbacks;
+    mStats.mResimulatedFrames += depth;
+    mStats.mDeepestRollback = std::max(mStats.mDeepestRollback, depth);
+  }
+  mFirstMismatch = INT_MAX;
+}
+
+size_t RollbackSession::WritePacket(unsigned char *packet) const {
+  int first = mLocalAcknowledged;
+  int end = mFrame + mConfig.mInputDelay;
+  int count = std::min(std::max(end - first, 0), nMaxPacketInputs);
+  packet[0] = 'T';
+  packet[1] = 'R';
+  packet[2] = nPacketVersion;
+  packet[3] = (unsigned char)count;
+  WriteFrame(packet + 4, mRemoteReceived);
+  WriteFrame(packet + 8, first);
+  for (int i = 0; i < count; ++i) {
+    packet[nPacketHeaderSize + i] = mLocalInputs[(first + i) % nWindow];
+  }
+  return nPacketHeaderSize + count;
+}
+
+bool RollbackSession::ReadPacket(const unsigned char *packet, size_t size) {
+  if (size < nPacketHeaderSize || packet[0] != 'T' || packet[1] != 'R' ||
+      packet[2] != nPacketVersion || packet[3] > nMaxPacketInputs ||
+      size != nPacketHeaderSize + packet[3]) {
+    ++mStats.mPacketsRejected;
+    return false;
+  }
+  int count = packet[3];
+  int acknowledged = ReadFrame(packet + 4);
+  int first = ReadFrame(packet + 8);
+  // Keys from past the window are never sent by a well behaved peer, and
+  // rejecting them up front keeps the frames below from overflowing.
+  if (acknowledged < 0 || first < 0 ||
+      acknowledged > mFrame + mConfig.mInputDelay ||
+      first > mRemoteReceived + nWindow || first > INT_MAX - count) {
+    ++mStats.mPacketsRejected;
+    return false;
+  }
+  ++mStats.mPacketsRead;
+  mLocalAcknowledged = std::max(mLocalAcknowledged, acknowledged);
+
+  // Packets may arrive late, twice or out of order, so only the keys of frames
+  // that are missing and fit in the window are taken.
+  for (int i = 0; i < count; ++i) {
+    int frame = first + i;
+    if (frame < mRemoteReceived || frame >= mRemoteReceived + nWindow ||
+        RemoteReceived(frame)) {
+      continue;
+    }
+    Core::Inputs inputs = packet[nPacketHeaderSize + i];
+    mRemoteInputs[frame % nWindow] = inputs;
+    mRemoteFrames[frame % nWindow] = frame;
+    if (frame < mFrame && mUsedRemoteInputs[frame % nWindow] != inputs) {
+      mFirstMismatch = std::min(mFirstMismatch, frame);
+    }
+  }
+  while (RemoteReceived(mRemoteReceived)) {
+    ++mRemoteReceived;
+  }
+  return true;
+}
+
+bool RollbackSession::RemoteReceived(int frame) const {
+  return mRemoteFrames[frame % nWindow] == frame;
+}
+
+Core::Inputs RollbackSession::RemoteInputs(int frame) const {
+  if (RemoteReceived(frame)) {
+    return mRemoteInputs[frame % nWindow];
+  }
+  if (mRemoteReceived == 0) {
+    return 0;
+  }
+  return mRemoteInputs[(mRemoteReceived - 1) % nWindow];
+}
+
+void RollbackSession::StepFrame(int frame) {
+  FrameSnapshot *snapshot = mSnapshots.Slot(frame);
+  for (int i = 0; i < 2; ++i) {
+    snapshot->mGames[i].Save(mGames[i]);
+  }
+  Core::Inputs local = mLocalInputs[frame % nWindow];
+  Core::Inputs remote = RemoteInputs(frame);
+  mUsedRemoteInputs[frame % nWindow] = remote;
+  int localPlayer = mConfig.mLocalPlayer;
+  mGames[localPlayer].Step(local, mConfig.mTickTime);
+  mGames[1 - localPlayer].Step(remote, mConfig.mTickTime);
+}
+
+unsigned long long RollbackSession::Checksum() const {
+  unsigned long long hash = 0;
+  for (int i = 0; i < 2; ++i) {
+    Core::Snapshot snapshot;
+    snapshot.Save(mGames[i]);
+    hash = hash * 0x100000001b3ull ^ snapshot.Checksum();
+  }
+  return hash;
+}
+
+} // namespace Sim
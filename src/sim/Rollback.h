@@ -0,0 +1,102 @@
+#ifndef sim_Rollback_h
+#define sim_Rollback_h
+
+#include <stddef.h>
+
+#include "core/Snapshot.h"
+
+// A game of two players on two machines. Both machines step both games every
+// frame. A machine knows its own keys right away, and it predicts the
+// opponent's keys by repeating the last keys it received. When the real keys
+// of a frame arrive and differ from the prediction, the games are restored to
+// the snapshot taken before that frame and stepped again up to the present.
+// Local play therefore never waits on the network unless the opponent falls
+// more than mMaxRollback frames behind.
+//
+// The session does not own a socket. Packets are written with WritePacket and
+// handed to ReadPacket by whoever moves them, so the same session runs over
+// UDP, over a simulated link or within a single process.
+namespace Sim {
+
+struct RollbackConfig {
+  // The player whose keys this machine gives, 0 or 1.
+  int mLocalPlayer;
+  // Local keys take effect this many frames after they are given, which hides
+  // that much latency without any rollback.
+  int mInputDelay;
+  // The most frames that are stepped with predicted keys before the session
+  // waits for the opponent.
+  int mMaxRollback;
+  unsigned long long mSeed;
+  float mTickTime;
+
+  void SetDefaults();
+};
+
+struct RollbackStats {
+  long long mFrames;
+  long long mStalls;
+  long long mRollbacks;
+  long long mResimulatedFrames;
+  int mDeepestRollback;
+  long long mPacketsRead;
+  long long mPacketsRejected;
+};
+
+// The snapshots of both games taken before a frame.
+struct FrameSnapshot {
+  Core::Snapshot mGames[2];
+};
+
+struct RollbackSession {
+  // The window of frames that inputs and snapshots are kept for.
+  static constexpr int nWindow = 64;
+  static constexpr int nMaxPacketInputs = 32;
+  static constexpr size_t nMaxPacketSize = 12 + nMaxPacketInputs;
+
+  RollbackConfig mConfig;
+  Core::Game mGames[2];
+  Core::SnapshotRing<FrameSnapshot, nWindow> mSnapshots;
+
+  // The next frame to step.
+  int mFrame;
+  // The local keys of every frame up to mFrame + mInputDelay.
+  Core::Inputs mLocalInputs[nWindow];
+  // The remote keys that were received and the frame each slot holds keys
+  // for. A slot that holds a different frame has not been received.
+  Core::Inputs mRemoteInputs[nWindow];
+  int mRemoteFrames[nWindow];
+  // The remote keys every stepped frame was stepped with.
+  Core::Inputs mUsedRemoteInputs[nWindow];
+  // Every remote frame before this one has been received.
+  int mRemoteReceived;
+  // Every local frame before this one has been acknowledged by the opponent.
+  int mLocalAcknowledged;
+  // The earliest stepped frame whose prediction was wrong. It is not less
+  // than mFrame while every prediction held.
+  int mFirstMismatch;
+
+  RollbackStats mStats;
+
+  void Init(const RollbackConfig &config);
+  // Step a frame with the given local keys. False is returned without stepping
+  // when the opponent is too far behind.
+  bool Advance(Core::Inputs localInputs);
+  // Apply any corrections that arrived since the last frame.
+  void Synchronize();
+  // Write the local keys the opponent has not acknowledged and return the
+  // size of the packet.
+  size_t WritePacket(unsigned char *packet) const;
+  // Returns false for packets that are malformed.
+  bool ReadPacket(const unsigned char *packet, size_t size);
+
+  bool RemoteReceived(int frame) const;
+  Core::Inputs RemoteInputs(int frame) const;
+  void StepFrame(int frame);
+  // A hash of both games as they are now.
+  unsigned long long Checksum() const;
+};
+
+} // namespace Sim
+
+#endif
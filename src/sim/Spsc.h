@@ -0,0 +1,117 @@
+#ifndef sim_Spsc_h
+#define sim_Spsc_h
+
+#include <stddef.h>
+#include <atomic>
+
+// Channels between exactly one producer thread and one consumer thread.
+// Neither side takes a lock, waits on the other or allocates, so a thread that
+// stalls never holds up the thread on the other end.
+namespace Sim {
+
+// Indices written by different threads are kept on different cache lines so
+// that a write by one side does not evict the line the other side reads.
+constexpr size_t nCacheLineSize = 64;
+
+// A fixed ring of items. The head and tail count every item that was ever
+// popped and pushed and wrap around at 2^32, which the power of two capacity
+// divides. Items pushed while the ring is full are dropped and counted.
+template <typename T, int Capacity>
+struct SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "The capacity must be a power of two.");
+  static constexpr unsigned int nMask = (unsigned int)Capacity - 1;
+
+  // The head is written by the consumer and the tail by the producer.
+  alignas(nCacheLineSize) std::atomic<unsigned int> mHead;
+  alignas(nCacheLineSize) std::atomic<unsigned int> mTail;
+  // Only used by the producer.
+  unsigned long long mDropped;
+  T mItems[Capacity];
+
+  // Neither side may be using the ring.
+  void Clear() {
+    mHead.store(0, std::memory_order_relaxed);
+    mTail.store(0, std::memory_order_relaxed);
+    mDropped = 0;
+  }
+
+  bool Push(const T &item) {
+    unsigned int tail = mTail.load(std::memory_order_relaxed);
+    unsigned int head = mHead.load(std::memory_order_acquire);
+    if (tail - head == (unsigned int)Capacity) {
+      ++mDropped;
+      return false;
+    }
+    mItems[tail & nMask] = item;
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool Pop(T *item) {
+    unsigned int head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *item = mItems[head & nMask];
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+// The latest value a producer published. This is a double buffer with a spare
+// slot: the producer writes the back slot while the consumer reads the front
+// slot, and the spare in the middle holds the value that was published last.
+// Publishing swaps the back slot with the middle and taking swaps the front
+// slot with the middle, so the consumer always reads a whole value and the
+// producer never waits for the consumer to finish with one. Values that are
+// published faster than they are taken are skipped.
+template <typename T>
+struct TripleBuffer {
+  // Set in the middle index when the middle slot was published after the
+  // consumer last took a slot.
+  static constexpr unsigned int nFresh = 4;
+
+  T mSlots[3];
+  alignas(nCacheLineSize) std::atomic<unsigned int> mMiddle;
+  // Only used by the producer.
+  alignas(nCacheLineSize) unsigned int mBack;
+  // Only used by the consumer.
+  alignas(nCacheLineSize) unsigned int mFront;
+
+  // Neither side may be using the buffer.
+  void Clear() {
+    mBack = 0;
+    mMiddle.store(1, std::memory_order_relaxed);
+    mFront = 2;
+  }
+
+  T &Back() {
+    return mSlots[mBack];
+  }
+
+  void Publish() {
+    unsigned int middle =
+        mMiddle.exchange(mBack | nFresh, std::memory_order_acq_rel);
+    mBack = middle & ~nFresh;
+  }
+
+  // Returns false when nothing was published since the last take, in which
+  // case the front slot is left as it was.
+  bool Take() {
+    if ((mMiddle.load(std::memory_order_relaxed) & nFresh) == 0) {
+      return false;
+    }
+    unsigned int middle = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+    mFront = middle & ~nFresh;
+    return true;
+  }
+
+  const T &Front() const {
+    return mSlots[mFront];
+  }
+};
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,116 @@
+#include "sim/ThreadPool.h"
+
+namespace Sim {
+
+// The queue index of the worker running on the current thread or -1 for
+// threads outside of a pool.
+thread_local int tWorkerIndex = -1;
+
+void ThreadPool::Init(int threadCount) {
+  if (threadCount <= 0) {
+    threadCount = (int)std::thread::hardware_concurrency();
+    threadCount = threadCount > 0 ? threadCount : 1;
+  }
+  mQueued = 0;
+  mUnfinished = 0;
+  mNextQueue = 0;
+  mStop = false;
+  for (int i = 0; i < threadCount; ++i) {
+    mQueues.emplace_back(new Queue);
+  }
+  for (int i = 0; i < threadCount; ++i) {
+    mThreads.emplace_back(&ThreadPool::Work, this, i);
+  }
+}
+
+void ThreadPool::Purge() {
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mStop = true;
+  }
+  mWakeWorkers.notify_all();
+  for (std::thread &thread : mThreads) {
+    thread.join();
+  }
+  mThreads.clear();
+  mQueues.clear();
+}
+
+void ThreadPool::Submit(Task task) {
+  int index = tWorkerIndex;
+  if (index < 0 || index >= (int)mQueues.size()) {
+    index = (int)(mNextQueue++ % mQueues.size());
+  }
+  ++mUnfinished;
+  {
+    Queue &queue = *mQueues[index];
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    queue.mTasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    ++mQueued;
+  }
+  mWakeWorkers.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mSleepMutex);
+  mWakeWaiters.wait(lock, [this]() { return mUnfinished == 0; });
+}
+
+int ThreadPool::ThreadCount() const {
+  return (int)mThreads.size();
+}
+
+void ThreadPool::Work(int index) {
+  tWorkerIndex = index;
+  while (true) {
+    Task task;
+    if (TakeTask(index, &task)) {
+      task();
+      if (--mUnfinished == 0) {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mWakeWaiters.notify_all();
+      }
+      continue;
+    }
+
+    // Sleep until there is something to take or the pool is purged.
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mWakeWorkers.wait(lock, [this]() { return mStop || mQueued > 0; });
+    if (mStop && mQueued == 0) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::TakeTask(int index, Task *task) {
+  // Look at our own queue first and take the most recently added task.
+  {
+    Queue &queue = *mQueues[index];
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    if (!queue.mTasks.empty()) {
+      *task = std::move(queue.mTasks.back());
+      queue.mTasks.pop_back();
+      --mQueued;
+      return true;
+    }
+  }
+
+  // Steal the oldest task from the first queue that has one.
+  int queueCount = (int)mQueues.size();
+  for (int i = 1; i < queueCount; ++i) {
+    Queue &queue = *mQueues[(index + i) % queueCount];
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    if (!queue.mTasks.empty()) {
+      *task = std::move(queue.mTasks.front());
+      queue.mTasks.pop_front();
+      --mQueued;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace Sim
@@ -0,0 +1,54 @@
+#ifndef sim_ThreadPool_h
+#define sim_ThreadPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sim {
+
+// A pool of worker threads where every worker owns a queue of tasks. A worker
+// takes tasks from the back of its own queue and, once that runs dry, steals
+// from the front of the other queues. Tasks submitted from outside of the pool
+// are spread over the queues and tasks submitted by a worker go to its own
+// queue.
+struct ThreadPool {
+  typedef std::function<void()> Task;
+
+  void Init(int threadCount = 0);
+  void Purge();
+  void Submit(Task task);
+  // Block until every submitted task has finished. This must not be called
+  // from a task.
+  void Wait();
+  int ThreadCount() const;
+
+  struct Queue {
+    std::mutex mMutex;
+    std::deque<Task> mTasks;
+  };
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::vector<std::thread> mThreads;
+
+  // The number of tasks waiting in queues and the number of tasks that have
+  // not finished yet.
+  std::atomic<int> mQueued;
+  std::atomic<int> mUnfinished;
+  std::atomic<unsigned int> mNextQueue;
+  bool mStop;
+  std::mutex mSleepMutex;
+  std::condition_variable mWakeWorkers;
+  std::condition_variable mWakeWaiters;
+
+  void Work(int index);
+  bool TakeTask(int index, Task *task);
+};
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,450 @@
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <new>
+#include <thread>
+
+#include "ai/Bot.h"
+#include "core/FixedStep.h"
+#include "sim/Batch.h"
+#include "sim/Bytes.h"
+#include "sim/Tuner.h"
+
+namespace Sim {
+
+// A bot that stops making progress is given this many ticks per tetrimino
+// before its game is stopped.
+constexpr long long nTicksPerPiece = 1000;
+// A worker gives up once the tuner has not advanced the heartbeat for this
+// long.
+constexpr double nOrphanSeconds = 30.0;
+
+void TunerConfig::SetDefaults() {
+  mPopulation = 32;
+  mEliteCount = 4;
+  mSeed = 1;
+  mGameCount = 8;
+  mMaxPieces = 500;
+  mBeamWidth = 1;
+  mDepth = 1;
+  mMutation = 0.2f;
+}
+
+bool TunerConfig::Validate(std::string *error) const {
+  if (mPopulation < 2 || mPopulation > TunerTable::nMaxSlots ||
+      mEliteCount < 0 || mEliteCount >= mPopulation) {
+    *error = "The population must be from 2 to " +
+             std::to_string(TunerTable::nMaxSlots) +
+             " and larger than the elites.";
+    return false;
+  }
+  if (mGameCount < 1 || mMaxPieces < 1) {
+    *error = "Every candidate must play at least one game of one piece.";
+    return false;
+  }
+  if (mBeamWidth < 1 || mDepth < 1) {
+    *error = "The beam width and depth of the bot must be at least 1.";
+    return false;
+  }
+  if (!(mMutation >= 0.0f) || isinf(mMutation)) {
+    *error = "The mutation must be finite and not negative.";
+    return false;
+  }
+  return true;
+}
+
+void ToWeights(const float *weights, Ai::Weights *to) {
+  to->mAggregateHeight = weights[0];
+  to->mLines = weights[1];
+  to->mHoles = weights[2];
+  to->mBumpiness = weights[3];
+  to->mRowTransitions = weights[4];
+}
+
+void FromWeights(const Ai::Weights &from, float *weights) {
+  weights[0] = from.mAggregateHeight;
+  weights[1] = from.mLines;
+  weights[2] = from.mHoles;
+  weights[3] = from.mBumpiness;
+  weights[4] = from.mRowTransitions;
+}
+
+float EvaluateWeights(
+    const TunerConfig &config, const float *weights, long long *pieces) {
+  Ai::BotConfig botConfig;
+  botConfig.SetDefaults();
+  botConfig.mBeamWidth = config.mBeamWidth;
+  botConfig.mDepth = config.mDepth;
+  ToWeights(weights, &botConfig.mWeights);
+  const float tickTime = 1.0f / (float)DEFAULT_TICK_RATE;
+  const long long maxTicks = nTicksPerPiece * config.mMaxPieces;
+
+  long long lines = 0;
+  for (int i = 0; i < config.mGameCount; ++i) {
+    unsigned int seed = GameSeed(config.mSeed, i);
+    Core::Game game;
+    game.Init(seed);
+    game.StartGame();
+    int gamePieces = 0;
+    WithDriver(DriverType::Bot, seed, nullptr, botConfig, [&](auto *driver) {
+      for (long long tick = 0; game.mRunning &&
+                               gamePieces < config.mMaxPieces &&
+                               tick < maxTicks;
+           ++tick) {
+        game.Step(driver->NextInputs(game), tickTime);
+        if (game.mEvents & Core::Event::Locked) {
+          ++gamePieces;
+        }
+      }
+    });
+    lines += game.mLines;
+    *pieces += gamePieces;
+  }
+  return config.mGameCount > 0 ? (float)lines / config.mGameCount : 0.0f;
+}
+
+void TunerState::Init(const TunerConfig &config) {
+  mConfig = config;
+  mGeneration = 0;
+  mRandom.Seed(((unsigned long long)config.mSeed << 32) ^ 0x7475ull);
+  mCandidates.resize(config.mPopulation);
+  for (size_t i = 0; i < mCandidates.size(); ++i) {
+    Candidate &candidate = mCandidates[i];
+    if (i == 0) {
+      Ai::Weights defaults;
+      defaults.SetDefaults();
+      FromWeights(defaults, candidate.mWeights);
+    } else {
+      for (float &weight : candidate.mWeights) {
+        weight = Gaussian();
+      }
+    }
+    Normalize(candidate.mWeights);
+    candidate.mFitness = -1.0f;
+  }
+}
+
+float TunerState::Gaussian() {
+  // Box-Muller with 24 bits per uniform value. The first is never zero.
+  float u = (float)((mRandom.Next() >> 8) + 1) / 16777216.0f;
+  float v = (float)(mRandom.Next() >> 8) / 16777216.0f;
+  return sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * v);
+}
+
+void TunerState::Normalize(float *weights) const {
+  float length = 0.0f;
+  for (int i = 0; i < nTunedWeightCount; ++i) {
+    length += weights[i] * weights[i];
+  }
+  length = sqrtf(length);
+  if (length > 0.0f) {
+    for (int i = 0; i < nTunedWeightCount; ++i) {
+      weights[i] /= length;
+    }
+  }
+}
+
+const Candidate &TunerState::Tournament() {
+  // The best of three candidates drawn at random.
+  const Candidate *best = nullptr;
+  for (int i = 0; i < 3; ++i) {
+    const Candidate &drawn =
+        mCandidates[mRandom.Below((unsigned int)mCandidates.size())];
+    if (best == nullptr || drawn.mFitness > best->mFitness) {
+      best = &drawn;
+    }
+  }
+  return *best;
+}
+
+bool TunerState::Evaluated() const {
+  for (const Candidate &candidate : mCandidates) {
+    if (candidate.mFitness < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TunerState::Breed() {
+  // A stable sort keeps the order of equally fit candidates, so a resumed run
+  // breeds the same children.
+  std::stable_sort(mCandidates.begin(), mCandidates.end(),
+                   [](const Candidate &a, const Candidate &b) {
+                     return a.mFitness > b.mFitness;
+                   });
+  std::vector<Candidate> children;
+  for (size_t i = (size_t)mConfig.mEliteCount; i < mCandidates.size(); ++i) {
+    const Candidate &a = Tournament();
+    const Candidate &b = Tournament();
+    Candidate child;
+    for (int j = 0; j < nTunedWeightCount; ++j) {
+      child.mWeights[j] = mRandom.Below(2) == 0 ? a.mWeights[j] : b.mWeights[j];
+      child.mWeights[j] += Gaussian() * mConfig.mMutation;
+    }
+    Normalize(child.mWeights);
+    child.mFitness = -1.0f;
+    children.push_back(child);
+  }
+  std::copy(children.begin(), children.end(),
+            mCandidates.begin() + mConfig.mEliteCount);
+}
+
+bool TunerState::Save(const char *filename, std::string *error) const {
+  const size_t candidateSize = (nTunedWeightCount + 1) * 4;
+  std::vector<unsigned char> bytes(nHeaderSize + 16 +
+                                   mCandidates.size() * candidateSize);
+  unsigned char *header = bytes.data();
+  memcpy(header, "TTTC", 4);
+  EncodeU16(header + 4, nVersion);
+  EncodeU16(header + 6, (unsigned short)nTunedWeightCount);
+  EncodeU32(header + 8, (unsigned int)mConfig.mPopulation);
+  EncodeU32(header + 12, (unsigned int)mConfig.mEliteCount);
+  EncodeU32(header + 16, mConfig.mSeed);
+  EncodeU32(header + 20, (unsigned int)mConfig.mGameCount);
+  EncodeU32(header + 24, (unsigned int)mConfig.mMaxPieces);
+  EncodeU16(header + 28, (unsigned short)mConfig.mBeamWidth);
+  EncodeU16(header + 30, (unsigned short)mConfig.mDepth);
+  EncodeF32(header + 32, mConfig.mMutation);
+  EncodeU32(header + 36, (unsigned int)mGeneration);
+  EncodeU64(header + 40, 0);
+  unsigned char *at = bytes.data() + nHeaderSize;
+  for (int i = 0; i < 4; ++i, at += 4) {
+    EncodeU32(at, mRandom.mState[i]);
+  }
+  for (const Candidate &candidate : mCandidates) {
+    for (int i = 0; i < nTunedWeightCount; ++i, at += 4) {
+      EncodeF32(at, candidate.mWeights[i]);
+    }
+    EncodeF32(at, candidate.mFitness);
+    at += 4;
+  }
+
+  // The checkpoint is written beside the old one and moved over it, so a run
+  // that is killed while saving still has a whole checkpoint.
+  std::string temporary = std::string(filename) + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if (file == nullptr) {
+    *error = "Failed to open " + temporary + " for writing.";
+    return false;
+  }
+  bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  written = fclose(file) == 0 && written;
+  std::error_code errorCode;
+  if (written) {
+    std::filesystem::rename(temporary, filename, errorCode);
+  }
+  if (!written || errorCode) {
+    *error = std::string("Failed to write ") + filename + ".";
+    return false;
+  }
+  return true;
+}
+
+bool TunerState::Load(const char *filename, std::string *error) {
+  MappedFile file;
+  if (!file.Open(filename, error)) {
+    return false;
+  }
+  const unsigned char *header = file.mData;
+  if (file.mSize < nHeaderSize || memcmp(header, "TTTC", 4) != 0) {
+    *error = "Not a tuner checkpoint.";
+    return false;
+  }
+  if (DecodeU16(header + 4) != nVersion ||
+      DecodeU16(header + 6) != nTunedWeightCount) {
+    *error = "Unsupported tuner checkpoint version.";
+    return false;
+  }
+  mConfig.mPopulation = (int)DecodeU32(header + 8);
+  mConfig.mEliteCount = (int)DecodeU32(header + 12);
+  mConfig.mSeed = DecodeU32(header + 16);
+  mConfig.mGameCount = (int)DecodeU32(header + 20);
+  mConfig.mMaxPieces = (int)DecodeU32(header + 24);
+  mConfig.mBeamWidth = DecodeU16(header + 28);
+  mConfig.mDepth = DecodeU16(header + 30);
+  mConfig.mMutation = DecodeF32(header + 32);
+  mGeneration = (int)DecodeU32(header + 36);
+  const size_t candidateSize = (nTunedWeightCount + 1) * 4;
+  if (!mConfig.Validate(error)) {
+    *error = "The tuner checkpoint is malformed. " + *error;
+    return false;
+  }
+  if (mGeneration < 0 ||
+      file.mSize !=
+          nHeaderSize + 16 + (size_t)mConfig.mPopulation * candidateSize) {
+    *error = "The tuner checkpoint is malformed.";
+    return false;
+  }
+  const unsigned char *at = file.mData + nHeaderSize;
+  for (int i = 0; i < 4; ++i, at += 4) {
+    mRandom.mState[i] = DecodeU32(at);
+  }
+  mCandidates.resize(mConfig.mPopulation);
+  for (Candidate &candidate : mCandidates) {
+    for (int i = 0; i < nTunedWeightCount; ++i, at += 4) {
+      candidate.mWeights[i] = DecodeF32(at);
+    }
+    candidate.mFitness = DecodeF32(at);
+    at += 4;
+  }
+  return true;
+}
+
+TunerPool::TunerPool() : mTable(nullptr) {}
+
+TunerPool::~TunerPool() {
+  Stop();
+}
+
+bool TunerPool::Start(const std::string &program, const std::string &tableFile,
+                      int workerCount, const TunerConfig &config,
+                      std::string *error) {
+  mTableFile = tableFile;
+  if (!mMapping.Create(tableFile.c_str(), sizeof(TunerTable), error)) {
+    return false;
+  }
+  // The mapping starts out as zeros, so every slot is already empty.
+  mTable = new (mMapping.mData) TunerTable;
+  mTable->mMagic = TunerTable::nMagic;
+  mTable->mConfig = config;
+  mTable->mCount.store(0, std::memory_order_relaxed);
+  mTable->mStop.store(0, std::memory_order_relaxed);
+  mTable->mHeartbeat.store(0, std::memory_order_relaxed);
+  for (TunerTable::Slot &slot : mTable->mSlots) {
+    slot.mState.store(TunerTable::Empty, std::memory_order_relaxed);
+  }
+  mWorkers.resize(workerCount);
+  for (ChildProcess &worker : mWorkers) {
+    if (!worker.Start({program, "--worker", tableFile}, error)) {
+      Stop();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TunerPool::Evaluate(std::vector<Candidate> *candidates,
+                         long long *pieces, std::string *error) {
+  std::vector<Candidate *> pending;
+  for (Candidate &candidate : *candidates) {
+    if (candidate.mFitness < 0.0f) {
+      pending.push_back(&candidate);
+    }
+  }
+  if (pending.size() > (size_t)TunerTable::nMaxSlots) {
+    *error = "The population does not fit in the tuner table.";
+    return false;
+  }
+  mTable->mCount.store((unsigned int)pending.size(), std::memory_order_release);
+  for (size_t i = 0; i < pending.size(); ++i) {
+    TunerTable::Slot &slot = mTable->mSlots[i];
+    memcpy(slot.mWeights, pending[i]->mWeights, sizeof(slot.mWeights));
+    slot.mState.store(TunerTable::Ready, std::memory_order_release);
+  }
+
+  for (;;) {
+    mTable->mHeartbeat.fetch_add(1, std::memory_order_relaxed);
+    size_t done = 0;
+    for (size_t i = 0; i < pending.size(); ++i) {
+      if (mTable->mSlots[i].mState.load(std::memory_order_acquire) ==
+          TunerTable::Done) {
+        ++done;
+      }
+    }
+    if (done == pending.size()) {
+      break;
+    }
+    for (ChildProcess &worker : mWorkers) {
+      if (!worker.Running()) {
+        *error = "A worker exited with code " +
+                 std::to_string(worker.mExitCode) + ".";
+        return false;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  for (size_t i = 0; i < pending.size(); ++i) {
+    TunerTable::Slot &slot = mTable->mSlots[i];
+    pending[i]->mFitness = slot.mFitness;
+    *pieces += slot.mPieces;
+    slot.mState.store(TunerTable::Empty, std::memory_order_relaxed);
+  }
+  mTable->mCount.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void TunerPool::Stop() {
+  if (mTable == nullptr) {
+    return;
+  }
+  mTable->mStop.store(1, std::memory_order_release);
+  for (ChildProcess &worker : mWorkers) {
+    worker.Wait();
+  }
+  mWorkers.clear();
+  mTable = nullptr;
+  mMapping.Close();
+  std::error_code errorCode;
+  std::filesystem::remove(mTableFile, errorCode);
+}
+
+bool RunTunerWorker(const char *tableFile, std::string *error) {
+  SharedMapping mapping;
+  if (!mapping.Open(tableFile, error)) {
+    return false;
+  }
+  TunerTable *table = (TunerTable *)mapping.mData;
+  if (mapping.mSize < sizeof(TunerTable) ||
+      table->mMagic != TunerTable::nMagic) {
+    *error = "Not a tuner table.";
+    return false;
+  }
+  const TunerConfig config = table->mConfig;
+  // The heartbeat is checked before every claim, so a worker that is busy
+  // when the tuner dies stops after the candidate it is playing.
+  unsigned int heartbeat = table->mHeartbeat.load(std::memory_order_relaxed);
+  auto lastBeat = std::chrono::steady_clock::now();
+  auto orphaned = [&]() {
+    auto now = std::chrono::steady_clock::now();
+    unsigned int beat = table->mHeartbeat.load(std::memory_order_relaxed);
+    if (beat != heartbeat) {
+      heartbeat = beat;
+      lastBeat = now;
+      return false;
+    }
+    return std::chrono::duration<double>(now - lastBeat).count() >
+           nOrphanSeconds;
+  };
+  while (table->mStop.load(std::memory_order_acquire) == 0) {
+    if (orphaned()) {
+      *error = "The tuner stopped responding.";
+      return false;
+    }
+    unsigned int count = table->mCount.load(std::memory_order_acquire);
+    count = std::min(count, (unsigned int)TunerTable::nMaxSlots);
+    bool claimed = false;
+    for (unsigned int i = 0; i < count && !orphaned(); ++i) {
+      TunerTable::Slot &slot = table->mSlots[i];
+      unsigned int expected = TunerTable::Ready;
+      if (!slot.mState.compare_exchange_strong(expected, TunerTable::Claimed,
+                                               std::memory_order_acquire)) {
+        continue;
+      }
+      long long pieces = 0;
+      slot.mFitness = EvaluateWeights(config, slot.mWeights, &pieces);
+      slot.mPieces = pieces;
+      slot.mState.store(TunerTable::Done, std::memory_order_release);
+      claimed = true;
+    }
+    if (!claimed) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return true;
+}
+
+} // namespace Sim
@@ -0,0 +1,161 @@
+#ifndef sim_Tuner_h
+#define sim_Tuner_h
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "core/Random.h"
+#include "sim/MappedFile.h"
+#include "sim/Process.h"
+
+// Tunes the weights the bot judges boards by with a genetic algorithm. Every
+// candidate plays the same games, so a candidate's fitness only depends on its
+// weights. The candidates of a generation are handed to worker processes
+// through a table in a shared mapping, which keeps every core busy without the
+// workers sharing a heap. The population is saved after every generation so
+// that a long run can be resumed.
+namespace Sim {
+
+// The weights of Ai::Weights in the order they are declared.
+constexpr int nTunedWeightCount = 5;
+
+struct TunerConfig {
+  int mPopulation;
+  // The best candidates of a generation are carried into the next unchanged.
+  int mEliteCount;
+  // Game i of every evaluation is played with GameSeed(mSeed, i).
+  unsigned int mSeed;
+  int mGameCount;
+  // Games are stopped once this many tetriminos have locked.
+  int mMaxPieces;
+  // The search of the bot that plays the games.
+  int mBeamWidth;
+  int mDepth;
+  // The standard deviation of the change that mutation makes to a weight.
+  // Weights are kept as a unit vector because only the order of the scores
+  // they give matters.
+  float mMutation;
+
+  void SetDefaults();
+  // Whether a run can be tuned with these settings. The error says which one
+  // is out of range.
+  bool Validate(std::string *error) const;
+};
+
+struct Candidate {
+  float mWeights[nTunedWeightCount];
+  // The mean number of lines cleared in the games, or -1 when the candidate
+  // has not been evaluated.
+  float mFitness;
+};
+
+// The fitness of a set of weights. The tetriminos that locked in the games are
+// added to pieces.
+float EvaluateWeights(
+    const TunerConfig &config, const float *weights, long long *pieces);
+
+// The population of the latest generation. A checkpoint is saved once a
+// generation is evaluated, before the next one is bred from it, so that the
+// best candidates are in the checkpoint even without elites.
+//
+// A checkpoint file starts with a 48 byte header. All values are little
+// endian.
+//   0  char[4] "TTTC"
+//   4  u16     version
+//   6  u16     weight count
+//   8  u32     population
+//   12 u32     elite count
+//   16 u32     seed
+//   20 u32     game count
+//   24 u32     max pieces
+//   28 u16     beam width
+//   30 u16     depth
+//   32 f32     mutation
+//   36 u32     generation
+//   40 u64     reserved
+// It is followed by the state of the random generator as four u32 values and
+// by every candidate as its weights and its fitness, all f32 values.
+struct TunerState {
+  static constexpr unsigned short nVersion = 1;
+  static constexpr size_t nHeaderSize = 48;
+
+  TunerConfig mConfig;
+  // The number of generations that were evaluated.
+  int mGeneration;
+  Core::Random mRandom;
+  std::vector<Candidate> mCandidates;
+
+  // The first generation is the default weights and random directions.
+  void Init(const TunerConfig &config);
+  // Whether every candidate has a fitness, so the next generation can be
+  // bred.
+  bool Evaluated() const;
+  // Sort the evaluated candidates from best to worst and replace all but the
+  // elites with children of the candidates.
+  void Breed();
+  bool Save(const char *filename, std::string *error) const;
+  bool Load(const char *filename, std::string *error);
+
+  float Gaussian();
+  void Normalize(float *weights) const;
+  const Candidate &Tournament();
+};
+
+// The table that the tuner and its workers share. The tuner writes the weights
+// of a slot before it marks the slot ready, and a worker that claims a slot
+// marks it done once its fitness is written, so every slot is only ever
+// written by one process at a time.
+struct TunerTable {
+  static constexpr int nMaxSlots = 1024;
+  static constexpr unsigned int nMagic = 0x43545454;
+  static_assert(std::atomic<unsigned int>::is_always_lock_free,
+                "Atomics in a shared mapping must be lock free.");
+
+  enum SlotState : unsigned int { Empty, Ready, Claimed, Done };
+
+  struct Slot {
+    std::atomic<unsigned int> mState;
+    float mWeights[nTunedWeightCount];
+    float mFitness;
+    long long mPieces;
+  };
+
+  unsigned int mMagic;
+  TunerConfig mConfig;
+  // The slots in use this generation. Workers only look at these.
+  std::atomic<unsigned int> mCount;
+  std::atomic<unsigned int> mStop;
+  // Advanced by the tuner while it waits on the workers. Workers give up on
+  // a tuner that stops advancing it, so they do not outlive a tuner that was
+  // killed.
+  std::atomic<unsigned int> mHeartbeat;
+  Slot mSlots[nMaxSlots];
+};
+
+// Starts worker processes and hands them the candidates of every generation.
+struct TunerPool {
+  std::string mTableFile;
+  SharedMapping mMapping;
+  TunerTable *mTable;
+  std::vector<ChildProcess> mWorkers;
+
+  TunerPool();
+  ~TunerPool();
+  // Every worker is the given program run with --worker and the table file.
+  bool Start(const std::string &program, const std::string &tableFile,
+             int workerCount, const TunerConfig &config, std::string *error);
+  // Evaluate the candidates that have no fitness yet. Fails when a worker
+  // exits.
+  bool Evaluate(std::vector<Candidate> *candidates, long long *pieces,
+                std::string *error);
+  // Stop the workers and remove the table file.
+  void Stop();
+};
+
+// The loop of a worker process. Returns when the tuner stops.
+bool RunTunerWorker(const char *tableFile, std::string *error);
+
+} // namespace Sim
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+
+#include <filesystem>
+
+#include "core/Allocations.h"
+#include "sim/Drivers.h"
+#include "sim/LiveGame.h"
+#include "tests/Check.h"
+
+// The game is stepped and presented on one thread with random keys, like the
+// simulation thread and presentation of the game played from the keyboard.
+// Starting and ending a game opens and closes a replay, so only the ticks in
+// the middle of a game are checked. The replays are removed afterwards.
+constexpr int nTickCount = 20000;
+constexpr int nWarmUpGames = 1;
+
+Sim::LiveGame nLiveGame;
+
+int main() {
+  if (!Core::nCountAllocations) {
+    printf("allocations are not counted, skipped\n");
+    return Test::nSkipped;
+  }
+  Ai::BotConfig botConfig;
+  botConfig.SetDefaults();
+  nLiveGame.Init(botConfig, nullptr);
+  nLiveGame.mReplayDirectory = "allocations_replays";
+  View::TileBatch tiles;
+  nLiveGame.mFrames.Take();
+  tiles = nLiveGame.mFrames.Front().mTiles;
+  Sim::RandomDriver driver;
+  driver.Init(14);
+
+  Core::Inputs held = 0;
+  int gamesStarted = 0;
+  long long checkedTicks = 0;
+  long long allocatingTicks = 0;
+  unsigned long long warmUpQuietAllocations = 0;
+  for (int tick = 0; tick < nTickCount; ++tick) {
+    double start = tick * (double)nLiveGame.mTickTime;
+    bool running = nLiveGame.mGame.mRunning;
+    unsigned long long before = Core::AllocationCount();
+
+    // A game is started by pressing down, so it is released every other tick.
+    Core::Inputs inputs = driver.NextInputs();
+    if (!running) {
+      inputs = tick % 2 == 0 ? Core::Key::Down : 0;
+    }
+    if (inputs != held) {
+      nLiveGame.SetKeys(start, inputs);
+      held = inputs;
+    }
+    nLiveGame.RunTick(start + nLiveGame.mTickTime);
+    if (nLiveGame.mFrames.Take()) {
+      tiles.CopyFrom(nLiveGame.mFrames.Front().mTiles);
+      tiles.ClearChanged();
+    }
+    bool quiet = running && nLiveGame.mGame.mRunning;
+    Sim::LiveEvent event;
+    while (nLiveGame.mEvents.Pop(&event)) {
+      if (event.mType == Sim::LiveEventType::Started) {
+        ++gamesStarted;
+      }
+      quiet = quiet && event.mType != Sim::LiveEventType::Started &&
+              event.mType != Sim::LiveEventType::Ended;
+    }
+
+    // The frame's own count of quiet allocations must agree, so it must stay
+    // where the warm up left it.
+    if (gamesStarted <= nWarmUpGames) {
+      warmUpQuietAllocations = nLiveGame.mFrames.Front().mQuietAllocations;
+    }
+    if (quiet && gamesStarted > nWarmUpGames) {
+      ++checkedTicks;
+      unsigned long long allocations = Core::AllocationCount() - before;
+      if (allocations > 0 && allocatingTicks++ < 10) {
+        fprintf(stderr, "tick %d of game %d allocated %llu times\n", tick,
+                gamesStarted, allocations);
+      }
+    }
+  }
+  nLiveGame.Purge();
+  std::error_code errorCode;
+  std::filesystem::remove_all(nLiveGame.mReplayDirectory, errorCode);
+
+  printf("%d games, %lld ticks checked, %lld allocated\n", gamesStarted,
+         checkedTicks, allocatingTicks);
+  CHECK(gamesStarted > nWarmUpGames + 1);
+  CHECK(checkedTicks > 0);
+  CHECK(allocatingTicks == 0);
+  CHECK(nLiveGame.mFrames.Front().mQuietAllocations == warmUpQuietAllocations);
+  CHECK(nLiveGame.mFrames.Front().mDroppedEvents == 0);
+  return Test::Result();
+}
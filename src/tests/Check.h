@@ -0,0 +1,40 @@
+#ifndef tests_Check_h
+#define tests_Check_h
+
+#include <stdio.h>
+
+// The tests are plain programs that exit with a failure when a check fails.
+// Every failed check is printed, so one run shows all of them.
+namespace Test {
+
+// The exit code that CTest reports as a skipped test.
+constexpr int nSkipped = 77;
+
+inline int &FailureCount() {
+  static int count = 0;
+  return count;
+}
+
+inline bool Check(bool passed, const char *expression, const char *file,
+                  int line) {
+  if (!passed) {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++FailureCount();
+  }
+  return passed;
+}
+
+inline int Result() {
+  if (FailureCount() > 0) {
+    fprintf(stderr, "%d checks failed\n", FailureCount());
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace Test
+
+#define CHECK(expression) \
+  Test::Check((expression), #expression, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+
+#include <vector>
+
+#include "ai/FeatureKernel.h"
+#include "core/Random.h"
+#include "tests/Check.h"
+
+// The features of a board counted cell by cell from their definitions in
+// ai/Evaluate.h.
+Ai::Features ReferenceFeatures(const Core::Board &board, int lines) {
+  Ai::Features features = {};
+  features.mLines = lines;
+  int heights[Core::Board::nWidth];
+  for (int column = 0; column < Core::Board::nWidth; ++column) {
+    heights[column] = 0;
+    for (int row = 0; row < Core::Board::nHeight; ++row) {
+      if (board.Locked(row, column)) {
+        if (heights[column] == 0) {
+          heights[column] = Core::Board::nHeight - row;
+        }
+      } else if (heights[column] != 0) {
+        ++features.mHoles;
+      }
+    }
+    features.mAggregateHeight += heights[column];
+  }
+  for (int column = 0; column + 1 < Core::Board::nWidth; ++column) {
+    features.mBumpiness += abs(heights[column] - heights[column + 1]);
+  }
+  for (int row = 0; row < Core::Board::nHeight; ++row) {
+    bool previous = true;
+    for (int column = 0; column <= Core::Board::nWidth; ++column) {
+      bool filled =
+          column == Core::Board::nWidth || board.Locked(row, column);
+      features.mRowTransitions += filled != previous ? 1 : 0;
+      previous = filled;
+    }
+  }
+  return features;
+}
+
+bool Equal(const Ai::Features &a, const Ai::Features &b) {
+  return a.mAggregateHeight == b.mAggregateHeight && a.mLines == b.mLines &&
+         a.mHoles == b.mHoles && a.mBumpiness == b.mBumpiness &&
+         a.mRowTransitions == b.mRowTransitions;
+}
+
+// A board whose rows below a random height are random, with some rows left
+// empty or full so that holes, overhangs and clears all show up.
+void RandomBoard(Core::Random *random, Core::Board *board) {
+  board->Clear();
+  int top = (int)random->Below(Core::Board::nHeight + 1);
+  for (int row = top; row < Core::Board::nHeight; ++row) {
+    unsigned int kind = random->Below(8);
+    unsigned int cells = random->Next();
+    if (kind == 0) {
+      cells = 0;
+    } else if (kind == 1) {
+      cells = ~0u;
+    }
+    cells &= (1u << Core::Board::nWidth) - 1;
+    board->mRows[row + Core::Board::nPadRows] |=
+        (Core::RowMask)(cells << Core::Board::nWallBits);
+  }
+  board->UpdateSkyline();
+}
+
+int main() {
+  // The count is not a multiple of the group size, so the last group has
+  // unused lanes.
+  const int boardCount = 1000;
+  Core::Random random;
+  random.Seed(10);
+  std::vector<Core::Board> boards(boardCount);
+  std::vector<Ai::Features> expected(boardCount);
+  Ai::BoardBatch batch;
+  batch.Clear();
+  for (int i = 0; i < boardCount; ++i) {
+    RandomBoard(&random, &boards[i]);
+    int lines = (int)random.Below(5);
+    expected[i] = ReferenceFeatures(boards[i], lines);
+    CHECK(batch.Add(boards[i], lines) == i);
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < boardCount; ++i) {
+    Ai::Features features = Ai::ComputeFeatures(boards[i], batch.mLines[i]);
+    mismatches += Equal(features, expected[i]) ? 0 : 1;
+  }
+  CHECK(mismatches == 0);
+
+  const Ai::FeatureKernel kernels[] = {Ai::FeatureKernel::Scalar,
+                                       Ai::FeatureKernel::Sse2,
+                                       Ai::FeatureKernel::Avx2};
+  for (Ai::FeatureKernel kernel : kernels) {
+    if (!Ai::FeatureKernelSupported(kernel)) {
+      printf("%s: not supported, skipped\n", Ai::FeatureKernelName(kernel));
+      continue;
+    }
+    std::vector<Ai::Features> features(boardCount);
+    Ai::ComputeFeatures(batch, features.data(), kernel);
+    mismatches = 0;
+    for (int i = 0; i < boardCount; ++i) {
+      mismatches += Equal(features[i], expected[i]) ? 0 : 1;
+    }
+    printf("%s: %d of %d boards differ\n", Ai::FeatureKernelName(kernel),
+           mismatches, boardCount);
+    CHECK(mismatches == 0);
+  }
+  return Test::Result();
+}
@@ -0,0 +1,158 @@
+#include <deque>
+#include <vector>
+
+#include "ai/Finesse.h"
+#include "core/Random.h"
+#include "tests/Check.h"
+
+// A board with every cell below a random skyline filled. Most columns stay
+// near a common height and some stand far above or below it, so wells,
+// towers and boards too high to spawn on all show up.
+void RandomSurface(Core::Random *random, Core::Board *board) {
+  board->Clear();
+  int base = 4 + (int)random->Below(18);
+  for (int column = 0; column < Core::Board::nWidth; ++column) {
+    int top = base + (int)random->Below(7) - 3;
+    if (random->Below(5) == 0) {
+      top = base - 6 + (int)random->Below(12);
+    }
+    top = top < 0 ? 0 : top > Core::Board::nHeight ? Core::Board::nHeight : top;
+    for (int row = top; row < Core::Board::nHeight; ++row) {
+      board->mRows[row + Core::Board::nPadRows] |=
+          (Core::RowMask)1 << (column + Core::Board::nWallBits);
+    }
+  }
+  board->UpdateSkyline();
+}
+
+struct ReferencePlacement {
+  Ai::Footprint mFootprint;
+  int mPresses;
+};
+
+// The fewest presses to every placement, found by a search over the board
+// itself with Core::KickRotation. Falling costs nothing and every shift, held
+// shift and rotation costs one press, so states are expanded in order of
+// presses with a double ended queue.
+std::vector<ReferencePlacement> ReferenceSearch(const Core::Board &board,
+                                                Core::Tetrimino tetrimino) {
+  std::vector<ReferencePlacement> placements;
+  auto fits = [&](int x, int y, int rotation) {
+    return x >= Ai::MoveSearch::nMinX && x < Core::Board::nWidth &&
+           y >= Ai::MoveSearch::nMinY && y < Core::Board::nHeight &&
+           board.Fits(Core::GetShape(tetrimino, rotation), x, y);
+  };
+  Ai::PieceState start = Ai::SpawnState();
+  if (!fits(start.mX, start.mY, start.mRotation)) {
+    return placements;
+  }
+  std::vector<int> presses(Ai::MoveSearch::nStateCount, -1);
+  std::deque<Ai::PieceState> open;
+  presses[Ai::MoveSearch::Index(start)] = 0;
+  open.push_back(start);
+  while (!open.empty()) {
+    Ai::PieceState from = open.front();
+    open.pop_front();
+    int cost = presses[Ai::MoveSearch::Index(from)];
+    auto reach = [&](int x, int y, int rotation, int weight) {
+      Ai::PieceState to = {(signed char)x, (signed char)y,
+                           (signed char)rotation};
+      int &known = presses[Ai::MoveSearch::Index(to)];
+      if (known >= 0 && known <= cost + weight) {
+        return;
+      }
+      known = cost + weight;
+      if (weight == 0) {
+        open.push_front(to);
+      } else {
+        open.push_back(to);
+      }
+    };
+    int x = from.mX;
+    int y = from.mY;
+    int rotation = from.mRotation;
+    if (fits(x, y + 1, rotation)) {
+      reach(x, y + 1, rotation, 0);
+    }
+    for (int step : {-1, 1}) {
+      if (fits(x + step, y, rotation)) {
+        reach(x + step, y, rotation, 1);
+      }
+      int held = x;
+      while (fits(held + step, y, rotation)) {
+        held += step;
+      }
+      if (held != x) {
+        reach(held, y, rotation, 1);
+      }
+    }
+    for (int turn : {1, 3}) {
+      int rotated = (rotation + turn) % 4;
+      int kickedX = x;
+      int kickedY = y;
+      if (Core::KickRotation(board, Core::GetShape(tetrimino, rotated),
+                             &kickedX, &kickedY) &&
+          fits(kickedX, kickedY, rotated)) {
+        reach(kickedX, kickedY, rotated, 1);
+      }
+    }
+  }
+
+  for (int i = 0; i < Ai::MoveSearch::nStateCount; ++i) {
+    Ai::PieceState state = Ai::MoveSearch::State(i);
+    if (presses[i] < 0 || fits(state.mX, state.mY + 1, state.mRotation)) {
+      continue;
+    }
+    Ai::Footprint footprint = Ai::GetFootprint(tetrimino, state);
+    bool found = false;
+    for (ReferencePlacement &placement : placements) {
+      if (placement.mFootprint == footprint) {
+        if (presses[i] < placement.mPresses) {
+          placement.mPresses = presses[i];
+        }
+        found = true;
+      }
+    }
+    if (!found) {
+      placements.push_back({footprint, presses[i]});
+    }
+  }
+  return placements;
+}
+
+int main() {
+  static Ai::FinesseSearch search;
+  static Ai::FinesseResult result;
+  Core::Random random;
+  random.Seed(21);
+  int checked = 0;
+  int mismatches = 0;
+  for (int trial = 0; trial < 2000; ++trial) {
+    Core::Board board;
+    RandomSurface(&random, &board);
+    for (int i = 0; i < 7; ++i) {
+      Core::Tetrimino tetrimino = (Core::Tetrimino)i;
+      search.Run(board.mSkyline, tetrimino, &result);
+      int expectedCount = 0;
+      for (const ReferencePlacement &expected :
+           ReferenceSearch(board, tetrimino)) {
+        if (expected.mPresses > Ai::FinessePlacement::nMaxKeys) {
+          continue;
+        }
+        ++expectedCount;
+        ++checked;
+        const Ai::FinessePlacement *placement =
+            result.Find(expected.mFootprint);
+        if (placement == nullptr ||
+            placement->mKeyCount != expected.mPresses) {
+          ++mismatches;
+        }
+      }
+      mismatches += result.mCount == expectedCount ? 0 : 1;
+    }
+  }
+  printf("%d placements checked, %d mismatches\n", checked, mismatches);
+  CHECK(checked > 0);
+  CHECK(mismatches == 0);
+  return Test::Result();
+}
@@ -0,0 +1,213 @@
+#include <limits.h>
+#include <string.h>
+
+#include <vector>
+
+#include "sim/Drivers.h"
+#include "sim/Net.h"
+#include "sim/Rollback.h"
+#include "tests/Check.h"
+
+constexpr int nFrameCount = 3000;
+
+// One of the two machines, as in tools/Rollback.cc.
+struct Peer {
+  Sim::RollbackSession mSession;
+  Sim::RandomDriver mDriver;
+  Core::Inputs mPending;
+  bool mHasPending;
+  Sim::LinkSimulator mLink;
+  // The keys every frame of this player's game is stepped with.
+  std::vector<Core::Inputs> mKeys;
+};
+
+Peer nPeers[2];
+Sim::RollbackSession nSession;
+
+// Two sessions play over links that delay, reorder and lose packets, and every
+// packet that arrives is read twice. Both must end with the games that the
+// keys of both players give when they are stepped without any rollback.
+void CheckSessions(const Sim::RollbackConfig &config, double latency,
+                   double jitter, float loss) {
+  for (int p = 0; p < 2; ++p) {
+    Peer &peer = nPeers[p];
+    Sim::RollbackConfig peerConfig = config;
+    peerConfig.mLocalPlayer = p;
+    peer.mSession.Init(peerConfig);
+    peer.mDriver.Init((unsigned int)config.mSeed * 2 + p);
+    peer.mHasPending = false;
+    peer.mLink.Init(latency, jitter, loss, config.mSeed * 2 + p);
+    peer.mKeys.assign(nFrameCount + config.mInputDelay, 0);
+  }
+
+  unsigned char packet[Sim::nMaxDatagramSize];
+  bool settled = false;
+  for (long long tick = 0; tick < nFrameCount * 100LL && !settled; ++tick) {
+    double now = (double)tick * config.mTickTime;
+    for (int p = 0; p < 2; ++p) {
+      size_t size;
+      while ((size = nPeers[p].mLink.Receive(packet, now)) != 0) {
+        CHECK(nPeers[1 - p].mSession.ReadPacket(packet, size));
+        CHECK(nPeers[1 - p].mSession.ReadPacket(packet, size));
+      }
+    }
+    settled = true;
+    for (Peer &peer : nPeers) {
+      Sim::RollbackSession &session = peer.mSession;
+      if (session.mFrame < nFrameCount) {
+        if (!peer.mHasPending) {
+          peer.mPending = peer.mDriver.NextInputs();
+          peer.mHasPending = true;
+        }
+        int frame = session.mFrame;
+        if (session.Advance(peer.mPending)) {
+          peer.mKeys[frame + config.mInputDelay] = peer.mPending;
+          peer.mHasPending = false;
+        }
+      } else {
+        session.Synchronize();
+      }
+      settled = settled && session.mFrame >= nFrameCount &&
+                session.mRemoteReceived >= nFrameCount;
+    }
+    for (Peer &peer : nPeers) {
+      size_t size = peer.mSession.WritePacket(packet);
+      peer.mLink.Send(packet, size, now);
+    }
+  }
+  CHECK(settled);
+
+  static Sim::RollbackSession reference;
+  Sim::RollbackConfig referenceConfig = config;
+  referenceConfig.mLocalPlayer = 0;
+  reference.Init(referenceConfig);
+  for (int frame = 0; frame < nFrameCount; ++frame) {
+    for (int p = 0; p < 2; ++p) {
+      reference.mGames[p].Step(nPeers[p].mKeys[frame], config.mTickTime);
+    }
+  }
+  unsigned long long checksums[2];
+  for (int p = 0; p < 2; ++p) {
+    nPeers[p].mSession.Synchronize();
+    checksums[p] = nPeers[p].mSession.Checksum();
+  }
+  CHECK(checksums[0] == checksums[1]);
+  CHECK(checksums[0] == reference.Checksum());
+
+  const Sim::RollbackStats &stats = nPeers[0].mSession.mStats;
+  printf("%lld frames, %lld rollbacks, deepest %d, %lld packets read\n",
+         stats.mFrames, stats.mRollbacks, stats.mDeepestRollback,
+         stats.mPacketsRead);
+  CHECK(stats.mRollbacks > 0);
+  CHECK(stats.mPacketsRejected == 0);
+}
+
+// A packet in the format of RollbackSession::WritePacket that holds the same
+// keys for every frame.
+size_t MakePacket(unsigned char *packet, int acknowledged, int first,
+                  int count, Core::Inputs keys) {
+  packet[0] = 'T';
+  packet[1] = 'R';
+  packet[2] = 1;
+  packet[3] = (unsigned char)count;
+  for (int i = 0; i < 4; ++i) {
+    packet[4 + i] = (unsigned char)((unsigned int)acknowledged >> (8 * i));
+    packet[8 + i] = (unsigned char)((unsigned int)first >> (8 * i));
+  }
+  memset(packet + 12, keys, (size_t)count);
+  return 12 + (size_t)count;
+}
+
+// A packet that is rejected must leave the session as it was.
+void CheckRejected(const unsigned char *packet, size_t size) {
+  int received = nSession.mRemoteReceived;
+  int acknowledged = nSession.mLocalAcknowledged;
+  long long rejected = nSession.mStats.mPacketsRejected;
+  CHECK(!nSession.ReadPacket(packet, size));
+  CHECK(nSession.mRemoteReceived == received);
+  CHECK(nSession.mLocalAcknowledged == acknowledged);
+  CHECK(nSession.mStats.mPacketsRejected == rejected + 1);
+}
+
+void CheckPackets() {
+  Sim::RollbackConfig config;
+  config.SetDefaults();
+  nSession.Init(config);
+  for (int frame = 0; frame < 4; ++frame) {
+    CHECK(nSession.Advance(0));
+  }
+
+  // Malformed packets.
+  unsigned char packet[Sim::RollbackSession::nMaxPacketSize + 1];
+  size_t size = MakePacket(packet, 0, 0, 4, Core::Key::Left);
+  CheckRejected(packet, 11);
+  CheckRejected(packet, size - 1);
+  CheckRejected(packet, size + 1);
+  packet[0] = 'X';
+  CheckRejected(packet, size);
+  size = MakePacket(packet, 0, 0, 4, Core::Key::Left);
+  packet[2] = 2;
+  CheckRejected(packet, size);
+  size = MakePacket(packet, 0, 0, Sim::RollbackSession::nMaxPacketInputs + 1,
+                    Core::Key::Left);
+  CheckRejected(packet, size);
+
+  // Frames that are negative, near INT_MAX, past the window or acknowledge
+  // local keys that were never sent.
+  CheckRejected(packet, MakePacket(packet, -1, 0, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 0, -1, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 0, INT_MIN, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 0, INT_MAX, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 0, INT_MAX - 2, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, INT_MAX, 0, 4, Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 0,
+                                   Sim::RollbackSession::nWindow + 1, 4,
+                                   Core::Key::Left));
+  CheckRejected(packet, MakePacket(packet, 64, 0, 4, Core::Key::Left));
+  CHECK(nSession.mStats.mPacketsRead == 0);
+
+  // Keys that differ from the prediction roll back to their first frame.
+  size = MakePacket(packet, 2, 0, 3, Core::Key::Left);
+  CHECK(nSession.ReadPacket(packet, size));
+  CHECK(nSession.mRemoteReceived == 3);
+  CHECK(nSession.mLocalAcknowledged == 2);
+  CHECK(nSession.mFirstMismatch == 0);
+  nSession.Synchronize();
+  CHECK(nSession.mStats.mRollbacks == 1);
+  CHECK(nSession.mStats.mResimulatedFrames == 4);
+
+  // A duplicate, or a late packet with other keys for frames that were
+  // already received, changes nothing.
+  CHECK(nSession.ReadPacket(packet, size));
+  size = MakePacket(packet, 1, 0, 3, Core::Key::Right);
+  CHECK(nSession.ReadPacket(packet, size));
+  CHECK(nSession.mRemoteReceived == 3);
+  CHECK(nSession.mLocalAcknowledged == 2);
+  CHECK(nSession.mFirstMismatch == INT_MAX);
+  for (int frame = 0; frame < 3; ++frame) {
+    CHECK(nSession.RemoteInputs(frame) == Core::Key::Left);
+  }
+
+  // Keys that arrive ahead of a gap are kept until the gap is filled.
+  size = MakePacket(packet, 2, 5, 2, Core::Key::Right);
+  CHECK(nSession.ReadPacket(packet, size));
+  CHECK(nSession.mRemoteReceived == 3);
+  size = MakePacket(packet, 2, 3, 2, Core::Key::Left);
+  CHECK(nSession.ReadPacket(packet, size));
+  CHECK(nSession.mRemoteReceived == 7);
+  CHECK(nSession.RemoteInputs(6) == Core::Key::Right);
+  CHECK(nSession.mStats.mPacketsRead == 5);
+}
+
+int main() {
+  Sim::RollbackConfig config;
+  config.SetDefaults();
+  config.mSeed = 3;
+  CheckSessions(config, 0.05, 0.03, 0.1f);
+  config.mSeed = 4;
+  config.mInputDelay = 0;
+  config.mMaxRollback = 16;
+  CheckSessions(config, 0.1, 0.08, 0.3f);
+  CheckPackets();
+  return Test::Result();
+}
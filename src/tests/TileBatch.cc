@@ -0,0 +1,141 @@
+#include <string.h>
+
+#include "tests/Check.h"
+#include "view/TileBatch.h"
+
+// The palette entry of every tile, in the order of the tiles. 7 is an empty
+// cell.
+// clang-format off
+const unsigned char nBuiltPalettes[View::nTileCount] = {
+  // The visible grid. An I stands in the last column and an O sits in the
+  // bottom left corner.
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 0,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 0,
+  7, 3, 3, 7, 7, 7, 7, 7, 7, 0,
+  7, 3, 3, 7, 7, 7, 7, 7, 7, 0,
+  // The queue: T, S and L.
+  7, 7, 7, 7,  7, 5, 7, 7,  5, 5, 5, 7,  7, 7, 7, 7,
+  7, 7, 7, 7,  7, 4, 4, 7,  4, 4, 7, 7,  7, 7, 7, 7,
+  7, 1, 7, 7,  7, 1, 7, 7,  7, 1, 1, 7,  7, 7, 7, 7,
+  // The ghost and the active J.
+  2, 2, 2, 2,  2, 2, 2, 2};
+
+// After a Z locked, the queue advanced to S, L and O and a T became active.
+// The cell that changed without being marked dirty keeps its old entry.
+const unsigned char nUpdatedPalettes[View::nTileCount] = {
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 0,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 0,
+  7, 3, 3, 7, 6, 6, 7, 7, 7, 0,
+  7, 3, 3, 7, 7, 6, 6, 7, 7, 0,
+  7, 7, 7, 7,  7, 4, 4, 7,  4, 4, 7, 7,  7, 7, 7, 7,
+  7, 1, 7, 7,  7, 1, 7, 7,  7, 1, 1, 7,  7, 7, 7, 7,
+  7, 7, 7, 7,  7, 3, 3, 7,  7, 3, 3, 7,  7, 7, 7, 7,
+  5, 5, 5, 5,  5, 5, 5, 5};
+// clang-format on
+
+// Every instance is its tile index followed by its palette entry.
+bool BytesMatch(const View::TileBatch &batch, const unsigned char *palettes) {
+  unsigned char expected[View::nTileCount * 2];
+  for (int i = 0; i < View::nTileCount; ++i) {
+    expected[i * 2] = (unsigned char)i;
+    expected[i * 2 + 1] = palettes[i];
+  }
+  static_assert(sizeof(batch.mInstances) == sizeof(expected),
+                "The batch must be packed.");
+  bool match = memcmp(batch.mInstances, expected, sizeof(expected)) == 0;
+  for (int i = 0; !match && i < View::nTileCount; ++i) {
+    if (batch.mInstances[i].mPalette != palettes[i]) {
+      fprintf(stderr, "tile %d has palette %d, expected %d\n", i,
+              batch.mInstances[i].mPalette, palettes[i]);
+    }
+  }
+  return match;
+}
+
+void SetQueue(Core::Game *game, int head, const Core::Tetrimino *pieces) {
+  game->mQueue.mHead = head;
+  game->mQueue.mCount = View::nQueueSlotCount;
+  for (int i = 0; i < View::nQueueSlotCount; ++i) {
+    game->mQueue.mPieces[head + i] = pieces[i];
+  }
+}
+
+int main() {
+  using Core::Tetrimino;
+  const int bottom = Core::Board::nHeight - 1;
+
+  Core::Game game;
+  game.Init(1);
+  game.mBoard.Lock(Core::GetShape(Tetrimino::O, 0), 0, bottom - 2,
+                   Tetrimino::O);
+  game.mBoard.Lock(Core::GetShape(Tetrimino::I, 0), 8, bottom - 3,
+                   Tetrimino::I);
+  const Tetrimino queue[] = {Tetrimino::T, Tetrimino::S, Tetrimino::L};
+  SetQueue(&game, 0, queue);
+  game.mActiveTetrimino = Tetrimino::J;
+
+  View::TileBatch batch;
+  batch.Build(game);
+  CHECK(BytesMatch(batch, nBuiltPalettes));
+  CHECK(batch.mChangedBegin == 0 && batch.mChangedEnd == View::nTileCount);
+
+  game.mDirty.Clear();
+  const Core::Shape &z = Core::GetShape(Tetrimino::Z, 0);
+  game.mBoard.Lock(z, 3, bottom - 2, Tetrimino::Z);
+  game.mDirty.MarkShape(z, 3, bottom - 2);
+  game.mBoard.Lock(Core::GetShape(Tetrimino::O, 0), 4, bottom - 18,
+                   Tetrimino::O);
+  const Tetrimino advanced[] = {Tetrimino::S, Tetrimino::L, Tetrimino::O};
+  SetQueue(&game, 1, advanced);
+  for (int i = 0; i < View::nQueueSlotCount; ++i) {
+    game.mDirty.MarkQueueSlot(i);
+  }
+  game.mActiveTetrimino = Tetrimino::T;
+
+  batch.ClearChanged();
+  batch.Update(game, game.mDirty);
+  CHECK(BytesMatch(batch, nUpdatedPalettes));
+  CHECK(batch.mChangedBegin == 18 * Core::Board::nWidth + 4);
+  CHECK(batch.mChangedEnd == View::nTileCount);
+
+  // An update with nothing dirty and the same active tetrimino changes
+  // nothing.
+  game.mDirty.Clear();
+  batch.ClearChanged();
+  batch.Update(game, game.mDirty);
+  CHECK(BytesMatch(batch, nUpdatedPalettes));
+  CHECK(batch.mChangedBegin >= batch.mChangedEnd);
+  return Test::Result();
+}
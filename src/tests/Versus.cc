@@ -0,0 +1,190 @@
+#include <string.h>
+
+#include "core/Versus.h"
+#include "sim/Drivers.h"
+#include "tests/Check.h"
+
+constexpr int nGameCount = 200;
+constexpr int nMaxTicks = 20000;
+
+Core::Versus nVersus;
+
+// A match of one player gets no garbage, so it must play exactly like
+// Core::Game with the same seed and keys. Half of the games are played at 20G
+// and some steps are long, so every rule step is covered.
+void CheckSinglePlayer() {
+  int differing = 0;
+  long long locks = 0;
+  for (int g = 0; g < nGameCount; ++g) {
+    Core::Game game;
+    game.Init(g + 1);
+    game.StartGame();
+    nVersus.Init(1, g + 1);
+    nVersus.Start();
+    if (g % 2 == 1) {
+      game.mDropRate = 1.0f / 0.0f;
+      nVersus.mDropRate[0] = game.mDropRate;
+    }
+    Sim::RandomDriver driver;
+    driver.Init(g * 7 + 3);
+    for (int tick = 0; tick < nMaxTicks; ++tick) {
+      Core::Inputs inputs = driver.NextInputs();
+      float dt = tick % 5 == 0 ? 0.05f : 1.0f / 60.0f;
+      game.Step(inputs, dt);
+      nVersus.Step(&inputs, dt);
+      locks += game.mEvents & Core::Event::Locked ? 1 : 0;
+
+      // A game goes on with the step it ended in while a knocked out player
+      // stops, so only the end itself is compared.
+      if (!game.mRunning || !nVersus.mRunning) {
+        differing += game.mRunning != nVersus.mRunning ? 1 : 0;
+        break;
+      }
+      bool same = game.mActiveTetrimino == nVersus.mActive[0] &&
+                  game.mShapeRotation == nVersus.mRotation[0] &&
+                  game.mActiveX == nVersus.mX[0] &&
+                  game.mActiveY == nVersus.mY[0] &&
+                  game.mLines == nVersus.mLines[0] &&
+                  game.mEvents == nVersus.mEvents[0];
+      for (int i = 0; i < Core::Board::nHeight; ++i) {
+        same = same && game.mBoard.Row(i) ==
+                           nVersus.mRows[0][i + Core::Board::nPadRows];
+      }
+      if (!same) {
+        fprintf(stderr, "game %d differs at tick %d\n", g, tick);
+        ++differing;
+        break;
+      }
+    }
+  }
+  printf("%d of %d games differ, %lld locks\n", differing, nGameCount, locks);
+  CHECK(differing == 0);
+  CHECK(locks > 0);
+}
+
+// Fill the bottom rows of a board except for one column.
+void FillRows(int player, int count, int hole) {
+  Core::RowMask row = Core::Board::nFullRow &
+                      ~((Core::RowMask)1 << (hole + Core::Board::nWallBits));
+  for (int i = Core::Board::nHeight - count; i < Core::Board::nHeight; ++i) {
+    nVersus.mRows[player][i + Core::Board::nPadRows] = row;
+    memset(nVersus.mCells[player][i], Core::Versus::nGarbageCell,
+           sizeof(nVersus.mCells[player][i]));
+    nVersus.mCells[player][i][hole] = Core::Versus::nEmptyCell;
+  }
+  Core::Board::UpdateSkyline(nVersus.mRows[player], nVersus.mSkyline[player]);
+}
+
+// Lock an upright I tetrimino into the bottom four rows of a column.
+void LockUprightI(int player, int column) {
+  nVersus.mActive[player] = Core::Tetrimino::I;
+  for (int rotation = 0; rotation < 4; ++rotation) {
+    const Core::Shape &shape = Core::GetShape(Core::Tetrimino::I, rotation);
+    if (shape.mMinRow == 0 && shape.mMaxRow == 3) {
+      nVersus.mRotation[player] = rotation;
+      nVersus.mX[player] = column - shape.mMinColumn;
+      nVersus.mY[player] = Core::Board::nHeight - 4;
+    }
+  }
+  nVersus.Lock(player);
+}
+
+// Whether the bottom rows of a board are garbage rows that share one hole.
+bool IsGarbage(int player, int count) {
+  const Core::RowMask *rows = &nVersus.mRows[player][Core::Board::nPadRows];
+  Core::RowMask first = rows[Core::Board::nHeight - 1];
+  Core::RowMask hole = first ^ Core::Board::nFullRow;
+  bool garbage = hole != 0 && (hole & (hole - 1)) == 0;
+  for (int i = Core::Board::nHeight - count; i < Core::Board::nHeight; ++i) {
+    garbage = garbage && rows[i] == first;
+    for (int column = 0; column < Core::Board::nWidth; ++column) {
+      bool filled = (rows[i] >> (column + Core::Board::nWallBits)) & 1;
+      unsigned char cell = filled ? Core::Versus::nGarbageCell
+                                  : Core::Versus::nEmptyCell;
+      garbage = garbage && nVersus.mCells[player][i][column] == cell;
+    }
+  }
+  return garbage;
+}
+
+// Three players trade garbage until one is pushed out and one tops out, which
+// leaves the first player as the winner.
+void CheckGarbage() {
+  nVersus.Init(3, 5);
+  nVersus.Start();
+
+  // A clear of four rows sends four garbage rows to the next player.
+  FillRows(0, 4, 3);
+  LockUprightI(0, 3);
+  CHECK(nVersus.mLines[0] == 4);
+  CHECK(nVersus.mEvents[0] & Core::Event::RowsCleared);
+  CHECK(nVersus.mSentGarbage[0] == 4);
+  CHECK(nVersus.mPendingGarbage[1] == 4);
+  CHECK(nVersus.mPendingGarbage[2] == 0);
+  CHECK(nVersus.mTarget[0] == 2);
+  CHECK(nVersus.mSkyline[0][3] == Core::Board::nHeight);
+
+  // An attack cancels the garbage on its way to its sender first.
+  nVersus.SendGarbage(1, 2);
+  CHECK(nVersus.mPendingGarbage[1] == 2);
+  CHECK(nVersus.mSentGarbage[1] == 0);
+  CHECK(nVersus.mPendingGarbage[2] == 0);
+
+  // A lock without a clear raises the pending garbage.
+  LockUprightI(1, 0);
+  CHECK(nVersus.mPendingGarbage[1] == 0);
+  CHECK(IsGarbage(1, 2));
+  CHECK(nVersus.mSkyline[1][0] == Core::Board::nHeight - 6);
+  CHECK(nVersus.mAlive[1]);
+
+  // Garbage that pushes locked cells off the top knocks a player out.
+  nVersus.mRows[2][Core::Board::nPadRows] |=
+      (Core::RowMask)1 << Core::Board::nWallBits;
+  nVersus.SendGarbage(0, 1);
+  CHECK(nVersus.mPendingGarbage[2] == 1);
+  nVersus.RaiseGarbage(2);
+  CHECK(!nVersus.mAlive[2]);
+  CHECK(nVersus.mPlace[2] == 3);
+  CHECK(nVersus.mAliveCount == 2);
+  CHECK(nVersus.mEvents[2] & Core::Event::Ended);
+
+  // Attacks skip the players that were knocked out.
+  nVersus.SendGarbage(0, 1);
+  CHECK(nVersus.mPendingGarbage[1] == 1);
+  CHECK(nVersus.mPendingGarbage[2] == 0);
+  CHECK(nVersus.mSentGarbage[0] == 6);
+
+  // The second player cannot spawn on a full board and the match ends.
+  FillRows(1, Core::Board::nHeight, 0);
+  Core::Inputs inputs[3] = {};
+  nVersus.Step(inputs, 1.0f / 60.0f);
+  CHECK(!nVersus.mAlive[1]);
+  CHECK(!nVersus.mRunning);
+  CHECK(nVersus.mWinner == 0);
+  CHECK(nVersus.mPlace[0] == 1);
+  CHECK(nVersus.mPlace[1] == 2);
+  CHECK(nVersus.mPlace[2] == 3);
+}
+
+// The last two players topping out during the same step share their place
+// and the match has no winner.
+void CheckTie() {
+  nVersus.Init(2, 9);
+  nVersus.Start();
+  FillRows(0, Core::Board::nHeight, 0);
+  FillRows(1, Core::Board::nHeight, 9);
+  Core::Inputs inputs[2] = {};
+  nVersus.Step(inputs, 1.0f / 60.0f);
+  CHECK(!nVersus.mRunning);
+  CHECK(nVersus.mAliveCount == 0);
+  CHECK(nVersus.mWinner == -1);
+  CHECK(nVersus.mPlace[0] == 2);
+  CHECK(nVersus.mPlace[1] == 2);
+}
+
+int main() {
+  CheckSinglePlayer();
+  CheckGarbage();
+  CheckTie();
+  return Test::Result();
+}
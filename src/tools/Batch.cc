@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/FixedStep.h"
+#include "sim/Batch.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_batch [options]\n"
+      "  --games <count>     The number of games to play.\n"
+      "  --seed <seed>       The seed the game seeds are derived from.\n"
+      "  --threads <count>   The number of threads. 0 uses every core.\n"
+      "  --ticks <count>     Stop games that survive this many ticks.\n"
+      "  --tick-rate <hz>    The number of ticks per second of game time.\n"
+      "  --driver <name>     random, script or bot.\n"
+      "  --script <file>     The input script played by the script driver.\n"
+      "  --dataset <file>    Record every tetrimino that locks to a dataset.\n"
+      "                      Games are recorded with their index.\n");
+}
+
+int main(int argc, char *argv[]) {
+  Sim::BatchConfig config;
+  config.SetDefaults();
+  Sim::InputScript script;
+  const char *scriptFile = nullptr;
+  const char *datasetFile = nullptr;
+  double tickRate = DEFAULT_TICK_RATE;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    if (strcmp(arg, "--games") == 0) {
+      config.mGameCount = atoi(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      config.mSeed = (unsigned int)strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--threads") == 0) {
+      config.mThreadCount = atoi(value);
+    } else if (strcmp(arg, "--ticks") == 0) {
+      config.mMaxTicks = atoll(value);
+    } else if (strcmp(arg, "--tick-rate") == 0) {
+      tickRate = atof(value);
+    } else if (strcmp(arg, "--driver") == 0) {
+      if (!Sim::ParseDriver(value, &config.mDriver)) {
+        PrintUsage();
+        return 1;
+      }
+    } else if (strcmp(arg, "--script") == 0) {
+      scriptFile = value;
+    } else if (strcmp(arg, "--dataset") == 0) {
+      datasetFile = value;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+    ++i;
+  }
+
+  if (config.mGameCount < 0) {
+    printf("The number of games must not be negative.\n");
+    return 1;
+  }
+  if (!Sim::ValidTickRate(tickRate)) {
+    printf("The tick rate must be at least 1 and finite.\n");
+    return 1;
+  }
+  config.mTickTime = (float)(1.0 / tickRate);
+
+  if (config.mDriver == Sim::DriverType::Script) {
+    if (scriptFile == nullptr) {
+      printf("The script driver requires --script.\n");
+      return 1;
+    }
+    std::string error;
+    if (!script.Load(scriptFile, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+    config.mScript = &script;
+  }
+
+  Sim::DatasetWriter dataset;
+  if (datasetFile != nullptr) {
+    std::string error;
+    if (!dataset.Open(datasetFile, DEFAULT_PREVIEW_LENGTH, 0, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+    config.mDataset = &dataset;
+  }
+
+  Sim::BatchResult result = Sim::RunBatch(config);
+  Sim::PrintReport(result, stdout);
+  if (dataset.IsOpen()) {
+    std::string error;
+    if (!dataset.Close(&error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+    printf("dataset: %llu records\n", dataset.mHeader.mRecordCount);
+  }
+  return 0;
+}
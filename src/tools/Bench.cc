@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai/Bot.h"
+#include "ai/FeatureKernel.h"
+#include "ai/Finesse.h"
+#include "core/FixedStep.h"
+#include "core/InputQueue.h"
+#include "core/Snapshot.h"
+#include "core/Versus.h"
+#include "sim/Batch.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_bench [options]\n"
+      "  --filter <text>     Only run benchmarks whose names contain text.\n"
+      "  --min-time <s>      The least time each microbenchmark runs for.\n"
+      "  --threads <count>   The most threads batches scale to. 0 uses every\n"
+      "                      core.\n"
+      "  --pieces <count>    The number of pieces the bot game places.\n"
+      "  --out <file>        Write the JSON results to a file, not stdout.\n");
+}
+
+// Results are written out as a single JSON document, so every benchmark adds
+// the fields it measured to an entry.
+struct BenchEntry {
+  std::string mName;
+  std::vector<std::pair<std::string, double>> mValues;
+
+  void Add(const char *key, double value) {
+    mValues.emplace_back(key, value);
+  }
+};
+
+struct BenchOptions {
+  const char *mFilter;
+  double mMinSeconds;
+  int mMaxThreads;
+  int mBotPieces;
+};
+
+BenchOptions nOptions;
+std::vector<BenchEntry> nEntries;
+
+// Results are folded into this so the compiler cannot drop the measured work.
+volatile unsigned int nSink;
+
+bool Selected(const char *name) {
+  return nOptions.mFilter == nullptr || strstr(name, nOptions.mFilter);
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Run a body that performs a number of operations, doubling the number until
+// a run takes at least the minimum time, and report the time per operation of
+// the final run.
+template <typename T> void Measure(const char *name, T body) {
+  if (!Selected(name)) {
+    return;
+  }
+  long long iterations = 1;
+  double seconds = 0.0;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    seconds = Seconds(start);
+    if (seconds >= nOptions.mMinSeconds || iterations >= (1ll << 40)) {
+      break;
+    }
+    iterations *= 2;
+  }
+  BenchEntry entry;
+  entry.mName = name;
+  entry.Add("iterations", (double)iterations);
+  entry.Add("ns_per_op", seconds * 1e9 / (double)iterations);
+  nEntries.push_back(entry);
+  fprintf(stderr, "%-24s %12.2f ns/op\n", name,
+          seconds * 1e9 / (double)iterations);
+}
+
+// A game a few pieces in, so collision checks see a realistic stack.
+Core::Game MakePlayedGame() {
+  Sim::RandomDriver driver;
+  driver.Init(7);
+  Core::Game game;
+  game.Init(11);
+  game.StartGame();
+  int pieces = 0;
+  while (game.mRunning && pieces < 12) {
+    game.Step(driver.NextInputs(game), 1.0f / (float)DEFAULT_TICK_RATE);
+    pieces += (game.mEvents & Core::Event::Locked) ? 1 : 0;
+  }
+  return game;
+}
+
+// A game whose active tetrimino is a vertical I at the left wall that
+// completes the given number of rows when it locks.
+Core::Game MakeClearGame(int lines) {
+  Core::Game game;
+  game.Init(1);
+  game.StartGame();
+  int rotation = 0;
+  while (Core::GetShape(Core::Tetrimino::I, rotation).mMinColumn !=
+         Core::GetShape(Core::Tetrimino::I, rotation).mMaxColumn) {
+    ++rotation;
+  }
+  const Core::Shape &shape = Core::GetShape(Core::Tetrimino::I, rotation);
+  game.mActiveTetrimino = Core::Tetrimino::I;
+  game.mShapeRotation = rotation;
+  game.mActiveX = -shape.mMinColumn;
+  game.mActiveY = Core::Board::nHeight - 1 - shape.mMaxRow;
+
+  // Fill every column but the first in the bottom rows.
+  Core::RowMask row = (Core::RowMask)(Core::Board::nFullRow &
+                                      ~(1u << Core::Board::nWallBits));
+  for (int i = Core::Board::nHeight - lines; i < Core::Board::nHeight; ++i) {
+    game.mBoard.mRows[i + Core::Board::nPadRows] = row;
+    for (int column = 1; column < Core::Board::nWidth; ++column) {
+      game.mBoard.mTypes[i][column] = Core::Tetrimino::O;
+    }
+  }
+  game.mBoard.UpdateSkyline();
+  return game;
+}
+
+void RunMicrobenchmarks() {
+  Core::Game played = MakePlayedGame();
+  Measure("can_move_shape", [&](long long iterations) {
+    unsigned int fits = 0;
+    const Core::Shape &shape = played.ActiveShape();
+    for (long long i = 0; i < iterations; ++i) {
+      int x = (int)(i % 13) - 3 - played.mActiveX;
+      int y = (int)((i >> 4) % 24) - played.mActiveY;
+      fits += played.CanMoveShape(shape, x, y) ? 1 : 0;
+    }
+    nSink = nSink + fits;
+  });
+
+  Measure("get_shape", [&](long long iterations) {
+    unsigned int bits = 0;
+    for (long long i = 0; i < iterations; ++i) {
+      Core::Tetrimino tetrimino = (Core::Tetrimino)(i % 7);
+      bits += Core::GetShape(tetrimino, (int)(i >> 3) & 3).mRows[1];
+    }
+    nSink = nSink + bits;
+  });
+
+  // Locking and spawning change the game, so every iteration works on a copy
+  // of a prepared game and the times include the copy.
+  for (int lines = 0; lines <= 4; ++lines) {
+    Core::Game source = MakeClearGame(lines);
+    std::string name = "lock_clear_" + std::to_string(lines);
+    Measure(name.c_str(), [&](long long iterations) {
+      for (long long i = 0; i < iterations; ++i) {
+        Core::Game game = source;
+        game.LockActiveTetrimino(game.ActiveShape());
+        nSink = nSink + (unsigned int)game.mClearedRowCount;
+      }
+    });
+  }
+
+  Core::Game spawnSource = played;
+  spawnSource.mActiveTetrimino = Core::Tetrimino::None;
+  Measure("spawn", [&](long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+      Core::Game game = spawnSource;
+      game.SpawnTetrimino();
+      nSink = nSink + (unsigned int)game.mActiveTetrimino;
+    }
+  });
+
+  // A rollback saves a snapshot every frame and restores one per correction.
+  Core::Snapshot snapshot;
+  Core::Game restored = played;
+  Measure("snapshot_save_restore", [&](long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+      snapshot.Save(played);
+      snapshot.Restore(&restored);
+      nSink = nSink + (unsigned int)restored.mActiveX;
+    }
+  });
+
+  // A tap that starts and ends within a step splits it into three stretches.
+  Core::InputQueue queue;
+  queue.Clear();
+  Core::TimedStep stretches[16];
+  Measure("input_queue_split", [&](long long iterations) {
+    double tickTime = 1.0 / 60.0;
+    for (long long i = 0; i < iterations; ++i) {
+      double start = (double)i * tickTime;
+      queue.Push(start + 0.003, Core::Key::Left, true);
+      queue.Push(start + 0.005, Core::Key::Left, false);
+      int count = queue.Split(start, (float)tickTime, stretches, 16);
+      nSink = nSink + (unsigned int)count;
+    }
+  });
+
+  // The finesse search runs once for every tetrimino that spawns unless the
+  // surface and tetrimino are already cached.
+  Ai::FinesseSearch finesseSearch;
+  Ai::FinesseResult finesseResult;
+  Measure("finesse_search", [&](long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+      Core::Tetrimino tetrimino = (Core::Tetrimino)(i % 7);
+      finesseSearch.Run(played.mBoard.mSkyline, tetrimino, &finesseResult);
+      nSink = nSink + (unsigned int)finesseResult.mCount;
+    }
+  });
+  Ai::FinesseCache finesseCache;
+  finesseCache.Init(Ai::FinesseCache::nDefaultEntryCount);
+  Measure("finesse_cached", [&](long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+      Core::Tetrimino tetrimino = (Core::Tetrimino)(i % 7);
+      const Ai::FinesseResult &cached =
+          finesseCache.Find(played.mBoard, tetrimino, &finesseSearch);
+      nSink = nSink + (unsigned int)cached.mCount;
+    }
+  });
+
+  // The features of a full batch of boards from a played game.
+  Ai::BoardBatch batch;
+  batch.Clear();
+  for (int i = 0; i < 256; ++i) {
+    batch.Add(played.mBoard, 0);
+  }
+  std::vector<Ai::Features> features(batch.mCount);
+  Measure("features_batch_256", [&](long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+      Ai::ComputeFeatures(batch, features.data());
+      nSink = nSink + (unsigned int)features[i & 255].mHoles;
+    }
+  });
+}
+
+// Steps of games with random keys, restarting games as they end. The drop
+// rate is kept at the given number of rows per second.
+template <typename G>
+void MeasureGameTick(const char *name, float dropRate = 1.0f) {
+  Measure(name, [&](long long iterations) {
+    Sim::RandomDriver driver;
+    driver.Init(3);
+    Core::BasicGame<G> game;
+    game.Init(5);
+    game.StartGame();
+    game.mDropRate = dropRate;
+    for (long long i = 0; i < iterations; ++i) {
+      if (!game.mRunning) {
+        game.StartGame();
+        game.mDropRate = dropRate;
+      }
+      game.Step(driver.NextInputs(), 1.0f / (float)DEFAULT_TICK_RATE);
+    }
+    nSink = nSink + (unsigned int)game.mLines;
+  });
+}
+
+void RunGameTick() {
+  MeasureGameTick<Core::StandardGeometry>("game_tick");
+  MeasureGameTick<Core::WideGeometry>("game_tick_wide");
+  MeasureGameTick<Core::StressGeometry>("game_tick_stress");
+  // Ten rows per tick at the default tick rate.
+  MeasureGameTick<Core::StandardGeometry>(
+      "game_tick_fast_gravity", 10.0f * (float)DEFAULT_TICK_RATE);
+}
+
+// Steps of a versus match of 100 random players, restarting the match when it
+// ends. An operation is one step of every board.
+void RunVersusStep() {
+  static Core::Versus versus;
+  static Sim::RandomDriver drivers[Core::Versus::nMaxPlayers];
+  Measure("versus_step_100", [&](long long iterations) {
+    Core::Inputs inputs[Core::Versus::nMaxPlayers];
+    versus.Init(100, 5);
+    versus.Start();
+    for (int p = 0; p < versus.mPlayerCount; ++p) {
+      drivers[p].Init(3 + p);
+    }
+    for (long long i = 0; i < iterations; ++i) {
+      if (!versus.mRunning) {
+        versus.Init(100, 5 + i);
+        versus.Start();
+      }
+      for (int p = 0; p < versus.mPlayerCount; ++p) {
+        inputs[p] = drivers[p].NextInputs();
+      }
+      versus.Step(inputs, 1.0f / (float)DEFAULT_TICK_RATE);
+    }
+    nSink = nSink + (unsigned int)versus.mAliveCount;
+  });
+}
+
+void RunBotGame() {
+  const char *name = "bot_game";
+  if (!Selected(name)) {
+    return;
+  }
+  Ai::BotConfig config;
+  config.SetDefaults();
+  Ai::BotDriver driver;
+  driver.Init(config);
+  Core::Game game;
+  game.Init(9);
+  game.StartGame();
+  long long ticks = 0;
+  int pieces = 0;
+  int lines = 0;
+  int games = 1;
+  auto start = std::chrono::steady_clock::now();
+  while (pieces < nOptions.mBotPieces) {
+    if (!game.mRunning) {
+      lines += game.mLines;
+      game.StartGame();
+      ++games;
+    }
+    game.Step(driver.NextInputs(game), 1.0f / (float)DEFAULT_TICK_RATE);
+    pieces += (game.mEvents & Core::Event::Locked) ? 1 : 0;
+    ++ticks;
+  }
+  double seconds = Seconds(start);
+  lines += game.mLines;
+
+  BenchEntry entry;
+  entry.mName = name;
+  entry.Add("pieces", pieces);
+  entry.Add("ticks", (double)ticks);
+  entry.Add("lines", lines);
+  entry.Add("games", games);
+  entry.Add("seconds", seconds);
+  entry.Add("us_per_piece", seconds * 1e6 / (double)pieces);
+  nEntries.push_back(entry);
+  fprintf(stderr, "%-24s %12.2f us/piece\n", name,
+          seconds * 1e6 / (double)pieces);
+}
+
+void RunBatchScaling() {
+  const char *name = "batch_scaling";
+  if (!Selected(name)) {
+    return;
+  }
+  int maxThreads = nOptions.mMaxThreads;
+  if (maxThreads <= 0) {
+    maxThreads = (int)std::thread::hardware_concurrency();
+    maxThreads = maxThreads > 0 ? maxThreads : 1;
+  }
+  Sim::BatchConfig config;
+  config.SetDefaults();
+  config.mGameCount = 20000;
+  double baseRate = 0.0;
+  int threads = 1;
+  while (true) {
+    config.mThreadCount = threads;
+    Sim::BatchResult result = Sim::RunBatch(config);
+    long long ticks = 0;
+    for (const Sim::GameResult &game : result.mGames) {
+      ticks += game.mTicks;
+    }
+    double seconds = result.mSeconds > 0.0 ? result.mSeconds : 1e-9;
+    double rate = (double)ticks / seconds;
+    baseRate = threads == 1 ? rate : baseRate;
+
+    BenchEntry entry;
+    entry.mName = std::string(name) + "_" + std::to_string(threads);
+    entry.Add("threads", threads);
+    entry.Add("games", config.mGameCount);
+    entry.Add("seconds", result.mSeconds);
+    entry.Add("ticks_per_second", rate);
+    entry.Add("speedup", rate / baseRate);
+    nEntries.push_back(entry);
+    fprintf(stderr, "%-24s %12.0f ticks/s %6.2fx\n", entry.mName.c_str(),
+            rate, rate / baseRate);
+
+    // The counts double and always finish with every core, even when that is
+    // not a power of two.
+    if (threads == maxThreads) {
+      break;
+    }
+    threads = std::min(threads * 2, maxThreads);
+  }
+}
+
+void WriteJson(FILE *file) {
+  fprintf(file, "{\n");
+  fprintf(file, "  \"feature_kernel\": \"%s\",\n",
+          Ai::FeatureKernelName(Ai::BestFeatureKernel()));
+  fprintf(file, "  \"hardware_threads\": %u,\n",
+          std::thread::hardware_concurrency());
+  fprintf(file, "  \"benchmarks\": [");
+  for (size_t i = 0; i < nEntries.size(); ++i) {
+    const BenchEntry &entry = nEntries[i];
+    fprintf(file, "%s\n    {\"name\": \"%s\"", i == 0 ? "" : ",",
+            entry.mName.c_str());
+    for (const auto &value : entry.mValues) {
+      fprintf(file, ", \"%s\": %.15g", value.first.c_str(), value.second);
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n  ]\n}\n");
+}
+
+int main(int argc, char *argv[]) {
+  nOptions.mFilter = nullptr;
+  nOptions.mMinSeconds = 0.2;
+  nOptions.mMaxThreads = 0;
+  nOptions.mBotPieces = 10000;
+  const char *outFile = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    if (strcmp(arg, "--filter") == 0) {
+      nOptions.mFilter = value;
+    } else if (strcmp(arg, "--min-time") == 0) {
+      nOptions.mMinSeconds = atof(value);
+    } else if (strcmp(arg, "--threads") == 0) {
+      nOptions.mMaxThreads = atoi(value);
+    } else if (strcmp(arg, "--pieces") == 0) {
+      nOptions.mBotPieces = atoi(value);
+    } else if (strcmp(arg, "--out") == 0) {
+      outFile = value;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+    ++i;
+  }
+
+  // Progress goes to stderr so stdout only holds the JSON.
+  RunMicrobenchmarks();
+  RunGameTick();
+  RunVersusStep();
+  RunBotGame();
+  RunBatchScaling();
+
+  FILE *file = stdout;
+  if (outFile != nullptr) {
+    file = fopen(outFile, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "Failed to open %s.\n", outFile);
+      return 1;
+    }
+  }
+  WriteJson(file);
+  if (file != stdout) {
+    fclose(file);
+  }
+  return 0;
+}
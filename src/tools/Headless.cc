@@ -0,0 +1,127 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "sim/Headless.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_headless [options]\n"
+      "  --frames <count>    The number of frames to play.\n"
+      "  --seed <seed>       The seed the game seeds are derived from.\n"
+      "  --tick-rate <hz>    The number of frames per second of game time.\n"
+      "  --drop-rate <rate>  The rows per second every game starts dropping\n"
+      "                      at, or 20g to land tetriminos at once.\n"
+      "  --lock-delay <s>    The least time a landed tetrimino rests before\n"
+      "                      it locks. Defaults to 0, or 0.5 at 20G.\n"
+      "  --driver <name>     random, script or bot.\n"
+      "  --script <file>     The input script played by the script driver.\n"
+      "                      - reads the script from stdin.\n"
+      "  --restart           Start a new game when one tops out rather than\n"
+      "                      ending the run.\n"
+      "  --finesse           Grade the presses of every tetrimino against\n"
+      "                      the fewest its placement needed.\n"
+      "  --out <file>        Write the JSON stats to a file, not stdout.\n");
+}
+
+int main(int argc, char *argv[]) {
+  Sim::HeadlessConfig config;
+  config.SetDefaults();
+  Sim::InputScript script;
+  const char *scriptFile = nullptr;
+  const char *outFile = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--restart") == 0) {
+      config.mRestart = true;
+      continue;
+    }
+    if (strcmp(arg, "--finesse") == 0) {
+      config.mFinesse = true;
+      continue;
+    }
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    if (strcmp(arg, "--frames") == 0) {
+      config.mFrames = atoll(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      config.mSeed = (unsigned int)strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--tick-rate") == 0) {
+      config.mTickRate = atof(value);
+    } else if (strcmp(arg, "--drop-rate") == 0) {
+      config.mDropRate = strcmp(value, "20g") == 0 || strcmp(value, "20G") == 0
+                             ? INFINITY
+                             : (float)atof(value);
+    } else if (strcmp(arg, "--lock-delay") == 0) {
+      config.mLockDelay = (float)atof(value);
+    } else if (strcmp(arg, "--driver") == 0) {
+      if (!Sim::ParseDriver(value, &config.mDriver)) {
+        PrintUsage();
+        return 1;
+      }
+    } else if (strcmp(arg, "--script") == 0) {
+      scriptFile = value;
+    } else if (strcmp(arg, "--out") == 0) {
+      outFile = value;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+    ++i;
+  }
+
+  if (config.mFrames < 0) {
+    fprintf(stderr, "The number of frames must not be negative.\n");
+    return 1;
+  }
+  if (!Sim::ValidTickRate(config.mTickRate)) {
+    fprintf(stderr, "The tick rate must be at least 1 and finite.\n");
+    return 1;
+  }
+
+  if (config.mDriver == Sim::DriverType::Script) {
+    if (scriptFile == nullptr) {
+      fprintf(stderr, "The script driver requires --script.\n");
+      return 1;
+    }
+    std::string error;
+    bool loaded = false;
+    if (strcmp(scriptFile, "-") == 0) {
+      std::stringstream text;
+      text << std::cin.rdbuf();
+      loaded = script.Parse(text.str().c_str(), &error);
+    } else {
+      loaded = script.Load(scriptFile, &error);
+    }
+    if (!loaded) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    config.mScript = &script;
+  }
+
+  // The output is opened first so that a long run is not lost to a path that
+  // cannot be written.
+  FILE *file = stdout;
+  if (outFile != nullptr) {
+    file = fopen(outFile, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "Failed to open %s.\n", outFile);
+      return 1;
+    }
+  }
+  Sim::HeadlessResult result = Sim::RunHeadless(config);
+  Sim::WriteJson(config, result, file);
+  if (file != stdout) {
+    fclose(file);
+  }
+  return 0;
+}
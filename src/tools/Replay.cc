@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "sim/Dataset.h"
+#include "sim/Replay.h"
+#include "sim/ThreadPool.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_replay [options] <replay>...\n"
+      "  --threads <count>   The number of threads. 0 uses every core.\n"
+      "  --quiet             Only print the totals.\n"
+      "  --dataset <file>    Record every tetrimino that locks to a dataset.\n"
+      "                      Replays are recorded with their index.\n");
+}
+
+struct Entry {
+  const char *mFilename;
+  bool mSuccess;
+  std::string mError;
+  Sim::ReplayResult mResult;
+};
+
+int main(int argc, char *argv[]) {
+  int threadCount = 0;
+  bool quiet = false;
+  const char *datasetFile = nullptr;
+  std::vector<Entry> entries;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threadCount = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (strcmp(argv[i], "--dataset") == 0 && i + 1 < argc) {
+      datasetFile = argv[++i];
+    } else if (argv[i][0] == '-') {
+      PrintUsage();
+      return 1;
+    } else {
+      Entry entry;
+      entry.mFilename = argv[i];
+      entries.push_back(entry);
+    }
+  }
+  if (entries.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  Sim::DatasetWriter dataset;
+  if (datasetFile != nullptr) {
+    std::string error;
+    if (!dataset.Open(datasetFile, DEFAULT_PREVIEW_LENGTH, 0, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+  }
+  Sim::DatasetWriter *datasetPtr = dataset.IsOpen() ? &dataset : nullptr;
+
+  // Every replay is simulated independently, so they are spread over a pool.
+  Sim::ThreadPool pool;
+  pool.Init(threadCount);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Entry *entryPtr = &entries[i];
+    pool.Submit([entryPtr, datasetPtr, i]() {
+      Sim::DatasetRecorder recorder;
+      recorder.Init(datasetPtr);
+      recorder.Begin((unsigned int)i);
+      entryPtr->mSuccess =
+          Sim::PlayReplayFile(entryPtr->mFilename, &entryPtr->mResult,
+                              &entryPtr->mError, &recorder);
+      recorder.Flush();
+    });
+  }
+  pool.Wait();
+  auto end = std::chrono::steady_clock::now();
+  pool.Purge();
+  if (dataset.IsOpen()) {
+    std::string error;
+    if (!dataset.Close(&error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+  }
+
+  unsigned long long ticks = 0;
+  long long lines = 0;
+  int failures = 0;
+  for (const Entry &entry : entries) {
+    if (!entry.mSuccess) {
+      ++failures;
+      printf("%s: %s\n", entry.mFilename, entry.mError.c_str());
+      continue;
+    }
+    const Sim::ReplayResult &result = entry.mResult;
+    ticks += result.mTicks;
+    lines += result.mLines;
+    if (!quiet) {
+      printf("%s: %llu ticks, %d pieces, %d lines%s\n", entry.mFilename,
+             result.mTicks, result.mPieces, result.mLines,
+             result.mToppedOut ? ", topped out" : "");
+    }
+  }
+  double seconds = std::chrono::duration<double>(end - start).count();
+  seconds = seconds > 0.0 ? seconds : 1e-9;
+  printf("%d replays, %d failed, %llu ticks, %lld lines in %.3fs "
+         "(%.1f ticks/s)\n",
+         (int)entries.size(), failures, ticks, lines, seconds,
+         ticks / seconds);
+  if (datasetFile != nullptr) {
+    printf("dataset: %llu records\n", dataset.mHeader.mRecordCount);
+  }
+  return failures == 0 ? 0 : 1;
+}
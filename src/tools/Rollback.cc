@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "sim/Drivers.h"
+#include "sim/Net.h"
+#include "sim/Rollback.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_rollback [options]\n"
+      "  --frames <count>       The number of frames both players play.\n"
+      "  --seed <seed>          The seed of the games and the keys.\n"
+      "  --latency <ms>         The one way latency of the link.\n"
+      "  --jitter <ms>          The most the latency varies by.\n"
+      "  --loss <fraction>      The fraction of packets that are lost.\n"
+      "  --delay <frames>       The input delay of both players.\n"
+      "  --max-rollback <count> The most frames stepped ahead of the keys\n"
+      "                         that were received.\n"
+      "  --udp <port>           Send packets over UDP on 127.0.0.1 using\n"
+      "                         this port and the next, after the simulated\n"
+      "                         link.\n");
+}
+
+// One of the two machines. Packets leave through a simulated link, and when
+// the link delivers them they are either handed to the other machine or sent
+// over a real socket.
+struct Peer {
+  Sim::RollbackSession mSession;
+  Sim::RandomDriver mDriver;
+  Core::Inputs mPending;
+  bool mHasPending;
+  Sim::LinkSimulator mLink;
+  Sim::UdpSocket mSocket;
+};
+
+int main(int argc, char *argv[]) {
+  Sim::RollbackConfig config;
+  config.SetDefaults();
+  int frames = 3600;
+  double latency = 0.05;
+  double jitter = 0.01;
+  float loss = 0.05f;
+  int udpPort = 0;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    if (strcmp(arg, "--frames") == 0) {
+      frames = atoi(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      config.mSeed = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--latency") == 0) {
+      latency = atof(value) / 1000.0;
+    } else if (strcmp(arg, "--jitter") == 0) {
+      jitter = atof(value) / 1000.0;
+    } else if (strcmp(arg, "--loss") == 0) {
+      loss = (float)atof(value);
+    } else if (strcmp(arg, "--delay") == 0) {
+      config.mInputDelay = atoi(value);
+    } else if (strcmp(arg, "--max-rollback") == 0) {
+      config.mMaxRollback = atoi(value);
+    } else if (strcmp(arg, "--udp") == 0) {
+      udpPort = atoi(value);
+    } else {
+      PrintUsage();
+      return 1;
+    }
+    ++i;
+  }
+
+  static Peer peers[2];
+  for (int p = 0; p < 2; ++p) {
+    Peer &peer = peers[p];
+    config.mLocalPlayer = p;
+    peer.mSession.Init(config);
+    peer.mDriver.Init((unsigned int)config.mSeed * 2 + p);
+    peer.mHasPending = false;
+    peer.mLink.Init(latency, jitter, loss, config.mSeed * 2 + p);
+    if (udpPort != 0) {
+      std::string error;
+      if (!peer.mSocket.Open((unsigned short)(udpPort + p), "127.0.0.1",
+                             (unsigned short)(udpPort + 1 - p), &error)) {
+        printf("%s\n", error.c_str());
+        return 1;
+      }
+    }
+  }
+
+  // Frames are played in virtual time, so the link delays packets by frames
+  // rather than by waiting. Once both players reach the last frame, packets
+  // are still exchanged until each has the keys of every frame.
+  double tickTime = config.mTickTime;
+  double sessionSeconds = 0.0;
+  unsigned char packet[Sim::nMaxDatagramSize];
+  bool settled = false;
+  long long tick = 0;
+  for (; tick < (long long)frames * 100 && !settled; ++tick) {
+    double now = (double)tick * tickTime;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < 2; ++p) {
+      Peer &peer = peers[p];
+      Peer &other = peers[1 - p];
+      size_t size;
+      while ((size = peer.mLink.Receive(packet, now)) != 0) {
+        if (udpPort != 0) {
+          peer.mSocket.Send(packet, size);
+        } else {
+          other.mSession.ReadPacket(packet, size);
+        }
+      }
+      while (udpPort != 0 &&
+             (size = other.mSocket.Receive(packet, sizeof(packet))) != 0) {
+        other.mSession.ReadPacket(packet, size);
+      }
+    }
+    settled = true;
+    for (Peer &peer : peers) {
+      Sim::RollbackSession &session = peer.mSession;
+      if (session.mFrame < frames) {
+        if (!peer.mHasPending) {
+          peer.mPending = peer.mDriver.NextInputs();
+          peer.mHasPending = true;
+        }
+        if (session.Advance(peer.mPending)) {
+          peer.mHasPending = false;
+        }
+      } else {
+        session.Synchronize();
+      }
+      settled = settled && session.mFrame >= frames &&
+                session.mRemoteReceived >= frames;
+    }
+    for (Peer &peer : peers) {
+      size_t size = peer.mSession.WritePacket(packet);
+      peer.mLink.Send(packet, size, now);
+    }
+    sessionSeconds +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+  }
+
+  unsigned long long checksums[2];
+  for (int p = 0; p < 2; ++p) {
+    peers[p].mSession.Synchronize();
+    checksums[p] = peers[p].mSession.Checksum();
+  }
+  for (int p = 0; p < 2; ++p) {
+    const Sim::RollbackStats &stats = peers[p].mSession.mStats;
+    printf("player %d: %lld frames, %lld stalls, %lld rollbacks, "
+           "%lld resimulated frames, deepest %d\n",
+           p, stats.mFrames, stats.mStalls, stats.mRollbacks,
+           stats.mResimulatedFrames, stats.mDeepestRollback);
+    printf("  packets: %lld read, %lld rejected\n", stats.mPacketsRead,
+           stats.mPacketsRejected);
+    printf("  checksum: %016llx\n", checksums[p]);
+  }
+  long long stepped = 0;
+  for (const Peer &peer : peers) {
+    stepped += peer.mSession.mStats.mFrames +
+               peer.mSession.mStats.mResimulatedFrames;
+  }
+  printf("%lld ticks, %.3f us per stepped frame including snapshots\n", tick,
+         sessionSeconds * 1e6 / (double)(stepped > 0 ? stepped : 1));
+  if (!settled) {
+    printf("The players never received every frame.\n");
+    return 1;
+  }
+  if (checksums[0] != checksums[1]) {
+    printf("The players desynchronized.\n");
+    return 1;
+  }
+  printf("The players agree.\n");
+  return 0;
+}
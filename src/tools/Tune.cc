@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include "sim/Tuner.h"
+
+void PrintUsage() {
+  printf(
+      "usage: tetris_tune [options]\n"
+      "  --workers <count>     The number of worker processes. 0 uses every\n"
+      "                        core.\n"
+      "  --generations <count> Stop once this many generations are evaluated.\n"
+      "  --population <count>  The number of candidates in a generation.\n"
+      "  --elites <count>      The best candidates kept in every generation.\n"
+      "  --games <count>       The games every candidate plays.\n"
+      "  --pieces <count>      Stop games once this many tetriminos locked.\n"
+      "  --seed <seed>         The seed the game seeds are derived from.\n"
+      "  --mutation <scale>    How far mutation moves a weight.\n"
+      "  --checkpoint <file>   Save the population after every generation and\n"
+      "                        resume from it when it exists.\n"
+      "  --table <file>        The file shared with the workers.\n");
+}
+
+int main(int argc, char *argv[]) {
+  if (argc == 3 && strcmp(argv[1], "--worker") == 0) {
+    std::string error;
+    if (!Sim::RunTunerWorker(argv[2], &error)) {
+      fprintf(stderr, "worker: %s\n", error.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  Sim::TunerConfig config;
+  config.SetDefaults();
+  int workerCount = 0;
+  int generationCount = 20;
+  const char *checkpointFile = nullptr;
+  const char *tableFile = "tetris_tune.table";
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      PrintUsage();
+      return 1;
+    }
+    if (strcmp(arg, "--workers") == 0) {
+      workerCount = atoi(value);
+    } else if (strcmp(arg, "--generations") == 0) {
+      generationCount = atoi(value);
+    } else if (strcmp(arg, "--population") == 0) {
+      config.mPopulation = atoi(value);
+    } else if (strcmp(arg, "--elites") == 0) {
+      config.mEliteCount = atoi(value);
+    } else if (strcmp(arg, "--games") == 0) {
+      config.mGameCount = atoi(value);
+    } else if (strcmp(arg, "--pieces") == 0) {
+      config.mMaxPieces = atoi(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      config.mSeed = (unsigned int)strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--mutation") == 0) {
+      config.mMutation = (float)atof(value);
+    } else if (strcmp(arg, "--checkpoint") == 0) {
+      checkpointFile = value;
+    } else if (strcmp(arg, "--table") == 0) {
+      tableFile = value;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+    ++i;
+  }
+  std::string error;
+  if (!config.Validate(&error)) {
+    printf("%s\n", error.c_str());
+    return 1;
+  }
+  if (workerCount <= 0) {
+    workerCount = (int)std::thread::hardware_concurrency();
+    workerCount = workerCount > 0 ? workerCount : 1;
+  }
+
+  Sim::TunerState state;
+  std::error_code errorCode;
+  if (checkpointFile != nullptr &&
+      std::filesystem::exists(checkpointFile, errorCode)) {
+    // A resumed run keeps the settings it was started with.
+    if (!state.Load(checkpointFile, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+    printf("resuming %s at generation %d\n", checkpointFile,
+           state.mGeneration);
+  } else {
+    state.Init(config);
+  }
+
+  Sim::TunerPool pool;
+  if (!pool.Start(argv[0], tableFile, workerCount, state.mConfig, &error)) {
+    printf("%s\n", error.c_str());
+    return 1;
+  }
+  printf("tuning with %d workers, %d candidates, %d games of %d pieces\n",
+         workerCount, state.mConfig.mPopulation, state.mConfig.mGameCount,
+         state.mConfig.mMaxPieces);
+  while (state.mGeneration < generationCount) {
+    // A checkpoint holds the generation that was evaluated last, so the next
+    // one is bred first. A fresh run has nothing to breed from.
+    if (state.Evaluated()) {
+      state.Breed();
+    }
+    long long pieces = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (!pool.Evaluate(&state.mCandidates, &pieces, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    ++state.mGeneration;
+
+    const Sim::Candidate *best = &state.mCandidates[0];
+    double sum = 0.0;
+    for (const Sim::Candidate &candidate : state.mCandidates) {
+      best = candidate.mFitness > best->mFitness ? &candidate : best;
+      sum += candidate.mFitness;
+    }
+    printf("generation %d: best %.2f mean %.2f lines in %.1fs, %.0f pieces/s\n",
+           state.mGeneration, best->mFitness,
+           sum / state.mCandidates.size(), seconds,
+           seconds > 0.0 ? pieces / seconds : 0.0);
+    printf("  weights:");
+    for (float weight : best->mWeights) {
+      printf(" %.6f", weight);
+    }
+    printf("\n");
+
+    if (checkpointFile != nullptr && !state.Save(checkpointFile, &error)) {
+      printf("%s\n", error.c_str());
+      return 1;
+    }
+  }
+  pool.Stop();
+  return 0;
+}
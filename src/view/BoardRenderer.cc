@@ -0,0 +1,194 @@
+#include <Error.h>
+#include <glad/glad.h>
+
+#include "view/BoardRenderer.h"
+
+namespace View {
+
+// The translation and scale of each queue slot. The first slot shows the next
+// tetrimino at full size and the rest are shrunk.
+constexpr float nQueueX = (float)Core::Board::nWidth / 2.0f + 2.0f;
+constexpr float nQueueTop = (float)Core::Board::nVisibleHeight / 2.0f;
+const float nQueueSlotLayouts[nQueueSlotCount][3] = {
+    {nQueueX, nQueueTop - 4.5f, 1.0f},
+    {nQueueX, nQueueTop - 8.5f, 0.7f},
+    {nQueueX, nQueueTop - 11.5f, 0.7f}};
+
+const char *nVertexSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in uint aTile;
+layout(location = 2) in uint aPalette;
+
+uniform vec4 uView;
+uniform uint uGridWidth;
+uniform uint uQueueTileStart;
+uniform uint uGhostTileStart;
+uniform uint uActiveTileStart;
+uniform vec2 uBoardOrigin;
+uniform vec3 uQueueSlots[3];
+uniform vec3 uActiveCells[8];
+
+out vec4 vColor;
+
+const vec4 cPalette[8] = vec4[8](
+  vec4(0.0, 1.0, 1.0, 1.0),
+  vec4(1.0, 0.5, 0.0, 1.0),
+  vec4(0.0, 0.0, 1.0, 1.0),
+  vec4(1.0, 1.0, 0.0, 1.0),
+  vec4(0.0, 1.0, 0.0, 1.0),
+  vec4(1.0, 0.0, 1.0, 1.0),
+  vec4(1.0, 0.0, 0.0, 1.0),
+  vec4(0.5, 0.5, 0.5, 1.0));
+
+void main() {
+  vec2 center;
+  float scale;
+  if (aTile < uQueueTileStart) {
+    uint row = aTile / uGridWidth;
+    uint column = aTile % uGridWidth;
+    center = uBoardOrigin + vec2(float(column), -float(row));
+    scale = 1.0;
+  } else if (aTile < uGhostTileStart) {
+    uint queueTile = aTile - uQueueTileStart;
+    vec3 slot = uQueueSlots[queueTile / 16u];
+    uint cell = queueTile % 16u;
+    center = slot.xy + slot.z * vec2(float(cell % 4u), -float(cell / 4u));
+    scale = slot.z;
+  } else {
+    vec3 cell = uActiveCells[aTile - uGhostTileStart];
+    center = uBoardOrigin + vec2(cell.x, -cell.y);
+    scale = cell.z;
+  }
+  vec2 world = center + aCorner * 0.9 * scale;
+  gl_Position = vec4(world * uView.xy + uView.zw, 0.0, 1.0);
+  vColor = cPalette[aPalette];
+  // The ghost is a dim copy of the active tetrimino.
+  if (aTile >= uGhostTileStart && aTile < uActiveTileStart) {
+    vColor.rgb *= 0.3;
+  }
+}
+)";
+
+const char *nFragmentSource = R"(
+#version 330 core
+in vec4 vColor;
+out vec4 oColor;
+void main() {
+  oColor = vColor;
+}
+)";
+
+unsigned int CompileShader(GLenum type, const char *source) {
+  unsigned int shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  int success;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    char infoLog[512];
+    glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+    LogAbortIf(true, infoLog);
+  }
+  return shader;
+}
+
+unsigned int CreateProgram(
+    const char *vertexSource, const char *fragmentSource) {
+  unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+  unsigned int fragmentShader =
+      CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+  unsigned int program = glCreateProgram();
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  glLinkProgram(program);
+  int success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    char infoLog[512];
+    glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+    LogAbortIf(true, infoLog);
+  }
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+  return program;
+}
+
+void BoardRenderer::Init() {
+  // Create the program that draws the tiles.
+  mProgram = CreateProgram(nVertexSource, nFragmentSource);
+
+  // The layout never changes, so it is only set once.
+  glUseProgram(mProgram);
+  glUniform1ui(
+      glGetUniformLocation(mProgram, "uGridWidth"), Core::Board::nWidth);
+  glUniform1ui(
+      glGetUniformLocation(mProgram, "uQueueTileStart"), nQueueTileStart);
+  glUniform1ui(
+      glGetUniformLocation(mProgram, "uGhostTileStart"), nGhostTileStart);
+  glUniform1ui(
+      glGetUniformLocation(mProgram, "uActiveTileStart"), nActiveTileStart);
+  glUniform2f(glGetUniformLocation(mProgram, "uBoardOrigin"),
+              -(float)(Core::Board::nWidth / 2),
+              (float)(Core::Board::nVisibleHeight / 2));
+  glUniform3fv(glGetUniformLocation(mProgram, "uQueueSlots"), nQueueSlotCount,
+               &nQueueSlotLayouts[0][0]);
+  mViewLoc = glGetUniformLocation(mProgram, "uView");
+  mActiveCellsLoc = glGetUniformLocation(mProgram, "uActiveCells");
+
+  // Every tile is a quad made from a triangle strip.
+  float corners[4][2] = {
+      {-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f}, {0.5f, 0.5f}};
+  glGenVertexArrays(1, &mVao);
+  glBindVertexArray(mVao);
+  glGenBuffers(1, &mCornerVbo);
+  glBindBuffer(GL_ARRAY_BUFFER, mCornerVbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(0);
+
+  // The instance array is uploaded in place as tiles change.
+  glGenBuffers(1, &mInstanceVbo);
+  glBindBuffer(GL_ARRAY_BUFFER, mInstanceVbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(TileInstance) * nTileCount, nullptr,
+               GL_DYNAMIC_DRAW);
+  glVertexAttribIPointer(
+      1, 1, GL_UNSIGNED_BYTE, sizeof(TileInstance), (void *)0);
+  glVertexAttribDivisor(1, 1);
+  glEnableVertexAttribArray(1);
+  glVertexAttribIPointer(
+      2, 1, GL_UNSIGNED_BYTE, sizeof(TileInstance), (void *)1);
+  glVertexAttribDivisor(2, 1);
+  glEnableVertexAttribArray(2);
+  glBindVertexArray(0);
+}
+
+void BoardRenderer::Upload(TileBatch *batch) {
+  if (batch->mChangedBegin >= batch->mChangedEnd) {
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, mInstanceVbo);
+  int count = batch->mChangedEnd - batch->mChangedBegin;
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(TileInstance) * batch->mChangedBegin,
+                  sizeof(TileInstance) * count,
+                  &batch->mInstances[batch->mChangedBegin]);
+  batch->ClearChanged();
+}
+
+void BoardRenderer::Draw(float cameraHeight, float cameraX, float cameraY,
+                         const ActiveCells &active) const {
+  // Match the orthographic camera that the rest of the scene is drawn with.
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  float aspect = (float)viewport[2] / (float)viewport[3];
+  float scaleY = 2.0f / cameraHeight;
+  float scaleX = scaleY / aspect;
+  glUseProgram(mProgram);
+  glUniform4f(mViewLoc, scaleX, scaleY, -cameraX * scaleX, -cameraY * scaleY);
+  glUniform3fv(mActiveCellsLoc, 8, &active.mCells[0][0]);
+  glBindVertexArray(mVao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, nTileCount);
+  glBindVertexArray(0);
+}
+
+} // namespace View
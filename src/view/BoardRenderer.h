@@ -0,0 +1,31 @@
+#ifndef view_BoardRenderer_h
+#define view_BoardRenderer_h
+
+#include "view/TileBatch.h"
+
+namespace View {
+
+// Compile and link a program from the sources of its shaders. Errors abort.
+unsigned int CreateProgram(
+    const char *vertexSource, const char *fragmentSource);
+
+// Draws a TileBatch with one instanced draw call. The tile positions and the
+// palette live in the shader, so the only per frame data is the part of the
+// instance array that changed and the positions of the ghost and active tiles.
+struct BoardRenderer {
+  unsigned int mProgram;
+  unsigned int mVao;
+  unsigned int mCornerVbo;
+  unsigned int mInstanceVbo;
+  int mViewLoc;
+  int mActiveCellsLoc;
+
+  void Init();
+  void Upload(TileBatch *batch);
+  void Draw(float cameraHeight, float cameraX, float cameraY,
+            const ActiveCells &active) const;
+};
+
+} // namespace View
+
+#endif
@@ -0,0 +1,130 @@
+#include "view/TileBatch.h"
+
+namespace View {
+
+void TileBatch::Build(const Core::Game &game) {
+  ClearChanged();
+  for (int i = 0; i < Core::Board::nVisibleHeight; ++i) {
+    for (int j = 0; j < Core::Board::nWidth; ++j) {
+      int tile = i * Core::Board::nWidth + j;
+      SetTile(tile, game.mBoard.Type(i + Core::Board::nBufferRows, j));
+    }
+  }
+  for (int i = 0; i < nQueueSlotCount; ++i) {
+    SetQueueSlot(i, game.Preview(i));
+  }
+  for (int i = 0; i < 8; ++i) {
+    SetTile(nGhostTileStart + i, game.mActiveTetrimino);
+  }
+}
+
+void TileBatch::Update(const Core::Game &game, const Core::DirtySet &dirty) {
+  for (int i = 0; i < Core::Board::nVisibleHeight; ++i) {
+    int row = i + Core::Board::nBufferRows;
+    if (!dirty.RowDirty(row)) {
+      continue;
+    }
+    for (int j = 0; j < Core::Board::nWidth; ++j) {
+      if (dirty.CellDirty(row, j)) {
+        SetTile(i * Core::Board::nWidth + j, game.mBoard.Type(row, j));
+      }
+    }
+  }
+  for (int i = 0; i < nQueueSlotCount; ++i) {
+    if (dirty.QueueSlotDirty(i)) {
+      SetQueueSlot(i, game.Preview(i));
+    }
+  }
+  SetActive(game.mActiveTetrimino);
+}
+
+void TileBatch::CopyFrom(const TileBatch &other) {
+  for (int i = 0; i < nTileCount; ++i) {
+    const TileInstance &instance = other.mInstances[i];
+    if (mInstances[i].mTile != instance.mTile ||
+        mInstances[i].mPalette != instance.mPalette) {
+      SetTile(i, (Core::Tetrimino)instance.mPalette);
+    }
+  }
+}
+
+void TileBatch::ClearChanged() {
+  mChangedBegin = nTileCount;
+  mChangedEnd = 0;
+}
+
+void TileBatch::SetTile(int tile, Core::Tetrimino tetrimino) {
+  TileInstance &instance = mInstances[tile];
+  instance.mTile = (unsigned char)tile;
+  instance.mPalette = (unsigned char)tetrimino;
+  mChangedBegin = tile < mChangedBegin ? tile : mChangedBegin;
+  mChangedEnd = tile + 1 > mChangedEnd ? tile + 1 : mChangedEnd;
+}
+
+void TileBatch::SetQueueSlot(int slot, Core::Tetrimino tetrimino) {
+  const Core::Shape &shape = Core::GetShape(tetrimino, 0);
+  int firstTile = nQueueTileStart + slot * 16;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      Core::Tetrimino cellType =
+          shape.Filled(i, j) ? tetrimino : Core::Tetrimino::None;
+      SetTile(firstTile + i * 4 + j, cellType);
+    }
+  }
+}
+
+void TileBatch::SetActive(Core::Tetrimino tetrimino) {
+  if (mInstances[nActiveTileStart].mPalette == (unsigned char)tetrimino) {
+    return;
+  }
+  for (int i = 0; i < 8; ++i) {
+    SetTile(nGhostTileStart + i, tetrimino);
+  }
+}
+
+void ActivePose::Capture(const Core::Game &game) {
+  mTetrimino = game.mActiveTetrimino;
+  mRotation = game.mShapeRotation;
+  mX = game.mActiveX;
+  mY = game.mActiveY;
+  mGhostY = mTetrimino == Core::Tetrimino::None ? mY : game.GhostY();
+}
+
+void BlendActive(const ActivePose &previous, const ActivePose &current,
+                 float alpha, ActiveCells *active) {
+  for (int i = 0; i < 8; ++i) {
+    active->mCells[i][2] = 0.0f;
+  }
+  if (current.mTetrimino == Core::Tetrimino::None) {
+    return;
+  }
+  float x = (float)current.mX;
+  float y = (float)current.mY;
+  if (previous.mTetrimino == current.mTetrimino &&
+      previous.mRotation == current.mRotation) {
+    x = (float)previous.mX + (float)(current.mX - previous.mX) * alpha;
+    y = (float)previous.mY + (float)(current.mY - previous.mY) * alpha;
+  }
+  const Core::Shape &shape =
+      Core::GetShape(current.mTetrimino, current.mRotation);
+  int cell = 0;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      if (!shape.Filled(i, j)) {
+        continue;
+      }
+      int ghostRow = current.mGhostY + i;
+      bool ghostVisible = ghostRow >= Core::Board::nBufferRows;
+      active->mCells[cell][0] = (float)(current.mX + j);
+      active->mCells[cell][1] = (float)(ghostRow - Core::Board::nBufferRows);
+      active->mCells[cell][2] = ghostVisible ? 1.0f : 0.0f;
+      active->mCells[cell + 4][0] = x + (float)j;
+      active->mCells[cell + 4][1] = y + (float)(i - Core::Board::nBufferRows);
+      bool visible = current.mY + i >= Core::Board::nBufferRows;
+      active->mCells[cell + 4][2] = visible ? 1.0f : 0.0f;
+      ++cell;
+    }
+  }
+}
+
+} // namespace View
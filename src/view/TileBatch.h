@@ -0,0 +1,86 @@
+#ifndef view_TileBatch_h
+#define view_TileBatch_h
+
+#include "core/Game.h"
+
+// The board and the queue are drawn as a single batch of tiles. The batch is a
+// packed array with one instance per tile that names the tile and the palette
+// entry it is drawn with. Building the batch does not touch the engine or the
+// graphics api, so its bytes can be checked headless.
+namespace View {
+
+// Tiles [0, nBoardTileCount) are the locked cells of the visible grid in row
+// major order. The 16 cells of each displayed queue slot follow them. The last
+// eight tiles are the cells of the ghost, which shows where the active
+// tetrimino lands, and the cells of the active tetrimino. Their positions are
+// given to the renderer every frame, so the tetrimino can be drawn between
+// cells while it moves from one step to the next. The active tiles come last
+// so that they are drawn over the ghost.
+constexpr int nQueueSlotCount = 3;
+constexpr int nBoardTileCount =
+    Core::Board::nVisibleHeight * Core::Board::nWidth;
+constexpr int nQueueTileStart = nBoardTileCount;
+constexpr int nGhostTileStart = nQueueTileStart + nQueueSlotCount * 16;
+constexpr int nActiveTileStart = nGhostTileStart + 4;
+constexpr int nTileCount = nActiveTileStart + 4;
+static_assert(nTileCount <= 256, "Tile indices must fit in a byte.");
+
+// The palette entries match the values of Core::Tetrimino and the last entry
+// is used for empty cells.
+constexpr int nPaletteSize = (int)Core::Tetrimino::None + 1;
+
+struct TileInstance {
+  unsigned char mTile;
+  unsigned char mPalette;
+};
+static_assert(sizeof(TileInstance) == 2, "TileInstance must be packed.");
+
+struct TileBatch {
+  TileInstance mInstances[nTileCount];
+
+  // The range of instances that changed since ClearChanged was last called.
+  // The range is empty when mChangedBegin is not less than mChangedEnd.
+  int mChangedBegin;
+  int mChangedEnd;
+
+  void Build(const Core::Game &game);
+  void Update(const Core::Game &game, const Core::DirtySet &dirty);
+  // Take the instances of a batch that was built elsewhere, such as on the
+  // simulation thread. Only the instances that differ are added to the
+  // changed range.
+  void CopyFrom(const TileBatch &other);
+  void ClearChanged();
+  void SetTile(int tile, Core::Tetrimino tetrimino);
+  void SetQueueSlot(int slot, Core::Tetrimino tetrimino);
+  void SetActive(Core::Tetrimino tetrimino);
+};
+
+// The active tetrimino as it was after a step and the row it would land on.
+struct ActivePose {
+  Core::Tetrimino mTetrimino;
+  int mRotation;
+  int mX;
+  int mY;
+  int mGhostY;
+
+  void Capture(const Core::Game &game);
+};
+
+// Where the ghost and active tiles are drawn, in the order of the tiles. Every
+// cell is a column and a row of the visible grid followed by a scale. Hidden
+// cells have a scale of zero.
+struct ActiveCells {
+  float mCells[8][3];
+};
+
+// Place the active tiles between the poses before and after the most recent
+// step. An alpha of zero gives the earlier pose and an alpha of one gives the
+// later pose. Poses of different tetriminos or rotations are not blended and
+// cells are hidden while they are above the visible grid. The ghost is placed
+// where the later pose lands without blending.
+void BlendActive(const ActivePose &previous, const ActivePose &current,
+                 float alpha, ActiveCells *active);
+
+} // namespace View
+
+#endif
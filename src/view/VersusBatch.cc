@@ -0,0 +1,89 @@
+#include "view/VersusBatch.h"
+
+namespace View {
+
+void VersusLayout::Fit(int playerCount, float aspect) {
+  const float tileWidth = (float)(Core::Board::nWidth + 1);
+  const float tileHeight = (float)(Core::Board::nVisibleHeight + 1);
+  float bestHeight = 0.0f;
+  for (int columns = 1; columns <= playerCount; ++columns) {
+    int rows = (playerCount + columns - 1) / columns;
+    float width = (float)columns * tileWidth - 1.0f;
+    float height = (float)rows * tileHeight - 1.0f;
+    // The height of the view that fits the tiling.
+    float viewHeight = width / aspect > height ? width / aspect : height;
+    if (columns == 1 || viewHeight < bestHeight) {
+      bestHeight = viewHeight;
+      mColumns = columns;
+      mRows = rows;
+      mWidth = width;
+      mHeight = height;
+    }
+  }
+}
+
+void VersusBatch::Build(Core::Versus *versus) {
+  ClearChanged();
+  memset(mPlane, Core::Versus::nEmptyCell, sizeof(mPlane));
+  for (int p = 0; p < versus->mPlayerCount; ++p) {
+    ComposeBoard(*versus, p);
+    versus->mBoardDirty[p] = false;
+  }
+}
+
+void VersusBatch::Update(Core::Versus *versus) {
+  for (int p = 0; p < versus->mPlayerCount; ++p) {
+    bool moved = versus->mActive[p] != mComposedTetrimino[p] ||
+                 versus->mRotation[p] != mComposedRotation[p] ||
+                 versus->mX[p] != mComposedX[p] ||
+                 versus->mY[p] != mComposedY[p];
+    if (!versus->mBoardDirty[p] && !moved) {
+      continue;
+    }
+    ComposeBoard(*versus, p);
+    versus->mBoardDirty[p] = false;
+  }
+}
+
+void VersusBatch::ComposeBoard(const Core::Versus &versus, int player) {
+  int firstRow = (player / nPlaneColumns) * Core::Board::nVisibleHeight;
+  int firstColumn = (player % nPlaneColumns) * Core::Board::nWidth;
+  for (int i = 0; i < Core::Board::nVisibleHeight; ++i) {
+    memcpy(&mPlane[firstRow + i][firstColumn],
+           versus.mCells[player][i + Core::Board::nBufferRows],
+           Core::Board::nWidth);
+  }
+
+  // The active tetrimino is drawn into the plane with the locked cells.
+  Core::Tetrimino active = versus.mActive[player];
+  if (active != Core::Tetrimino::None) {
+    const Core::Shape &shape = versus.ActiveShape(player);
+    for (int i = shape.mMinRow; i <= shape.mMaxRow; ++i) {
+      int row = versus.mY[player] + i - Core::Board::nBufferRows;
+      if (row < 0) {
+        continue;
+      }
+      for (int j = shape.mMinColumn; j <= shape.mMaxColumn; ++j) {
+        if (shape.Filled(i, j)) {
+          int column = versus.mX[player] + j;
+          mPlane[firstRow + row][firstColumn + column] = (unsigned char)active;
+        }
+      }
+    }
+  }
+  mComposedTetrimino[player] = active;
+  mComposedRotation[player] = versus.mRotation[player];
+  mComposedX[player] = versus.mX[player];
+  mComposedY[player] = versus.mY[player];
+
+  int lastRow = firstRow + Core::Board::nVisibleHeight;
+  mChangedBegin = firstRow < mChangedBegin ? firstRow : mChangedBegin;
+  mChangedEnd = lastRow > mChangedEnd ? lastRow : mChangedEnd;
+}
+
+void VersusBatch::ClearChanged() {
+  mChangedBegin = nPlaneHeight;
+  mChangedEnd = 0;
+}
+
+} // namespace View
@@ -0,0 +1,65 @@
+#ifndef view_VersusBatch_h
+#define view_VersusBatch_h
+
+#include "core/Versus.h"
+
+// Every board of a versus match is drawn from one plane of cells that is
+// uploaded as a texture, so the number of boards only changes how many quads
+// are drawn. Like TileBatch, the plane is built without touching the engine or
+// the graphics api.
+namespace View {
+
+// The boards are packed into the plane in rows of nPlaneColumns boards. Cell
+// (row, column) of a board's visible grid is the texel at the board's corner
+// plus (column, row).
+constexpr int nPlaneColumns = 16;
+constexpr int nPlaneRows = Core::Versus::nMaxPlayers / nPlaneColumns;
+constexpr int nPlaneWidth = nPlaneColumns * Core::Board::nWidth;
+constexpr int nPlaneHeight = nPlaneRows * Core::Board::nVisibleHeight;
+static_assert(
+    Core::Versus::nMaxPlayers % nPlaneColumns == 0,
+    "Every row of the plane must be full.");
+
+// The palette of a versus board. The first entries match the values of
+// Core::Tetrimino, which are followed by empty and garbage cells.
+constexpr int nVersusPaletteSize = Core::Versus::nGarbageCell + 1;
+
+// Where boards are drawn. Boards are tiled in mColumns columns with a cell of
+// space between neighbours, and the tiling is centered on the origin. The
+// width and height are the size of the tiling.
+struct VersusLayout {
+  int mColumns;
+  int mRows;
+  float mWidth;
+  float mHeight;
+
+  // Choose the columns that let the tiling be shown the largest in a view of
+  // the given aspect ratio.
+  void Fit(int playerCount, float aspect);
+};
+
+struct VersusBatch {
+  unsigned char mPlane[nPlaneHeight][nPlaneWidth];
+
+  // The active tetrimino each board was composed with.
+  Core::Tetrimino mComposedTetrimino[Core::Versus::nMaxPlayers];
+  int mComposedRotation[Core::Versus::nMaxPlayers];
+  int mComposedX[Core::Versus::nMaxPlayers];
+  int mComposedY[Core::Versus::nMaxPlayers];
+
+  // The rows of the plane that changed since ClearChanged was last called.
+  // The range is empty when mChangedBegin is not less than mChangedEnd.
+  int mChangedBegin;
+  int mChangedEnd;
+
+  // Build composes every board. Update composes the boards whose cells are
+  // dirty or whose active tetrimino moved and clears their dirty marks.
+  void Build(Core::Versus *versus);
+  void Update(Core::Versus *versus);
+  void ComposeBoard(const Core::Versus &versus, int player);
+  void ClearChanged();
+};
+
+} // namespace View
+
+#endif
@@ -0,0 +1,133 @@
+#include <glad/glad.h>
+
+#include "view/BoardRenderer.h"
+#include "view/VersusRenderer.h"
+
+namespace View {
+
+const char *nVersusVertexSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+
+uniform vec4 uView;
+uniform vec4 uLayout;
+uniform uvec2 uGridSize;
+
+out vec2 vCell;
+flat out uint vPlayer;
+
+void main() {
+  // The tiles of the layout are a cell larger than the grid in both
+  // directions, which leaves a gap between neighbouring boards.
+  uint player = uint(gl_InstanceID);
+  uint columns = uint(uLayout.x);
+  vec2 tile = vec2(float(player % columns), float(player / columns));
+  vec2 tileSize = vec2(uGridSize) + vec2(1.0);
+  vec2 corner =
+      vec2(-uLayout.z, uLayout.w) * 0.5 + vec2(tile.x, -tile.y) * tileSize;
+  vec2 world = corner + vec2(aCorner.x, -aCorner.y) * vec2(uGridSize);
+  gl_Position = vec4(world * uView.xy + uView.zw, 0.0, 1.0);
+  vCell = aCorner * vec2(uGridSize);
+  vPlayer = player;
+}
+)";
+
+const char *nVersusFragmentSource = R"(
+#version 330 core
+in vec2 vCell;
+flat in uint vPlayer;
+
+uniform usampler2D uPlane;
+uniform uvec2 uGridSize;
+uniform uint uPlaneColumns;
+
+out vec4 oColor;
+
+const vec4 cPalette[9] = vec4[9](
+  vec4(0.0, 1.0, 1.0, 1.0),
+  vec4(1.0, 0.5, 0.0, 1.0),
+  vec4(0.0, 0.0, 1.0, 1.0),
+  vec4(1.0, 1.0, 0.0, 1.0),
+  vec4(0.0, 1.0, 0.0, 1.0),
+  vec4(1.0, 0.0, 1.0, 1.0),
+  vec4(1.0, 0.0, 0.0, 1.0),
+  vec4(0.5, 0.5, 0.5, 1.0),
+  vec4(0.8, 0.8, 0.8, 1.0));
+
+void main() {
+  // Leave the same gap around every cell as the tiles of the main board.
+  vec2 inCell = fract(vCell);
+  if (any(lessThan(inCell, vec2(0.05))) ||
+      any(greaterThan(inCell, vec2(0.95)))) {
+    discard;
+  }
+  uvec2 cell = min(uvec2(vCell), uGridSize - uvec2(1u));
+  uvec2 board = uvec2(vPlayer % uPlaneColumns, vPlayer / uPlaneColumns);
+  uint value = texelFetch(uPlane, ivec2(board * uGridSize + cell), 0).r;
+  oColor = cPalette[value];
+}
+)";
+
+void VersusRenderer::Init() {
+  mProgram = CreateProgram(nVersusVertexSource, nVersusFragmentSource);
+  glUseProgram(mProgram);
+  glUniform2ui(glGetUniformLocation(mProgram, "uGridSize"),
+               Core::Board::nWidth, Core::Board::nVisibleHeight);
+  glUniform1ui(glGetUniformLocation(mProgram, "uPlaneColumns"), nPlaneColumns);
+  glUniform1i(glGetUniformLocation(mProgram, "uPlane"), 0);
+  mViewLoc = glGetUniformLocation(mProgram, "uView");
+  mLayoutLoc = glGetUniformLocation(mProgram, "uLayout");
+
+  // A board is a quad from its top left corner to its bottom right corner.
+  float corners[4][2] = {
+      {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}};
+  glGenVertexArrays(1, &mVao);
+  glBindVertexArray(mVao);
+  glGenBuffers(1, &mCornerVbo);
+  glBindBuffer(GL_ARRAY_BUFFER, mCornerVbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(0);
+  glBindVertexArray(0);
+
+  // The plane is uploaded in place as boards change.
+  glGenTextures(1, &mPlaneTexture);
+  glBindTexture(GL_TEXTURE_2D, mPlaneTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, nPlaneWidth, nPlaneHeight, 0,
+               GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+}
+
+void VersusRenderer::Upload(VersusBatch *batch) {
+  if (batch->mChangedBegin >= batch->mChangedEnd) {
+    return;
+  }
+  glBindTexture(GL_TEXTURE_2D, mPlaneTexture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  int rows = batch->mChangedEnd - batch->mChangedBegin;
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, batch->mChangedBegin, nPlaneWidth, rows,
+                  GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                  batch->mPlane[batch->mChangedBegin]);
+  batch->ClearChanged();
+}
+
+void VersusRenderer::Draw(float cameraHeight, float cameraX, float cameraY,
+                          const VersusLayout &layout, int playerCount) const {
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  float aspect = (float)viewport[2] / (float)viewport[3];
+  float scaleY = 2.0f / cameraHeight;
+  float scaleX = scaleY / aspect;
+  glUseProgram(mProgram);
+  glUniform4f(mViewLoc, scaleX, scaleY, -cameraX * scaleX, -cameraY * scaleY);
+  glUniform4f(mLayoutLoc, (float)layout.mColumns, (float)layout.mRows,
+              layout.mWidth, layout.mHeight);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, mPlaneTexture);
+  glBindVertexArray(mVao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, playerCount);
+  glBindVertexArray(0);
+}
+
+} // namespace View
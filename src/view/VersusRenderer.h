@@ -0,0 +1,27 @@
+#ifndef view_VersusRenderer_h
+#define view_VersusRenderer_h
+
+#include "view/VersusBatch.h"
+
+namespace View {
+
+// Draws the boards of a VersusBatch with one instanced draw call of a quad per
+// board. The cells of the boards are read from the plane in the fragment
+// shader, so the only per frame data is the band of the plane that changed.
+struct VersusRenderer {
+  unsigned int mProgram;
+  unsigned int mVao;
+  unsigned int mCornerVbo;
+  unsigned int mPlaneTexture;
+  int mViewLoc;
+  int mLayoutLoc;
+
+  void Init();
+  void Upload(VersusBatch *batch);
+  void Draw(float cameraHeight, float cameraX, float cameraY,
+            const VersusLayout &layout, int playerCount) const;
+};
+
+} // namespace View
+
+#endif